@@ -6,6 +6,8 @@
 #include <printk.h>
 
 #include "bsp_drv.h"
+#include "flash.h"
+#include "kconfig.h"
 #include "mpu6500.h"
 #include "pwm.h"
 #include "sbus.h"
@@ -170,4 +172,7 @@ void __board_init(void)
     pwm_init();
     sbus_init();
     mpu6500_init();
+#if (FLASH_LOGFS_SECTORS != 0)
+    flash_init();
+#endif
 }
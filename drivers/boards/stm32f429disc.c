@@ -6,6 +6,8 @@
 #include <printk.h>
 
 #include "bsp_drv.h"
+#include "flash.h"
+#include "kconfig.h"
 #include "stm32f429i_discovery_ioe.h"
 #include "stm32f429i_discovery_lcd.h"
 #include "stm32f4xx_gpio.h"
@@ -136,4 +138,7 @@ void __board_init(void)
     serial2_init(115200, "mavlink", "mavlink (alias: serial1)");
     serial3_init(115200, "dbglink", "debug-link (alias: serial2)");
     led_init();
+#if (FLASH_LOGFS_SECTORS != 0)
+    flash_init();
+#endif
 }
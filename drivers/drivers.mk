@@ -6,5 +6,6 @@ CFLAGS += -I $(PROJ_ROOT)/drivers/periph
 SRC += $(PROJ_ROOT)/drivers/periph/uart.c
 SRC += $(PROJ_ROOT)/drivers/periph/pwm.c
 SRC += $(PROJ_ROOT)/drivers/periph/spi.c
+SRC += $(PROJ_ROOT)/drivers/periph/flash.c
 SRC += $(PROJ_ROOT)/drivers/devices/mpu6500.c
 SRC += $(PROJ_ROOT)/drivers/devices/sbus.c
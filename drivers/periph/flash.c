@@ -0,0 +1,129 @@
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <fs/logfs.h>
+#include <kernel/sched.h>
+#include <printk.h>
+
+#include "flash.h"
+#include "kconfig.h"
+#include "stm32f4xx.h"
+
+#define FLASH_SECTOR_SIZE (128 * 1024)
+#define FLASH_BANK_SIZE (1024 * 1024)
+
+/* Provided by the linker script after the program */
+extern char _logfs_start;
+
+static struct logfs flash_logfs;
+
+static inline uint32_t flash_addr(int blk, off_t offset)
+{
+    return (uint32_t) &_logfs_start + blk * FLASH_SECTOR_SIZE + offset;
+}
+
+static uint32_t flash_sector(int blk)
+{
+    /* Only the 128 KiB sectors are used, i.e., sector 5 to 11 of the last
+     * bank */
+    uint32_t offset = flash_addr(blk, 0) - FLASH_BASE;
+    uint32_t bank = offset / FLASH_BANK_SIZE;
+    uint32_t sector = 4 + (offset % FLASH_BANK_SIZE) / FLASH_SECTOR_SIZE;
+
+    /* The sector numbers of the second bank start from 12 with a gap of 4 in
+     * the encoding, e.g., FLASH_Sector_12 = 16 << 3 */
+    return (bank ? sector + 16 : sector) << 3;
+}
+
+static int flash_read(struct flash_dev *dev,
+                      int blk,
+                      off_t offset,
+                      void *buf,
+                      size_t size)
+{
+    /* The flash is memory-mapped */
+    memcpy(buf, (void *) flash_addr(blk, offset), size);
+    return 0;
+}
+
+static int flash_prog(struct flash_dev *dev,
+                      int blk,
+                      off_t offset,
+                      const void *buf,
+                      size_t size)
+{
+    uint32_t addr = flash_addr(blk, offset);
+    int retval = 0;
+
+    FLASH_Unlock();
+    FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR |
+                    FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
+
+    for (size_t i = 0; i < size; i += 4) {
+        uint32_t word;
+        memcpy(&word, (const uint8_t *) buf + i, sizeof(word));
+
+        if (FLASH_ProgramWord(addr + i, word) != FLASH_COMPLETE) {
+            retval = -EIO;
+            break;
+        }
+    }
+
+    FLASH_Lock();
+
+    return retval;
+}
+
+static int flash_erase(struct flash_dev *dev, int blk)
+{
+    int retval = 0;
+
+    FLASH_Unlock();
+    FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR |
+                    FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
+
+    if (FLASH_WaitForLastOperation() != FLASH_COMPLETE) {
+        retval = -EIO;
+        goto leave;
+    }
+
+    /* Start the sector erase as FLASH_EraseSector() does, but let the other
+     * threads run instead of spinning for the seconds it takes. The CPU
+     * still stalls on the access to the bank being erased */
+    FLASH->CR &= ~(FLASH_CR_PSIZE | FLASH_CR_SNB);
+    FLASH->CR |= FLASH_PSIZE_WORD | FLASH_CR_SER | flash_sector(blk);
+    FLASH->CR |= FLASH_CR_STRT;
+
+    FLASH_Status status;
+    while ((status = FLASH_GetStatus()) == FLASH_BUSY)
+        schedule();
+
+    if (status != FLASH_COMPLETE)
+        retval = -EIO;
+
+    FLASH->CR &= ~(FLASH_CR_SER | FLASH_CR_SNB);
+
+leave:
+    FLASH_Lock();
+
+    return retval;
+}
+
+static struct flash_dev flash_dev = {
+    .blk_size = FLASH_SECTOR_SIZE,
+    .blk_cnt = FLASH_LOGFS_SECTORS,
+    .read = flash_read,
+    .prog = flash_prog,
+    .erase = flash_erase,
+};
+
+void flash_init(void)
+{
+    if (logfs_init(&flash_logfs, &flash_dev, "flash") < 0) {
+        pr_err("blkdev flash: failed to initialize");
+        return;
+    }
+
+    printk("blkdev flash: logfs storage");
+}
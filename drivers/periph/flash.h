@@ -0,0 +1,6 @@
+#ifndef __FLASH_H__
+#define __FLASH_H__
+
+void flash_init(void);
+
+#endif
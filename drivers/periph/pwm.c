@@ -26,7 +26,7 @@ int pwm_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
     uint32_t reload = (uint32_t) MICROSEC_TO_RELOAD(width_microsecond);
 
     if (reload > PWM_RELOAD) {
-        printk("ioctl(): pwm setting exceeded maximum value");
+        pr_err("ioctl(): pwm setting exceeded maximum value");
         return -EINVAL;
     }
 
@@ -57,6 +57,42 @@ int uart_puts(USART_TypeDef *uart, const char *data, size_t size)
     return size;
 }
 
+ssize_t uart_putsv(USART_TypeDef *uart, const struct iovec *iov, int iovcnt)
+{
+    ssize_t size = 0;
+    for (int i = 0; i < iovcnt; i++)
+        size += uart_puts(uart, iov[i].iov_base, iov[i].iov_len);
+
+    return size;
+}
+
+static size_t uart_dma_next_segment(uart_dev_t *uart, DMA_Stream_TypeDef *dma)
+{
+    /* Skip the empty segments */
+    while (uart->tx_iovcnt > 0 && uart->tx_iov->iov_len == 0) {
+        uart->tx_iov++;
+        uart->tx_iovcnt--;
+    }
+
+    /* No more segment to send */
+    if (uart->tx_iovcnt == 0)
+        return 0;
+
+    /* Reload the stream with the next segment. The stream is disabled
+     * by the hardware after the last transfer is completed */
+    size_t size = uart->tx_iov->iov_len;
+    DMA_MemoryTargetConfig(dma, (uint32_t) uart->tx_iov->iov_base,
+                           DMA_Memory_0);
+    DMA_SetCurrDataCounter(dma, size);
+    DMA_Cmd(dma, ENABLE);
+
+    uart->tx_size += size;
+    uart->tx_iov++;
+    uart->tx_iovcnt--;
+
+    return size;
+}
+
 /*==============*
  * UART1 driver *
  *==============*/
@@ -85,15 +121,21 @@ static ssize_t uart1_read(struct file *filp,
     return size;
 }
 
-static int uart1_dma_puts(const char *data, size_t size)
+static ssize_t uart1_dma_putsv(const struct iovec *iov, int iovcnt)
 {
     mutex_lock(&uart1.tx_mtx);
 
     preempt_disable();
 
+    /* The segments are chained by the DMA interrupt */
+    uart1.tx_iov = iov;
+    uart1.tx_iovcnt = iovcnt;
+    uart1.tx_size = 0;
+    uart1.tx_ready = false;
+
     /* Configure the DMA */
     DMA_InitTypeDef DMA_InitStructure = {
-        .DMA_BufferSize = (uint32_t) size,
+        .DMA_BufferSize = 0,
         .DMA_FIFOMode = DMA_FIFOMode_Disable,
         .DMA_FIFOThreshold = DMA_FIFOThreshold_Full,
         .DMA_MemoryBurst = DMA_MemoryBurst_Single,
@@ -106,19 +148,26 @@ static int uart1_dma_puts(const char *data, size_t size)
         .DMA_Priority = DMA_Priority_Medium,
         .DMA_Channel = DMA_Channel_4,
         .DMA_DIR = DMA_DIR_MemoryToPeripheral,
-        .DMA_Memory0BaseAddr = (uint32_t) data,
+        .DMA_Memory0BaseAddr = 0,
     };
     DMA_Init(DMA2_Stream7, &DMA_InitStructure);
 
-    /* Enable DMA to copy the data */
+    /* Enable DMA to copy the data of the first segment */
     DMA_ClearFlag(DMA2_Stream7, DMA_FLAG_TCIF7);
     DMA_ITConfig(DMA2_Stream7, DMA_IT_TC, ENABLE);
-    DMA_Cmd(DMA2_Stream7, ENABLE);
+    ssize_t size = uart_dma_next_segment(&uart1, DMA2_Stream7);
+    if (!size) {
+        DMA_ITConfig(DMA2_Stream7, DMA_IT_TC, DISABLE);
+        goto leave;
+    }
 
     /* Wait until DMA completed data transfer */
-    uart1.tx_ready = false;
     wait_event(uart1.tx_wait_list, uart1.tx_ready);
 
+    /* Return the total size of the segments */
+    size = uart1.tx_size;
+
+leave:
     preempt_enable();
 
     mutex_unlock(&uart1.tx_mtx);
@@ -126,6 +175,16 @@ static int uart1_dma_puts(const char *data, size_t size)
     return size;
 }
 
+static ssize_t uart1_dma_puts(const char *data, size_t size)
+{
+    struct iovec iov = {
+        .iov_base = (void *) data,
+        .iov_len = size,
+    };
+
+    return uart1_dma_putsv(&iov, 1);
+}
+
 static ssize_t uart1_write(struct file *filp,
                            const char *buf,
                            size_t size,
@@ -138,9 +197,22 @@ static ssize_t uart1_write(struct file *filp,
 #endif
 }
 
+static ssize_t uart1_write_iter(struct file *filp,
+                                const struct iovec *iov,
+                                int iovcnt,
+                                off_t offset)
+{
+#if (ENABLE_UART1_DMA != 0)
+    return uart1_dma_putsv(iov, iovcnt);
+#else
+    return uart_putsv(USART1, iov, iovcnt);
+#endif
+}
+
 static struct file_operations uart1_file_ops = {
     .read = uart1_read,
     .write = uart1_write,
+    .write_iter = uart1_write_iter,
     .open = uart1_open,
 };
 
@@ -261,6 +333,11 @@ void DMA2_Stream7_IRQHandler(void)
 {
     if (DMA_GetITStatus(DMA2_Stream7, DMA_IT_TCIF7) == SET) {
         DMA_ClearITPendingBit(DMA2_Stream7, DMA_IT_TCIF7);
+
+        /* Continue with the next segment without waking up the writer */
+        if (uart_dma_next_segment(&uart1, DMA2_Stream7))
+            return;
+
         DMA_ITConfig(DMA2_Stream7, DMA_IT_TC, DISABLE);
 
         uart1.tx_ready = true;
@@ -304,9 +381,18 @@ static ssize_t uart2_write(struct file *filp,
     return uart_puts(USART2, buf, size);
 }
 
+static ssize_t uart2_write_iter(struct file *filp,
+                                const struct iovec *iov,
+                                int iovcnt,
+                                off_t offset)
+{
+    return uart_putsv(USART2, iov, iovcnt);
+}
+
 static struct file_operations uart2_file_ops = {
     .read = uart2_read,
     .write = uart2_write,
+    .write_iter = uart2_write_iter,
     .open = uart2_open,
 };
 
@@ -419,15 +505,21 @@ static ssize_t uart3_read(struct file *filp,
     return size;
 }
 
-static int uart3_dma_puts(const char *data, size_t size)
+static ssize_t uart3_dma_putsv(const struct iovec *iov, int iovcnt)
 {
     mutex_lock(&uart3.tx_mtx);
 
     preempt_disable();
 
+    /* The segments are chained by the DMA interrupt */
+    uart3.tx_iov = iov;
+    uart3.tx_iovcnt = iovcnt;
+    uart3.tx_size = 0;
+    uart3.tx_ready = false;
+
     /* Configure the DMA */
     DMA_InitTypeDef DMA_InitStructure = {
-        .DMA_BufferSize = (uint32_t) size,
+        .DMA_BufferSize = 0,
         .DMA_FIFOMode = DMA_FIFOMode_Disable,
         .DMA_FIFOThreshold = DMA_FIFOThreshold_Full,
         .DMA_MemoryBurst = DMA_MemoryBurst_Single,
@@ -440,19 +532,26 @@ static int uart3_dma_puts(const char *data, size_t size)
         .DMA_Priority = DMA_Priority_Medium,
         .DMA_Channel = DMA_Channel_7,
         .DMA_DIR = DMA_DIR_MemoryToPeripheral,
-        .DMA_Memory0BaseAddr = (uint32_t) data,
+        .DMA_Memory0BaseAddr = 0,
     };
     DMA_Init(DMA1_Stream4, &DMA_InitStructure);
 
-    /* Enable DMA to copy the data */
+    /* Enable DMA to copy the data of the first segment */
     DMA_ClearFlag(DMA1_Stream4, DMA_FLAG_TCIF4);
     DMA_ITConfig(DMA1_Stream4, DMA_IT_TC, ENABLE);
-    DMA_Cmd(DMA1_Stream4, ENABLE);
+    ssize_t size = uart_dma_next_segment(&uart3, DMA1_Stream4);
+    if (!size) {
+        DMA_ITConfig(DMA1_Stream4, DMA_IT_TC, DISABLE);
+        goto leave;
+    }
 
     /* Wait until DMA complete data transfer */
-    uart3.tx_ready = false;
     wait_event(uart3.tx_wait_list, uart3.tx_ready);
 
+    /* Return the total size of the segments */
+    size = uart3.tx_size;
+
+leave:
     preempt_enable();
 
     mutex_unlock(&uart3.tx_mtx);
@@ -460,6 +559,16 @@ static int uart3_dma_puts(const char *data, size_t size)
     return size;
 }
 
+static ssize_t uart3_dma_puts(const char *data, size_t size)
+{
+    struct iovec iov = {
+        .iov_base = (void *) data,
+        .iov_len = size,
+    };
+
+    return uart3_dma_putsv(&iov, 1);
+}
+
 static ssize_t uart3_write(struct file *filp,
                            const char *buf,
                            size_t size,
@@ -472,9 +581,22 @@ static ssize_t uart3_write(struct file *filp,
 #endif
 }
 
+static ssize_t uart3_write_iter(struct file *filp,
+                                const struct iovec *iov,
+                                int iovcnt,
+                                off_t offset)
+{
+#if (ENABLE_UART3_DMA != 0)
+    return uart3_dma_putsv(iov, iovcnt);
+#else
+    return uart_putsv(USART3, iov, iovcnt);
+#endif
+}
+
 static struct file_operations uart3_file_ops = {
     .read = uart3_read,
     .write = uart3_write,
+    .write_iter = uart3_write_iter,
     .open = uart3_open,
 };
 
@@ -592,6 +714,11 @@ void DMA1_Stream4_IRQHandler(void)
 {
     if (DMA_GetITStatus(DMA1_Stream4, DMA_IT_TCIF4) == SET) {
         DMA_ClearITPendingBit(DMA1_Stream4, DMA_IT_TCIF4);
+
+        /* Continue with the next segment without waking up the writer */
+        if (uart_dma_next_segment(&uart3, DMA1_Stream4))
+            return;
+
         DMA_ITConfig(DMA1_Stream4, DMA_IT_TC, DISABLE);
 
         uart3.tx_ready = true;
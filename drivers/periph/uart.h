@@ -4,6 +4,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <sys/uio.h>
 
 #include <kernel/kernel.h>
 #include <kernel/kfifo.h>
@@ -17,6 +18,9 @@ typedef struct {
     wait_queue_head_t tx_wait_list;
     struct mutex tx_mtx;
     bool tx_ready;
+    const struct iovec *tx_iov; /* Segments left to send with the DMA */
+    int tx_iovcnt;
+    size_t tx_size; /* Size of the segments sent with the DMA */
     void (*tx_callback)(void);
 
     /* Rx */
@@ -30,6 +34,7 @@ typedef struct {
 void uart_putc(USART_TypeDef *uart, char c);
 char uart_getc(USART_TypeDef *uart);
 int uart_puts(USART_TypeDef *uart, const char *data, size_t size);
+ssize_t uart_putsv(USART_TypeDef *uart, const struct iovec *iov, int iovcnt);
 
 void uart2_init(uint32_t baudrate, void (*rx_callback)(uint8_t c));
 
@@ -5,6 +5,7 @@
 #define __PORT_H__
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #define NACKED __attribute__((naked))
@@ -19,6 +20,14 @@
 
 #define SAVE_SYSCALL_RETVAL(ptr) asm volatile("mov %0, r0" : "=r"(*ptr));
 
+/* Size of the memory reserved at the bottom of the thread stack for the
+ * stack guard. Syscalls are executed on the thread stack with the guard
+ * enabled, hence the kernel must not access this area either */
+#define STACK_GUARD_SIZE 64 /* Bytes */
+
+/* Number of the MPU regions reserved for the user memory mappings */
+#define MPU_USER_REGION_CNT 4
+
 void system_ticks_update(void);
 
 /**
@@ -76,6 +85,45 @@ void __stack_init(uint32_t **stack_top,
                   uint32_t return_handler,
                   uint32_t args[4]);
 
+/**
+ * @brief  Protect the lowest part of the thread stack to trap stack overflow
+ *         before jumping to the thread
+ * @param  stack: The base address of the thread stack.
+ * @retval None
+ */
+void __stack_guard_enable(void *stack);
+
+/**
+ * @brief  Remove the stack guard after returning to the kernel
+ * @param  None
+ * @retval None
+ */
+void __stack_guard_disable(void);
+
+/**
+ * @brief  Restrict the access of the unprivileged thread to a memory range
+ *         with one of the MPU regions reserved for the user
+ * @param  idx: The index of the user region, i.e., 0 to MPU_USER_REGION_CNT-1.
+ * @param  base: The base address of the range, which must be aligned to size.
+ * @param  size: The size of the range in bytes, which must be a power of two
+ *         and not smaller than 32.
+ * @param  readable: The range can be read by the thread.
+ * @param  writable: The range can be written by the thread.
+ * @retval None
+ */
+void __mpu_user_region_enable(int idx,
+                              void *base,
+                              size_t size,
+                              bool readable,
+                              bool writable);
+
+/**
+ * @brief  Disable the MPU region reserved for the user
+ * @param  idx: The index of the user region.
+ * @retval None
+ */
+void __mpu_user_region_disable(int idx);
+
 /**
  * @brief  Get syscall number
  * @param  sp: The stack pointer points to the top of the thread stack.
@@ -83,6 +131,14 @@ void __stack_init(uint32_t **stack_top,
  */
 unsigned long get_syscall_num(void *sp);
 
+/**
+ * @brief  Get the return address of the syscall, i.e., the call site of
+ *         the syscall wrapper function
+ * @param  sp: The stack pointer points to the top of the thread stack.
+ * @retval unsigned long: The return address of the syscall.
+ */
+unsigned long get_syscall_caller(void *sp);
+
 /**
  * @brief  Get syscall arguments
  * @param  sp: The stack pointer points to the top of the thread stack.
@@ -91,6 +147,23 @@ unsigned long get_syscall_num(void *sp);
  */
 void get_syscall_args(void *sp, unsigned long *pargs[4]);
 
+/**
+ * @brief  Pop the first node of an intrusive singly linked list atomically
+ * @param  head: Pointer to the list head, the first word of each node
+ *         must be the pointer to the next node.
+ * @retval void *: The popped node, or NULL if the list is empty.
+ */
+void *atomic_list_pop(void **head);
+
+/**
+ * @brief  Push a node to an intrusive singly linked list atomically
+ * @param  head: Pointer to the list head.
+ * @param  node: The node to push, the first word of the node is overwritten
+ *         with the pointer to the next node.
+ * @retval None
+ */
+void atomic_list_push(void **head, void *node);
+
 /**
  * @brief  Halt the system by trapping into an infinity loop
  * @param  None
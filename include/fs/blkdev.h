@@ -0,0 +1,122 @@
+/**
+ * @file
+ */
+#ifndef __BLKDEV_H__
+#define __BLKDEV_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#include <common/list.h>
+#include <fs/fs.h>
+
+#define BLK_READ 0
+#define BLK_WRITE 1
+
+struct blk_request {
+    int dir;                   /* BLK_READ or BLK_WRITE */
+    off_t offset;              /* Device offset in bytes */
+    size_t size;               /* Size of this segment in bytes */
+    size_t total;              /* Size including the merged segments */
+    char *buf;                 /* Buffer of this segment */
+    int status;                /* -EINPROGRESS until completion */
+    void *private;             /* Data of the submitter */
+    void (*end_io)(struct blk_request *req);
+    struct list_head list;     /* Entry of the queue or the merged chain */
+    struct list_head segments; /* Requests merged behind this one */
+};
+
+struct blk_dev {
+    struct file file; /* Block device file */
+    size_t size;      /* Capacity in bytes */
+    size_t max_size;  /* Max size of a merged request in bytes */
+    int max_inflight; /* Requests the driver can process at once */
+    /* Start the transfer of the request and its merged segments, which are
+     * contiguous on the device. The driver owns the list member of the
+     * request until calling blk_end_request(), or returns a negative error
+     * number */
+    int (*submit)(struct blk_dev *dev, struct blk_request *req);
+
+    struct list_head queue;     /* Pending requests sorted by offset */
+    struct list_head wait_list; /* Threads waiting for completions */
+    int inflight;               /* Requests being processed by the driver */
+    int plug_cnt;               /* Dispatch is held while nonzero */
+    bool dispatching;           /* Submit function is being called */
+};
+
+/**
+ * @brief  Register the block device as /dev/<name>. Reading or writing the
+ *         device file goes through the request queue of the device
+ * @param  name: The name of the block device.
+ * @param  dev: The block device with size, max_size, max_inflight and submit
+ *         set by the driver.
+ * @retval int: 0 on success and negative error number on error.
+ */
+int blkdev_register(char *name, struct blk_dev *dev);
+
+/**
+ * @brief  Get the block device of the device file
+ * @param  filp: The device file.
+ * @retval struct blk_dev *: The block device or NULL if the file is not a
+ *         block device registered by blkdev_register().
+ */
+struct blk_dev *blkdev_from_file(struct file *filp);
+
+/**
+ * @brief  Queue the request without waiting. The request is merged with the
+ *         pending request adjacent to it if possible, and end_io is called
+ *         after completion, possibly in the interrupt context
+ * @param  dev: The block device.
+ * @param  req: The request with dir, offset, size, buf and optional end_io
+ *         and private set. The memory must be valid until completion.
+ * @retval None
+ */
+void blk_submit(struct blk_dev *dev, struct blk_request *req);
+
+/**
+ * @brief  Hold the dispatch of the queue so the requests submitted together
+ *         can be merged before reaching the driver
+ * @param  dev: The block device.
+ * @retval None
+ */
+void blk_plug(struct blk_dev *dev);
+
+/**
+ * @brief  Release the dispatch held by blk_plug()
+ * @param  dev: The block device.
+ * @retval None
+ */
+void blk_unplug(struct blk_dev *dev);
+
+/**
+ * @brief  Complete the request passed to the submit function. Called by the
+ *         driver
+ * @param  dev: The block device.
+ * @param  req: The request given to the submit function.
+ * @param  status: 0 on success and negative error number on error.
+ * @retval None
+ */
+void blk_end_request(struct blk_dev *dev, struct blk_request *req, int status);
+
+/**
+ * @brief  Sleep until the request is completed. Must not be called with the
+ *         preemption disabled
+ * @param  dev: The block device.
+ * @param  req: The submitted request.
+ * @retval int: The completion status of the request.
+ */
+int blk_wait(struct blk_dev *dev, struct blk_request *req);
+
+/**
+ * @brief  Read or write the block device and wait for the completion
+ * @param  dev: The block device.
+ * @param  dir: BLK_READ or BLK_WRITE.
+ * @param  buf: The buffer for the transfer.
+ * @param  size: The size of the transfer in bytes.
+ * @param  offset: The device offset in bytes.
+ * @retval int: 0 on success and negative error number on error.
+ */
+int blk_rw(struct blk_dev *dev, int dir, char *buf, size_t size, off_t offset);
+
+#endif
@@ -0,0 +1,73 @@
+/**
+ * @file
+ */
+#ifndef __BUFFER_H__
+#define __BUFFER_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <fs/fs.h>
+
+struct bcache_stat {
+    uint32_t hits;       /* Accesses served by the cached blocks */
+    uint32_t misses;     /* Accesses that read the block from the device */
+    uint32_t writebacks; /* Dirty blocks written to the device */
+    uint32_t dirty;      /* Dirty blocks in the cache */
+};
+
+/**
+ * @brief  Initialize the buffer cache
+ * @param  None
+ * @retval None
+ */
+void bcache_init(void);
+
+/**
+ * @brief  Read the device through the buffer cache. Devices not registered
+ *         with blkdev_register() are read directly with the read operation
+ *         of the device file
+ * @param  dev_file: The device file.
+ * @param  buf: The buffer for returning the data.
+ * @param  size: The size to read in bytes.
+ * @param  offset: The device offset in bytes.
+ * @retval ssize_t: The read size on success and negative error number on
+ *         error.
+ */
+ssize_t bcache_read(struct file *dev_file,
+                    char *buf,
+                    size_t size,
+                    off_t offset);
+
+/**
+ * @brief  Write the device through the buffer cache. The cached blocks are
+ *         only marked as dirty and written to the device on eviction or by
+ *         bcache_sync()
+ * @param  dev_file: The device file.
+ * @param  buf: The data to write.
+ * @param  size: The size to write in bytes.
+ * @param  offset: The device offset in bytes.
+ * @retval ssize_t: The written size on success and negative error number on
+ *         error.
+ */
+ssize_t bcache_write(struct file *dev_file,
+                     const char *buf,
+                     size_t size,
+                     off_t offset);
+
+/**
+ * @brief  Write the dirty blocks of the device to the device
+ * @param  dev_file: The device file, or NULL for all devices.
+ * @retval int: 0 on success and negative error number on error.
+ */
+int bcache_sync(struct file *dev_file);
+
+/**
+ * @brief  Get the statistics of the buffer cache
+ * @param  stat: For returning the statistics.
+ * @retval None
+ */
+void bcache_get_stat(struct bcache_stat *stat);
+
+#endif
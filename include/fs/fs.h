@@ -9,6 +9,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 
 #include <common/list.h>
 #include <kernel/wait.h>
@@ -43,20 +44,11 @@
  * +-----------+---------------+
  *
  * N = THREAD_MAX
- * M = OPEN_MAX
+ * M = OPEN_MAX (per task)
  */
 
 typedef void (*drv_init_func_t)(void);
 
-enum {
-    FS_CREATE_FILE = 1,
-    FS_OPEN_FILE = 2,
-    FS_OPEN_DIR = 3,
-    FS_MOUNT = 4,
-    FS_GET_CWD = 5,
-    FS_CHANGE_DIR = 6,
-} FS_SERVER_CMDS;
-
 struct super_block {
     bool s_rd_only;       /* Read-only flag */
     uint32_t s_blk_cnt;   /* number of the used blocks */
@@ -134,11 +126,40 @@ struct file_operations {
                      off_t offset);
     int (*ioctl)(struct file *, unsigned int cmd, unsigned long arg);
     int (*open)(struct inode *inode, struct file *file);
+    int (*release)(struct inode *inode, struct file *file);
+    uint32_t (*poll)(struct file *filp);
+    ssize_t (*read_iter)(struct file *filp,
+                         const struct iovec *iov,
+                         int iovcnt,
+                         off_t offset);
+    ssize_t (*write_iter)(struct file *filp,
+                          const struct iovec *iov,
+                          int iovcnt,
+                          off_t offset);
+    /* Access at the given offset without moving the file offset */
+    ssize_t (*pread)(struct file *filp, char *buf, size_t size, off_t offset);
+    ssize_t (*pwrite)(struct file *filp,
+                      const char *buf,
+                      size_t size,
+                      off_t offset);
+    int (*truncate)(struct file *filp, off_t length);
+    int (*mmap)(struct file *filp,
+                off_t offset,
+                size_t length,
+                int prot,
+                void **addr);
+    void (*munmap)(struct file *filp, void *addr, size_t length);
+    /* Storage that manages its own files, i.e., not in the romfs format */
+    int (*mount)(struct file *dev_file, struct inode *inode_dir);
+    struct file *(*create)(struct file *dev_file, const char *name);
 };
 
+/* Open file description, shared by the file descriptors duplicated from the
+ * same open() */
 struct fdtable {
-    int flags;
-    struct file *file;
+    int flags;         /* Flags given to open() */
+    int refcnt;        /* Number of the file descriptors referring to it */
+    struct file *file; /* The opened file */
 };
 
 void rootfs_init(void);
@@ -149,19 +170,24 @@ void link_stderr_dev(char *path);
 
 int register_chrdev(char *name, struct file_operations *fops);
 int register_blkdev(char *name, struct file_operations *fops);
+int register_blkdev_file(char *name, struct file *dev_file);
+struct inode *fs_link_file(struct inode *inode_dir,
+                           const char *name,
+                           struct file *filp);
 
 int fs_read_dir(DIR *dirp, struct dirent *dirent);
-uint32_t fs_get_block_addr(struct inode *inode, int blk_index);
-uint32_t fs_file_append_block(struct inode *inode);
-
-void request_create_file(int thread_id, const char *path, uint8_t file_type);
-void request_open_file(int thread_id, const char *path);
-void request_open_directory(int reply_fd, const char *path);
-void request_mount(int thread_id, const char *source, const char *target);
-void request_getcwd(int thread_id, char *buf, size_t len);
-void request_chdir(int thread_id, const char *path);
-
-void filesysd(void);
+void fs_load_block_map(struct inode *inode, uint32_t *blk_map);
+uint32_t fs_file_append_block(struct inode *inode, uint32_t last_blk);
+
+/* File system operations executed in the context of the caller. The
+ * operations are serialized with a mutex, hence must not be called with
+ * preemption disabled */
+int vfs_create(const char *path, uint8_t file_type);
+int vfs_open(const char *path);
+struct inode *vfs_opendir(const char *path);
+int vfs_mount(const char *source, const char *target);
+char *vfs_getcwd(char *buf, size_t len);
+int vfs_chdir(const char *path);
 
 void fs_print_inode_bitmap(void);
 void fs_print_block_bitmap(void);
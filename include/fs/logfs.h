@@ -0,0 +1,87 @@
+/**
+ * @file
+ */
+#ifndef __LOGFS_H__
+#define __LOGFS_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/limits.h>
+#include <sys/types.h>
+
+#include <fs/fs.h>
+#include <kernel/mutex.h>
+
+#include "kconfig.h"
+
+#define LOGFS_BLK_MAX 32   /* Max number of the erase blocks */
+#define LOGFS_BUF_SIZE 256 /* Size of the append buffer in bytes */
+
+/* Storage with erase-before-write semantics, e.g., NOR flash. The offset and
+ * size of the program operation are always multiples of 4 bytes */
+struct flash_dev {
+    size_t blk_size; /* Size of the erase block in bytes */
+    int blk_cnt;     /* Number of the erase blocks */
+    int (*read)(struct flash_dev *dev,
+                int blk,
+                off_t offset,
+                void *buf,
+                size_t size);
+    int (*prog)(struct flash_dev *dev,
+                int blk,
+                off_t offset,
+                const void *buf,
+                size_t size);
+    int (*erase)(struct flash_dev *dev, int blk);
+};
+
+struct logfs;
+
+struct logfs_node {
+    struct file file;
+    struct logfs *fs;
+    char name[NAME_MAX];
+    bool used;
+    uint16_t gen;     /* Generation of the content, increased by truncation */
+    uint32_t size;    /* File size including the buffered data */
+    off_t pos;        /* Read position */
+    int cur_blk;      /* Block of the last record read, -1 if none */
+    uint32_t cur_off; /* Offset of the last record read */
+};
+
+struct logfs_block {
+    uint32_t seq;       /* Position of the block in the log, 0 if free */
+    uint32_t erase_cnt; /* Number of times the block has been erased */
+    uint32_t end;       /* End of the valid records in the block */
+    bool erased;        /* The block is free and already erased */
+};
+
+struct logfs {
+    struct file dev_file; /* Block device file for mounting */
+    struct flash_dev *dev;
+    struct mutex lock; /* Serialize the operations, which may erase blocks */
+    struct logfs_block blocks[LOGFS_BLK_MAX];
+    struct logfs_node nodes[LOGFS_FILE_MAX];
+    int head;          /* Block being appended */
+    uint32_t head_off; /* Append offset in the head block */
+    uint32_t seq;      /* Sequence number of the next allocated block */
+    int free_cnt;      /* Number of the free blocks */
+    int buf_id;        /* File that owns the append buffer, -1 if empty */
+    uint32_t buf_off;  /* File offset of the buffered data */
+    uint32_t buf_len;  /* Size of the buffered data */
+    uint8_t buf[LOGFS_BUF_SIZE];
+};
+
+/**
+ * @brief  Register a log-structured file system on the flash device as the
+ *         block device /dev/<name>, which can be mounted with mount()
+ * @param  fs: The file system object to initialize.
+ * @param  dev: The flash device to store the file system. At least 3 erase
+ *         blocks are required.
+ * @param  name: The name of the block device.
+ * @retval int: 0 on success and negative error number on error.
+ */
+int logfs_init(struct logfs *fs, struct flash_dev *dev, char *name);
+
+#endif
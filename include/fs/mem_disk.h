@@ -0,0 +1,15 @@
+/**
+ * @file
+ */
+#ifndef __MEM_DISK_H__
+#define __MEM_DISK_H__
+
+/**
+ * @brief  Initialize the memory disk, a block device on the RAM that
+ *         completes the requests asynchronously like a DMA-capable device
+ * @param  None
+ * @retval None
+ */
+void mem_disk_init(void);
+
+#endif
@@ -0,0 +1,14 @@
+/**
+ * @file
+ */
+#ifndef __RAM_DEV_H__
+#define __RAM_DEV_H__
+
+/**
+ * @brief  Initialize the ram device with the log-structured file system
+ * @param  None
+ * @retval None
+ */
+void ram_dev_init(void);
+
+#endif
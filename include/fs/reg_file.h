@@ -8,6 +8,8 @@
 
 struct reg_file {
     int pos;
+    uint32_t *blk_map; /* Address of every block of the file */
+    int blk_map_size;  /* Capacity of the block map */
     struct file file;
 };
 
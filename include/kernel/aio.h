@@ -0,0 +1,62 @@
+/**
+ * @file
+ */
+#ifndef __KERNEL_AIO_H__
+#define __KERNEL_AIO_H__
+
+#include <aio.h>
+#include <stdbool.h>
+
+#include <common/list.h>
+#include <fs/fs.h>
+
+struct aio_request {
+    struct aiocb *aiocbp;  /* Request of the user */
+    struct file *filp;     /* File to operate on */
+    int opcode;            /* LIO_READ or LIO_WRITE */
+    char *buf;             /* Copy of aio_buf */
+    size_t nbytes;         /* Copy of aio_nbytes */
+    off_t offset;          /* Copy of aio_offset */
+    int flags;             /* File descriptor flags at submission */
+    uint16_t tid;          /* Submitting thread to notify */
+    bool orphan;           /* The submitting thread has exited */
+    struct list_head list; /* Entry of the request queue */
+};
+
+/**
+ * @brief  Queue the request to the AIO daemon. Must be called with the
+ *         preemption disabled
+ * @param  req: The request allocated with kmalloc(), which is freed by the
+ *         daemon after completion.
+ * @retval None
+ */
+void aio_submit(struct aio_request *req);
+
+/**
+ * @brief  Cancel the queued requests of an exiting thread and discard the
+ *         results of its requests in execution. Must be called with the
+ *         preemption disabled before the thread stack is freed
+ * @param  tid: The ID of the exiting thread.
+ * @retval None
+ */
+void aio_thread_exit(uint16_t tid);
+
+/**
+ * @brief  Check if any of the requests is completed
+ * @param  list: The requests to check, NULL entries are ignored.
+ * @param  nent: The number of entries of the list.
+ * @retval bool: true if at least one request is completed.
+ */
+bool aio_any_done(const struct aiocb *const list[], int nent);
+
+/**
+ * @brief  Put the running thread to sleep until the next completion. Must be
+ *         called with the preemption disabled and followed by schedule()
+ * @param  None
+ * @retval None
+ */
+void aio_prepare_to_wait(void);
+
+void aiod(void);
+
+#endif
@@ -5,9 +5,9 @@
 #define __DAEMON_H__
 
 /* clang-format off */
-#define DAEMON_LIST \
+#define DAEMON_LIST          \
     DECLARE_DAEMON(SOFTIRQD), \
-    DECLARE_DAEMON(FILESYSD)
+    DECLARE_DAEMON(AIOD)
 /* clang-format on */
 
 #define DECLARE_DAEMON(x) x
@@ -51,16 +51,28 @@ enum {
     USER_THREAD = 1,
 } THREAD_TYPE;
 
+struct vm_area {
+    void *start;       /* Start address of the mapping, NULL if unused */
+    size_t size;       /* Size of the mapping in bytes */
+    int prot;          /* Memory protection of the mapping */
+    struct file *filp; /* File of the mapped object */
+};
+
 struct task_struct {
     uint16_t pid;                    /* Task ID */
     struct thread_info *main_thread; /* The main thread belongs to the task */
 
-    /* For recording for the file descriptors belongs to the task */
+    /* File descriptor table of the task, bit n of the bitmap is set if the
+     * file descriptor n is used */
+    struct fdtable *fdtable[OPEN_MAX];
     uint32_t bitmap_fds[BITMAP_SIZE(OPEN_MAX)];
 
     /* For recording message queue descriptors belongs to the task */
     uint32_t bitmap_mqds[BITMAP_SIZE(MQUEUE_MAX)];
 
+    /* For recording memory mappings created by mmap() */
+    struct vm_area mmaps[MMAP_MAX];
+
     struct list_head threads_list; /* List of all threads of the task */
     struct list_head list;         /* Linked to the global task list */
 };
@@ -73,7 +85,9 @@ struct thread_info {
     unsigned long *stack_top; /* Stack pointer to the top of the thread stack */
     unsigned long stack_top_preserved; /* Preserve for staging new handler */
     unsigned long *stack;              /* Base address of the thread stack */
+    unsigned long *stack_watermark;    /* Lowest stack address ever used */
     size_t stack_size;                 /* Stack size of the thread in bytes */
+    bool stack_static; /* Stack is provided by the user instead of pages */
 
     /* Syscall */
     unsigned long *syscall_args[4]; /* Pointer to the syscall arguments */
@@ -86,6 +100,7 @@ struct thread_info {
     void *retval;               /* For passing retval after the thread end */
     void **retval_join;         /* To getting retval from a thread to join */
     size_t file_request_size;   /* Size of the thread requesting to a file */
+    int file_flags;             /* Flags of the file descriptor being used */
     uint32_t sleep_ticks;       /* Remained ticks to sleep */
     uint32_t preempt_cnt;       /* For preserving threads's preemption level */
     uint16_t tid;               /* Thread ID */
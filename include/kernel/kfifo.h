@@ -8,6 +8,32 @@
 #include <stddef.h>
 #include <stdint.h>
 
+/* Record header size of the structured FIFO (sizeof(struct kfifo_hdr)) */
+#define KFIFO_HDR_SIZE sizeof(uint16_t)
+
+/* Size of a single FIFO element including the record header */
+#define KFIFO_PAYLOAD_SIZE(esize) ((esize) > 1 ? KFIFO_HDR_SIZE + (esize) : 1)
+
+/* Size of the data space to provide for kfifo_init() */
+#define KFIFO_BUF_SIZE(esize, size) (KFIFO_PAYLOAD_SIZE(esize) * (size))
+
+/**
+ * @brief  Define a FIFO together with its data space at the build time
+ * @param  _name: The name of the FIFO object.
+ * @param  _esize: Element size of the FIFO.
+ * @param  _size: Number of elements in the FIFO.
+ */
+#define DEFINE_KFIFO(_name, _esize, _size)                    \
+    static uint8_t _name##_buf[KFIFO_BUF_SIZE(_esize, _size)] \
+        __attribute__((aligned(4)));                          \
+    struct kfifo _name = {                                    \
+        .data = _name##_buf,                                  \
+        .size = (_size),                                      \
+        .esize = (_esize),                                    \
+        .header_size = (_esize) > 1 ? KFIFO_HDR_SIZE : 0,     \
+        .payload_size = KFIFO_PAYLOAD_SIZE(_esize),           \
+    }
+
 struct kfifo {
     int start;
     int end;
@@ -107,6 +133,40 @@ void kfifo_dma_out_prepare(struct kfifo *fifo, char **data_ptr, size_t *n);
  */
 void kfifo_dma_out_finish(struct kfifo *fifo);
 
+/**
+ * @brief  Return the contiguous free space of the byte stream FIFO to write
+ * @param  fifo: Pointer to the FIFO.
+ * @param  data_ptr: For saving the address of the free space.
+ * @retval size_t: Size of the free space can be written without wrapping
+ *         around the end of the buffer in bytes.
+ */
+size_t kfifo_in_linear(struct kfifo *fifo, char **data_ptr);
+
+/**
+ * @brief  Complete data writing to the space returned by kfifo_in_linear()
+ * @param  fifo: Pointer to the FIFO.
+ * @param  n: Size of the data written to the FIFO in bytes.
+ * @retval None
+ */
+void kfifo_in_linear_finish(struct kfifo *fifo, size_t n);
+
+/**
+ * @brief  Return the contiguous data of the byte stream FIFO to read
+ * @param  fifo: Pointer to the FIFO.
+ * @param  data_ptr: For saving the address of the data.
+ * @retval size_t: Size of the data can be read without wrapping around the
+ *         end of the buffer in bytes.
+ */
+size_t kfifo_out_linear(struct kfifo *fifo, char **data_ptr);
+
+/**
+ * @brief  Complete data reading from the space returned by kfifo_out_linear()
+ * @param  fifo: Pointer to the FIFO.
+ * @param  n: Size of the data read from the FIFO in bytes.
+ * @retval None
+ */
+void kfifo_out_linear_finish(struct kfifo *fifo, size_t n);
+
 /**
  * @brief  Put data into the FIFO
  * @param  fifo: Pointer to the FIFO.
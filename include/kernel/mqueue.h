@@ -5,12 +5,14 @@
 #define __KERNEL_MQUEUE_H__
 
 #include <mqueue.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <unistd.h>
 
 struct mqueue_data {
     struct list_head list;
     size_t size;
+    mqd_t owner; /* Descriptor the buffer is lent through */
     char data[0];
 };
 
@@ -19,6 +21,9 @@ struct mqueue {
     char *buf;
     size_t size;
     size_t cnt;
+    size_t loaned;              /* Number of the messages on loan */
+    unsigned long prio_bitmap;  /* Bit n is set if used_list[n] is not empty */
+    bool static_alloc;          /* Memory is provided by the user */
     struct list_head free_list;
     struct list_head used_list[MQ_PRIO_MAX + 1];
     struct list_head r_wait_list;
@@ -32,6 +37,7 @@ struct mq_desc {
 };
 
 struct mqueue *__mq_allocate(struct mq_attr *attr);
+struct mqueue *__mq_init_static(struct mq_attr *attr, void *mem);
 void __mq_free(struct mqueue *mq);
 size_t __mq_len(struct mqueue *mq);
 ssize_t __mq_receive(struct mqueue *mq,
@@ -44,5 +50,25 @@ ssize_t __mq_send(struct mqueue *mq,
                   const char *msg_ptr,
                   size_t msg_len,
                   unsigned int priority);
+int __mq_reserve(struct mqueue *mq,
+                 const struct mq_attr *attr,
+                 mqd_t mqdes,
+                 void **msg_ptr);
+int __mq_commit(struct mqueue *mq,
+                const struct mq_attr *attr,
+                mqd_t mqdes,
+                void *msg_ptr,
+                size_t msg_len,
+                unsigned int msg_prio);
+ssize_t __mq_borrow(struct mqueue *mq,
+                    const struct mq_attr *attr,
+                    mqd_t mqdes,
+                    void **msg_ptr,
+                    unsigned int *msg_prio);
+int __mq_release(struct mqueue *mq,
+                 const struct mq_attr *attr,
+                 mqd_t mqdes,
+                 void *msg_ptr);
+void __mq_reclaim(struct mqueue *mq, const struct mq_attr *attr, mqd_t mqdes);
 
 #endif
@@ -4,7 +4,9 @@
 #ifndef __KERNEL_PIPE_H__
 #define __KERNEL_PIPE_H__
 
+#include <stdbool.h>
 #include <stdio.h>
+#include <sys/types.h>
 
 #include <fs/fs.h>
 #include <kernel/kfifo.h>
@@ -14,16 +16,33 @@ struct pipe {
     struct file file;
     struct list_head r_wait_list;
     struct list_head w_wait_list;
+    long buf_order; /* Page order of the buffer, -1 if not from pages */
+};
+
+/* Arguments of splice() packed for passing through the syscall */
+struct splice_args {
+    int fd_in;
+    off_t *off_in;
+    int fd_out;
+    off_t *off_out;
+    size_t len;
+    unsigned int flags;
 };
 
 int fifo_init(int fd,
               struct file **files,
               struct inode *file_inode,
               struct pipe *pipe);
+int fifo_resize(struct pipe *pipe, size_t size);
+void fifo_release(struct pipe *pipe);
+int fifo_fcntl(struct file *filp, int cmd, unsigned long arg);
+bool file_is_fifo(struct file *filp);
 ssize_t fifo_read(struct file *filp, char *buf, size_t size, off_t offset);
 ssize_t fifo_write(struct file *filp,
                    const char *buf,
                    size_t size,
                    off_t offset);
+ssize_t fifo_splice_read(struct file *filp, char *buf, size_t size);
+ssize_t fifo_splice_write(struct file *filp, const char *buf, size_t size);
 
 #endif
@@ -6,6 +6,9 @@
 
 #include <fs/fs.h>
 
+#include <stdbool.h>
+
 void poll_notify(struct file *notify_file);
+void poll_notify_match(bool (*match)(struct file *filp, void *arg), void *arg);
 
 #endif
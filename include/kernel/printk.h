@@ -4,14 +4,97 @@
 #ifndef __KERNEL_PRINTK_H__
 #define __KERNEL_PRINTK_H__
 
+#include <stdbool.h>
+#include <stdint.h>
+#include <tenok.h>
+
+#include "kconfig.h"
+
+/* Log levels of the kernel messages */
+#define KERN_EMERG 0   /* System is unusable */
+#define KERN_ALERT 1   /* Action must be taken immediately */
+#define KERN_CRIT 2    /* Critical conditions */
+#define KERN_ERR 3     /* Error conditions */
+#define KERN_WARNING 4 /* Warning conditions */
+#define KERN_NOTICE 5  /* Normal but significant conditions */
+#define KERN_INFO 6    /* Informational messages */
+#define KERN_DEBUG 7   /* Debug messages */
+
+#define PRINTK_BIN_ARGS_MAX 8 /* Max number of the printk_bin() arguments */
+
+#define __PRINTK_NARGS(...) \
+    __PRINTK_NARGS_(, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define __PRINTK_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+
+/**
+ * @brief  Record a kernel message with the given log level. The message is
+ *         compiled out if the level is above PRINTK_LEVEL, and is only kept
+ *         in the log ring for dmesg if the level is above
+ *         PRINTK_CONSOLE_LEVEL. Safe to call from the interrupt handlers
+ * @param  level: The log level, KERN_EMERG to KERN_DEBUG.
+ * @param  format: The formatting string.
+ * @param  variable arguments: The variables used by the
+ *         formatting specifiers.
+ * @retval None
+ */
+#define printk_level(level, format, ...)              \
+    do {                                              \
+        if ((level) <= PRINTK_LEVEL)                  \
+            __printk((level), format, ##__VA_ARGS__); \
+    } while (0)
+
 /**
- * @brief  Display a kernel message.
+ * @brief  Display a kernel message with the KERN_INFO level.
  * @param  format: The formatting string.
  * @param  variable arguments: The variables used by the
  *         formatting specifiers.
  * @retval None
  */
-void printk(char *format, ...);
+#define printk(format, ...) printk_level(KERN_INFO, format, ##__VA_ARGS__)
+
+/* Shorthands of printk_level() */
+#define pr_emerg(fmt, ...) printk_level(KERN_EMERG, fmt, ##__VA_ARGS__)
+#define pr_alert(fmt, ...) printk_level(KERN_ALERT, fmt, ##__VA_ARGS__)
+#define pr_crit(fmt, ...) printk_level(KERN_CRIT, fmt, ##__VA_ARGS__)
+#define pr_err(fmt, ...) printk_level(KERN_ERR, fmt, ##__VA_ARGS__)
+#define pr_warn(fmt, ...) printk_level(KERN_WARNING, fmt, ##__VA_ARGS__)
+#define pr_notice(fmt, ...) printk_level(KERN_NOTICE, fmt, ##__VA_ARGS__)
+#define pr_info(fmt, ...) printk_level(KERN_INFO, fmt, ##__VA_ARGS__)
+#define pr_debug(fmt, ...) printk_level(KERN_DEBUG, fmt, ##__VA_ARGS__)
+
+/**
+ * @brief  Record a kernel message in the binary form. Only the address of
+ *         the format string, the timestamp and the raw arguments are stored,
+ *         and the message is formatted on the host by scripts/printk-decode.py
+ *         with the format strings kept in the ELF file. The format strings
+ *         are placed in the .printk_fmt section, which is not loaded to the
+ *         target. Safe to call from the interrupt handlers
+ * @param  format: The formatting string, which must be a string literal.
+ * @param  variable arguments: Up to 8 integers, characters or pointers. The
+ *         strings of %s must be constant strings in the image.
+ * @retval None
+ */
+#define printk_bin(format, ...)                                     \
+    do {                                                            \
+        static const char __printk_fmt[]                            \
+            __attribute__((section(".printk_fmt"), used)) = format; \
+        if (0)                                                      \
+            __printk_bin_check(format, ##__VA_ARGS__);              \
+        __printk_bin((uint32_t) __printk_fmt,                       \
+                     __PRINTK_NARGS(__VA_ARGS__), ##__VA_ARGS__);   \
+    } while (0)
+
+/* Let the compiler check the arguments of printk_bin() against the format */
+static inline __attribute__((format(printf, 1, 2))) void __printk_bin_check(
+    const char *format,
+    ...)
+{
+}
+
+void __printk_bin(uint32_t fmt_id, int nargs, ...);
+
+void __printk(int level, const char *format, ...)
+    __attribute__((format(printf, 2, 3)));
 
 /**
  * @brief  Display a message, then halt the system
@@ -22,9 +105,10 @@ void printk(char *format, ...);
  */
 void panic(char *format, ...);
 
-void printkd_init(void);
 void printkd_start(void);
 bool printk_all_flushed(void);
+uint32_t printk_lost_cnt(void);
+int printk_kmsg_info(struct kmsg_stat *msg, uint32_t seq);
 void printkd(void);
 
 #endif
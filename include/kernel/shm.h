@@ -0,0 +1,40 @@
+/**
+ * @file
+ */
+#ifndef __KERNEL_SHM_H__
+#define __KERNEL_SHM_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/limits.h>
+#include <sys/types.h>
+
+#include <common/list.h>
+#include <fs/fs.h>
+
+struct shm {
+    char name[NAME_MAX];
+    struct file file;
+    void *mem;     /* Memory pages of the object */
+    size_t size;   /* Size of the object set by ftruncate() */
+    long order;    /* Page order of the memory, -1 if not allocated */
+    int map_cnt;   /* Number of the mappings refer to the object */
+    bool opened;   /* Referred by any file descriptor */
+    bool unlinked; /* Name has been removed by shm_unlink() */
+    struct list_head list;
+};
+
+/* Arguments of mmap() packed for passing through the syscall */
+struct mmap_args {
+    void *addr;
+    size_t length;
+    int prot;
+    int flags;
+    int fd;
+    off_t offset;
+};
+
+int __shm_open(const char *name, int oflag, struct file **filp);
+int __shm_unlink(const char *name);
+
+#endif
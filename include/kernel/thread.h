@@ -26,5 +26,6 @@ struct thread_once {
 
 struct thread_info *current_thread_info(void);
 struct thread_info *acquire_thread(int tid);
+void thread_signal(struct thread_info *thread, int signum);
 
 #endif
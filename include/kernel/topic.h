@@ -0,0 +1,31 @@
+/**
+ * @file
+ */
+#ifndef __KERNEL_TOPIC_H__
+#define __KERNEL_TOPIC_H__
+
+#include <stdint.h>
+#include <topic.h>
+
+#include <common/list.h>
+#include <fs/fs.h>
+
+struct topic {
+    const struct topic_metadata *meta;
+    char *buf;           /* Ring of queue_depth messages */
+    uint32_t generation; /* Number of the published messages */
+    uint32_t seq;        /* Odd while the buffer is being updated */
+    struct list_head list;
+};
+
+struct topic_file {
+    struct file file;
+    struct topic *topic;
+    uint32_t generation; /* Generation of the next message to read */
+};
+
+int __topic_open(const struct topic_metadata *meta,
+                 int flags,
+                 struct file **filp);
+
+#endif
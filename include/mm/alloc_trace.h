@@ -0,0 +1,62 @@
+/**
+ * @file
+ */
+#ifndef __ALLOC_TRACE_H__
+#define __ALLOC_TRACE_H__
+
+#include <stddef.h>
+#include <tenok.h>
+
+/**
+ * @brief  Record a new allocation and update the usage counters
+ * @param  type: The allocator type (ALLOC_KMALLOC, ALLOC_PAGE or ALLOC_HEAP).
+ * @param  ptr: The address of the allocated memory.
+ * @param  size: The size of the allocated memory in bytes.
+ * @param  caller: The address of the allocation call site.
+ * @retval None
+ */
+void alloc_trace_add(int type, void *ptr, size_t size, void *caller);
+
+/**
+ * @brief  Remove the record of a freed allocation and update the usage
+ *         counters
+ * @param  type: The allocator type (ALLOC_KMALLOC, ALLOC_PAGE or ALLOC_HEAP).
+ * @param  ptr: The address of the freed memory.
+ * @param  size: The size of the freed memory in bytes.
+ * @retval None
+ */
+void alloc_trace_del(int type, void *ptr, size_t size);
+
+/**
+ * @brief  Get the current usage of the allocator
+ * @param  type: The allocator type.
+ * @retval size_t: The allocated size in bytes.
+ */
+size_t alloc_trace_used(int type);
+
+/**
+ * @brief  Get the peak usage of the allocator since the system started
+ * @param  type: The allocator type.
+ * @retval size_t: The peak allocated size in bytes.
+ */
+size_t alloc_trace_peak(int type);
+
+/**
+ * @brief  Get the number of allocations that are not recorded since the
+ *         record table was full
+ * @param  None
+ * @retval size_t: The number of the dropped records.
+ */
+size_t alloc_trace_dropped(void);
+
+/**
+ * @brief  Get the live allocation records iteratively
+ * @param  info: For returning the allocation record.
+ * @param  next: The pointer to the next record. The initial argument should
+ *         be set with NULL.
+ * @retval void *: The pointer for continuing the iteration. The function
+ *         returns NULL without filling the info if no more record exists.
+ */
+void *alloc_trace_iterate(struct alloc_stat *info, void *next);
+
+#endif
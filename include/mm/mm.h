@@ -40,6 +40,7 @@ void kfree(void *ptr);
 
 unsigned long heap_get_total_size(void);
 unsigned long heap_get_free_size(void);
+size_t heap_get_block_size(void *ptr);
 void heap_init(void);
 void *__malloc(size_t size);
 void __free(void *ptr);
@@ -0,0 +1,76 @@
+/**
+ * @file
+ */
+#ifndef __AIO_H__
+#define __AIO_H__
+
+#include <signal.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include <time.h>
+
+#define LIO_READ 0
+#define LIO_WRITE 1
+
+struct aiocb {
+    int aio_fildes;               /* File descriptor to operate on */
+    off_t aio_offset;             /* File offset of seekable files */
+    volatile void *aio_buf;       /* Buffer of the transfer */
+    size_t aio_nbytes;            /* Size of the transfer in bytes */
+    int aio_reqprio;              /* Unused */
+    struct sigevent aio_sigevent; /* SIGEV_NONE or SIGEV_SIGNAL */
+    int aio_lio_opcode;           /* LIO_READ or LIO_WRITE, set by the kernel */
+
+    /* Status maintained by the kernel */
+    int __error;      /* EINPROGRESS until completion */
+    ssize_t __return; /* Return value of the operation */
+};
+
+/**
+ * @brief  Queue a read request and return immediately. The request is
+ *         executed by the kernel in the background, and the aiocb and the
+ *         buffer must stay valid until completion
+ * @param  aiocbp: The request with aio_fildes, aio_offset, aio_buf,
+ *         aio_nbytes and aio_sigevent set.
+ * @retval int: 0 on success and nonzero error number on error.
+ */
+int aio_read(struct aiocb *aiocbp);
+
+/**
+ * @brief  Queue a write request and return immediately. The request is
+ *         executed by the kernel in the background, and the aiocb and the
+ *         buffer must stay valid until completion
+ * @param  aiocbp: The request with aio_fildes, aio_offset, aio_buf,
+ *         aio_nbytes and aio_sigevent set.
+ * @retval int: 0 on success and nonzero error number on error.
+ */
+int aio_write(struct aiocb *aiocbp);
+
+/**
+ * @brief  Get the error status of the request
+ * @param  aiocbp: The submitted request.
+ * @retval int: EINPROGRESS if the request is not completed, 0 if completed
+ *         successfully, or the positive error number of the failure.
+ */
+int aio_error(const struct aiocb *aiocbp);
+
+/**
+ * @brief  Get the return status of the completed request
+ * @param  aiocbp: The completed request.
+ * @retval ssize_t: The return value of the read or write operation.
+ */
+ssize_t aio_return(struct aiocb *aiocbp);
+
+/**
+ * @brief  Wait until at least one of the requests is completed or the
+ *         timeout expires
+ * @param  list: The requests to wait, NULL entries are ignored.
+ * @param  nent: The number of entries of the list.
+ * @param  timeout: The relative time to wait, or NULL to wait infinitely.
+ * @retval int: 0 on success and nonzero error number on error.
+ */
+int aio_suspend(const struct aiocb *const list[],
+                int nent,
+                const struct timespec *timeout);
+
+#endif
@@ -19,6 +19,7 @@
 #define ENOTBLK 15      /**< Not a block device */
 #define EBUSY 16        /**< Device or resource busy */
 #define EEXIST 17       /**< File exists */
+#define ENODEV 19       /**< No such device */
 #define ENOTDIR 20      /**< Not a directory */
 #define EINVAL 22       /**< Invalid argument */
 #define ENFILE 23       /**< Too many open files in the system */
@@ -30,9 +31,12 @@
 #define ESPIPE 29       /**< Illegal seek */
 #define EROFS 30        /**< Read-only file system */
 #define EDEADLK 45      /**< Deadlock */
+#define ENODATA 61      /**< No data available */
 #define ENOSYS 88       /**< Function not implemented */
 #define ENAMETOOLONG 91 /**< File or path name too long */
+#define EINPROGRESS 119 /**< Operation in progress */
 #define EMSGSIZE 122    /**< Message to long */
 #define EOVERFLOW 139   /**< Numerical overflow */
+#define ECANCELED 140   /**< Operation canceled */
 
 #endif
@@ -4,6 +4,9 @@
 #ifndef __FCNTL_H__
 #define __FCNTL_H__
 
+#include <stddef.h>
+#include <sys/types.h>
+
 #define O_RDONLY 0
 #define O_WRONLY 1
 #define O_RDWR 2
@@ -11,6 +14,13 @@
 #define O_EXCL 0x0800
 #define O_NONBLOCK 00004000
 
+#define F_SETPIPE_SZ 1031 /* Set the buffer size of the pipe */
+#define F_GETPIPE_SZ 1032 /* Get the buffer size of the pipe */
+
+#define SPLICE_F_MOVE 1     /* Ignored, the data is always copied */
+#define SPLICE_F_NONBLOCK 2 /* Do not block on the pipe */
+#define SPLICE_F_MORE 4     /* Ignored, more data will be spliced */
+
 /**
  * @brief  Open the file specified by the pathname
  * @param  pathname: The pathname of the file.
@@ -20,4 +30,39 @@
  */
 int open(const char *pathname, int flags);
 
+/**
+ * @brief  Perform the operation specified by cmd on the file descriptor fd
+ * @param  fd: The file descriptor to provide.
+ * @param  cmd: The command of the operation. F_GETPIPE_SZ returns the buffer
+ *         size of the pipe, and F_SETPIPE_SZ sets the buffer size of the pipe
+ *         to at least the size given by the third argument. The buffer size
+ *         is rounded up to the page size.
+ * @retval int: The buffer size of the pipe on success and nonzero error
+ *         number on error.
+ */
+int fcntl(int fd, int cmd, ...);
+
+/**
+ * @brief  Move data between two file descriptors without copying it through
+ *         the user space. One of the file descriptors must refer to a pipe
+ * @param  fd_in: The file descriptor to read from.
+ * @param  off_in: Must be NULL if fd_in is a pipe. Otherwise the data is read
+ *         from the offset it points to, which is updated after the transfer,
+ *         and the file offset of fd_in is not changed. The file offset is
+ *         used and updated if NULL is given.
+ * @param  fd_out: The file descriptor to write to.
+ * @param  off_out: Same as off_in but for fd_out.
+ * @param  len: The max number of bytes to move.
+ * @param  flags: The bitwise OR of SPLICE_F_MOVE, SPLICE_F_NONBLOCK and
+ *         SPLICE_F_MORE.
+ * @retval ssize_t: The number of bytes moved on success and nonzero error
+ *         number on error. 0 means the end of the input.
+ */
+ssize_t splice(int fd_in,
+               off_t *off_in,
+               int fd_out,
+               off_t *off_out,
+               size_t len,
+               unsigned int flags);
+
 #endif
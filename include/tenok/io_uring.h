@@ -0,0 +1,145 @@
+/**
+ * @file
+ */
+#ifndef __IO_URING_H__
+#define __IO_URING_H__
+
+#include <stdint.h>
+
+#define IORING_OP_NOP 0   /* No operation */
+#define IORING_OP_READ 1  /* read() */
+#define IORING_OP_WRITE 2 /* write() */
+#define IORING_OP_IOCTL 3 /* ioctl() */
+
+/* Cancel the next request if this one fails */
+#define IOSQE_IO_LINK (1 << 0)
+
+/* Submission queue entry */
+struct io_uring_sqe {
+    uint8_t opcode;          /* Operation of the request */
+    uint8_t flags;           /* IOSQE_* flags */
+    int fd;                  /* File descriptor to operate on */
+    unsigned long addr;      /* Buffer of read/write or argument of ioctl */
+    unsigned int len;        /* Size of read/write or command of ioctl */
+    unsigned long user_data; /* Passed back with the completion */
+};
+
+/* Completion queue entry */
+struct io_uring_cqe {
+    unsigned long user_data; /* user_data of the request */
+    int res;                 /* Return value of the operation */
+};
+
+struct io_uring {
+    struct io_uring_sqe *sqes; /* Submission queue */
+    struct io_uring_cqe *cqes; /* Completion queue */
+    unsigned int entries;      /* Size of both queues, must be power of 2 */
+    unsigned int sq_head;      /* Advanced by the kernel */
+    unsigned int sq_tail;      /* Advanced by the thread */
+    unsigned int cq_head;      /* Advanced by the thread */
+    unsigned int cq_tail;      /* Advanced by the kernel */
+};
+
+/**
+ * @brief  Initialize a ring with the memory provided by the caller
+ * @param  ring: The ring to initialize.
+ * @param  sqes: The array of entries for the submission queue.
+ * @param  cqes: The array of entries for the completion queue.
+ * @param  entries: The length of both arrays, which must be power of 2.
+ * @retval int: 0 on success and nonzero error number on error.
+ */
+int io_uring_init(struct io_uring *ring,
+                  struct io_uring_sqe *sqes,
+                  struct io_uring_cqe *cqes,
+                  unsigned int entries);
+
+/**
+ * @brief  Get the next free submission queue entry
+ * @param  ring: The ring to provide.
+ * @retval struct io_uring_sqe *: The entry to fill, or NULL if the submission
+ *         queue is full.
+ */
+struct io_uring_sqe *io_uring_get_sqe(struct io_uring *ring);
+
+/**
+ * @brief  Prepare a read request
+ * @param  sqe: The entry returned by io_uring_get_sqe().
+ * @param  fd: The file descriptor to read.
+ * @param  buf: The buffer for storing the read data.
+ * @param  nbytes: The number of bytes to read.
+ * @retval None
+ */
+void io_uring_prep_read(struct io_uring_sqe *sqe,
+                        int fd,
+                        void *buf,
+                        unsigned int nbytes);
+
+/**
+ * @brief  Prepare a write request
+ * @param  sqe: The entry returned by io_uring_get_sqe().
+ * @param  fd: The file descriptor to write.
+ * @param  buf: The data to write.
+ * @param  nbytes: The number of bytes to write.
+ * @retval None
+ */
+void io_uring_prep_write(struct io_uring_sqe *sqe,
+                         int fd,
+                         const void *buf,
+                         unsigned int nbytes);
+
+/**
+ * @brief  Prepare an I/O control request
+ * @param  sqe: The entry returned by io_uring_get_sqe().
+ * @param  fd: The file descriptor to control.
+ * @param  cmd: The request command to perform.
+ * @param  arg: The argument to pass with the request.
+ * @retval None
+ */
+void io_uring_prep_ioctl(struct io_uring_sqe *sqe,
+                         int fd,
+                         unsigned int cmd,
+                         unsigned long arg);
+
+/**
+ * @brief  Submit all the prepared requests with a single syscall. The
+ *         requests are executed in order and completed before returning
+ * @param  ring: The ring to provide.
+ * @retval int: The number of the submitted requests on success and nonzero
+ *         error number on error.
+ */
+int io_uring_submit(struct io_uring *ring);
+
+/**
+ * @brief  Get the next completion without waiting
+ * @param  ring: The ring to provide.
+ * @retval struct io_uring_cqe *: The completion, or NULL if the completion
+ *         queue is empty.
+ */
+struct io_uring_cqe *io_uring_peek_cqe(struct io_uring *ring);
+
+/**
+ * @brief  Mark the completion returned by io_uring_peek_cqe() as consumed
+ * @param  ring: The ring to provide.
+ * @param  cqe: The completion to consume.
+ * @retval None
+ */
+void io_uring_cqe_seen(struct io_uring *ring, struct io_uring_cqe *cqe);
+
+/**
+ * @brief  Consume a number of completions at once
+ * @param  ring: The ring to provide.
+ * @param  nr: The number of completions to consume.
+ * @retval None
+ */
+void io_uring_cq_advance(struct io_uring *ring, unsigned int nr);
+
+/**
+ * @brief  Execute the requests on the submission queue and post their
+ *         results to the completion queue
+ * @param  ring: The ring to provide.
+ * @retval int: The number of the executed requests on success and nonzero
+ *         error number on error.
+ */
+int io_uring_enter(struct io_uring *ring);
+
+#endif
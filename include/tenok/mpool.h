@@ -7,12 +7,60 @@
 #include <stddef.h>
 #include <stdint.h>
 
+/* Block size rounded up to hold the free list link and keep alignment */
+#define MPOOL_FIXED_BLK_SIZE(size)                                  \
+    ((((size) < sizeof(struct mpool_blk) ? sizeof(struct mpool_blk) \
+                                         : (size)) +                \
+      sizeof(void *) - 1) &                                         \
+     ~(sizeof(void *) - 1))
+
+/**
+ * @brief  Static initializer of the fixed-block memory pool
+ * @param  _mem: A contiguous and word-aligned memory space to provide.
+ * @param  _blk_size: The size of each block in bytes.
+ * @param  _blk_cnt: The number of the blocks.
+ */
+#define MPOOL_FIXED_INIT(_mem, _blk_size, _blk_cnt)  \
+    {                                                \
+        .free_list = NULL,                           \
+        .unused = 0,                                 \
+        .blk_size = MPOOL_FIXED_BLK_SIZE(_blk_size), \
+        .blk_cnt = (_blk_cnt),                       \
+        .mem = (uint8_t *) (_mem),                   \
+    }
+
+/**
+ * @brief  Define a fixed-block memory pool together with its storage
+ * @param  _name: The name of the memory pool object.
+ * @param  _blk_size: The size of each block in bytes.
+ * @param  _blk_cnt: The number of the blocks.
+ */
+#define MPOOL_FIXED_DEFINE(_name, _blk_size, _blk_cnt)                     \
+    static uint32_t _name##_mem[(MPOOL_FIXED_BLK_SIZE(_blk_size) *         \
+                                     (_blk_cnt) +                          \
+                                 sizeof(uint32_t) - 1) /                   \
+                                sizeof(uint32_t)];                         \
+    struct mpool_fixed _name =                                             \
+        MPOOL_FIXED_INIT(_name##_mem, _blk_size, _blk_cnt)
+
 struct mpool {
     int offset;
     size_t size;
     uint8_t *mem;
 };
 
+struct mpool_blk {
+    struct mpool_blk *next;
+};
+
+struct mpool_fixed {
+    struct mpool_blk *free_list; /* Blocks returned by mpool_fixed_free() */
+    uint32_t unused;             /* Index of the first never allocated block */
+    size_t blk_size;
+    size_t blk_cnt;
+    uint8_t *mem;
+};
+
 /**
  * @brief  Initialize a memory poll object with a contiguous memory space
  * @param  mem_pool: Pointer to the memory poll object.
@@ -28,4 +76,35 @@ void mpool_init(struct mpool *mpool, uint8_t *mem, size_t size);
  */
 void *mpool_alloc(struct mpool *mpool, size_t size);
 
+/**
+ * @brief  Initialize a fixed-block memory pool with a contiguous memory space
+ * @param  mpool: Pointer to the fixed-block memory pool object.
+ * @param  mem: A contiguous and word-aligned memory space to provide.
+ * @param  blk_size: The size of each block in bytes.
+ * @param  blk_cnt: The number of the blocks, the memory space should be
+ *         larger than MPOOL_FIXED_BLK_SIZE(blk_size) * blk_cnt bytes.
+ * @retval None
+ */
+void mpool_fixed_init(struct mpool_fixed *mpool,
+                      void *mem,
+                      size_t blk_size,
+                      size_t blk_cnt);
+
+/**
+ * @brief  Allocate a block from the fixed-block memory pool. The function
+ *         is lock-free and can be called from both threads and interrupts
+ * @param  mpool: Pointer to the fixed-block memory pool object.
+ * @retval void *: The allocated block, or NULL if the pool is exhausted.
+ */
+void *mpool_fixed_alloc(struct mpool_fixed *mpool);
+
+/**
+ * @brief  Return a block to the fixed-block memory pool. The function
+ *         is lock-free and can be called from both threads and interrupts
+ * @param  mpool: Pointer to the fixed-block memory pool object.
+ * @param  ptr: The block allocated by mpool_fixed_alloc().
+ * @retval None
+ */
+void mpool_fixed_free(struct mpool_fixed *mpool, void *ptr);
+
 #endif
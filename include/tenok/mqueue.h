@@ -4,10 +4,29 @@
 #ifndef __MQUEUE_H__
 #define __MQUEUE_H__
 
+#include <sys/limits.h>
 #include <sys/types.h>
 
 #include <common/list.h>
 
+/* Sizes of the kernel structures derived from their members. struct mqueue
+ * has the name, five word-sized fields, a bool padded to a word and
+ * MQ_PRIO_MAX + 5 list heads. struct mqueue_data has a list head, the
+ * size and the owner descriptor padded to a word. kernel/mqueue.c checks
+ * them at the build time */
+#define __SIZEOF_MQUEUE                                             \
+    (((NAME_MAX + sizeof(long) - 1) & ~(sizeof(long) - 1)) +        \
+     6 * sizeof(long) + (5 + _MQ_PRIO_MAX) * sizeof(struct list_head))
+#define __SIZEOF_MQUEUE_DATA                                         \
+    ((sizeof(struct list_head) + sizeof(size_t) + sizeof(uint32_t) + \
+      sizeof(long) - 1) &                                            \
+     ~(sizeof(long) - 1))
+
+/* Size of the memory to provide for mq_open_static() */
+#define MQ_STATIC_SIZE(maxmsg, msgsize) \
+    (__SIZEOF_MQUEUE +                  \
+     (maxmsg) * ((__SIZEOF_MQUEUE_DATA + (msgsize) + 3) & ~3))
+
 typedef uint32_t mqd_t;
 
 struct mq_attr {
@@ -48,12 +67,35 @@ int mq_setattr(mqd_t mqdes,
 mqd_t mq_open(const char *name, int oflag, struct mq_attr *attr);
 
 /**
- * @brief  Close the message queue descriptor
+ * @brief  Create a new message queue with statically allocated memory or open
+ *         an existing queue
+ * @param  name: The name of the message queue.
+ * @param  oflag: The flags for opening the message queue.
+ * @param  attr: The attribute object for setting the message queue.
+ * @param  mem: The word-aligned memory space to provide, the size should be
+ *         at least MQ_STATIC_SIZE(attr->mq_maxmsg, attr->mq_msgsize) bytes.
+ * @retval mqd_t: The message queue descriptor to return.
+ */
+mqd_t mq_open_static(const char *name,
+                     int oflag,
+                     struct mq_attr *attr,
+                     void *mem);
+
+/**
+ * @brief  Close the message queue descriptor. The message slots still lent
+ *         through the descriptor by mq_reserve() or mq_borrow() are returned
+ *         to the queue, and the pointers to them must no longer be used
  * @param  mqdes: The message queue descriptor to provide.
  * @retval int: 0 on success and nonzero error number on error.
  */
 int mq_close(mqd_t mqdes);
 
+/**
+ * @brief  Remove the message queue. The memory of the queue is released
+ *         together with the message slots still on loan
+ * @param  name: The name of the message queue.
+ * @retval int: 0 on success and nonzero error number on error.
+ */
 int mq_unlink(const char *name);
 
 /**
@@ -85,4 +127,50 @@ int mq_send(mqd_t mqdes,
             size_t msg_len,
             unsigned int msg_prio);
 
+/**
+ * @brief  Reserve a message slot from the message queue referred to by the
+ *         message queue descriptor mqdes. The message can then be written in
+ *         place and sent with mq_commit() without copying
+ * @param  mqdes: The message queue descriptor to provide.
+ * @param  msg_ptr: For returning the address of the reserved message slot,
+ *         which is mq_msgsize bytes long. It is valid until mq_commit(), or
+ *         until mqdes is closed or the queue is unlinked.
+ * @retval int: 0 on success and nonzero error number on error.
+ */
+int mq_reserve(mqd_t mqdes, void **msg_ptr);
+
+/**
+ * @brief  Send the message written in a slot reserved by mq_reserve()
+ * @param  mqdes: The message queue descriptor to provide.
+ * @param  msg_ptr: The message slot returned by mq_reserve().
+ * @param  msg_len: The size of the message in bytes.
+ * @param  msg_prio: The priority of the message to send.
+ * @retval int: 0 on success and nonzero error number on error.
+ */
+int mq_commit(mqd_t mqdes,
+              void *msg_ptr,
+              size_t msg_len,
+              unsigned int msg_prio);
+
+/**
+ * @brief  Remove the oldest message with highest priority from the message
+ *         queue and lend its slot to the caller without copying. The slot
+ *         must be returned with mq_release() after the message is consumed
+ * @param  mqdes: The message queue descriptor to provide.
+ * @param  msg_ptr: For returning the address of the received message. It
+ *         is valid until mq_release(), or until mqdes is closed or the queue
+ *         is unlinked.
+ * @param  msg_prio: The priority of the received message.
+ * @retval ssize_t: The size of the received message in bytes.
+ */
+ssize_t mq_borrow(mqd_t mqdes, void **msg_ptr, unsigned int *msg_prio);
+
+/**
+ * @brief  Return a message slot borrowed by mq_borrow() to the message queue
+ * @param  mqdes: The message queue descriptor to provide.
+ * @param  msg_ptr: The message slot returned by mq_borrow().
+ * @retval int: 0 on success and nonzero error number on error.
+ */
+int mq_release(mqd_t mqdes, void *msg_ptr);
+
 #endif
@@ -185,6 +185,28 @@ int pthread_create(pthread_t *thread,
                    void *(*start_routine)(void *),
                    void *arg);
 
+/**
+ * @brief  Start a new thread in the calling task with statically allocated
+ *         stack memory
+ * @param  thread: The thread ID of the new thread to return.
+ * @param  attr: The attribute object for configuring the new thread, the
+ *         stack settings of the object are ignored.
+ * @param  stack: The 8-byte aligned memory space of the stack to provide.
+ * @param  stack_size: The size of the stack memory in bytes, which must be a
+ *         multiple of 8 and no less than STACK_SIZE_MIN + STACK_GUARD_SIZE
+ *         as the stack guard is placed at the bottom of it.
+ * @param  start_routine: The function to be called after the thread is
+ *         launched.
+ * @param  arg: The sole argument of the start_routine to be provided.
+ * @retval int: 0 on success and nonzero error number on error.
+ */
+int pthread_create_static(pthread_t *thread,
+                          const pthread_attr_t *attr,
+                          void *stack,
+                          size_t stack_size,
+                          void *(*start_routine)(void *),
+                          void *arg);
+
 /**
  * @brief  Return the thread ID of the calling thread
  * @param  None
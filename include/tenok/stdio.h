@@ -15,12 +15,22 @@
 #define SEEK_CUR 1
 #define SEEK_END 2
 
+#define EOF (-1)
+
+#define BUFSIZ 128 /* Default buffer size of the file streams */
+
+#define _IOFBF 0 /* Fully buffered */
+#define _IOLBF 1 /* Line buffered */
+#define _IONBF 2 /* Unbuffered */
+
 #define fopen _fopen
 #define fclose _fclose
 #define fread _fread
 #define fwrite _fwrite
 #define fseek _fseek
 #define fileno _fileno
+#define fflush _fflush
+#define setvbuf _setvbuf
 
 #define __SIZEOF_FILE sizeof(__FILE)
 
@@ -43,7 +53,8 @@ extern FILE *stderr;
 FILE *fopen(const char *pathname, const char *mode);
 
 /**
- * @brief  Close the given file stream
+ * @brief  Close the given file stream. The buffered data is written before
+ *         closing
  * @param  stream: The file stream to provide.
  * @retval int: 0 on success and nonzero error number on error.
  */
@@ -72,6 +83,26 @@ size_t fread(void *ptr, size_t size, size_t nmemb, FILE *stream);
  */
 size_t fwrite(const void *ptr, size_t size, size_t nmemb, FILE *stream);
 
+/**
+ * @brief  Write out the buffered data of the stream, or discard the data read
+ *         ahead
+ * @param  stream: The file stream to provide. NULL flushes stdout and stderr.
+ * @retval int: 0 on success and EOF on error.
+ */
+int fflush(FILE *stream);
+
+/**
+ * @brief  Set the buffering mode of the stream. Should be called before any
+ *         other operation on the stream
+ * @param  stream: The file stream to provide.
+ * @param  buf: The buffer to use, or NULL to allocate one at the first access.
+ * @param  mode: _IOFBF for fully buffered, _IOLBF for line buffered, or
+ *         _IONBF for unbuffered.
+ * @param  size: The size of the buffer, BUFSIZ is used if it is 0.
+ * @retval int: 0 on success and EOF on error.
+ */
+int setvbuf(FILE *stream, char *buf, int mode, size_t size);
+
 /**
  * @brief  Set the file position indicator for the stream pointed to by stream
  * @param  stream: The file stream to provide.
@@ -0,0 +1,73 @@
+/**
+ * @file
+ */
+#ifndef __MMAN_H__
+#define __MMAN_H__
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#define PROT_NONE 0x0  /* Page can not be accessed */
+#define PROT_READ 0x1  /* Page can be read */
+#define PROT_WRITE 0x2 /* Page can be written */
+
+#define MAP_SHARED 0x1 /* Share changes with other mappings */
+
+#define MAP_FAILED ((void *) -1)
+
+/**
+ * @brief  Map the shared memory object or the regular file on the read-only
+ *         storage (e.g., romfs) referred to by the file descriptor fd into
+ *         the address space of the calling task. Files on the read-only
+ *         storage are mapped in place and must be mapped with PROT_READ only
+ * @param  addr: Ignored. The kernel always chooses the mapping address.
+ * @param  length: The length of the mapping in bytes. If USE_MMAP_MPU is
+ *         enabled, the mapping must form a valid MPU region to enforce the
+ *         protection, i.e., the length is a power of two of at least 32
+ *         bytes and the mapping address is aligned to it. Otherwise the
+ *         mapping fails.
+ * @param  prot: The memory protection of the mapping, i.e., PROT_NONE or
+ *         the bitwise OR of PROT_READ and PROT_WRITE.
+ * @param  flags: Must be MAP_SHARED.
+ * @param  fd: The file descriptor of the object to map.
+ * @param  offset: The offset of the mapping in the object.
+ * @retval void *: The address of the mapping on success and MAP_FAILED on
+ *         error.
+ */
+void *mmap(void *addr,
+           size_t length,
+           int prot,
+           int flags,
+           int fd,
+           off_t offset);
+
+/**
+ * @brief  Delete the mapping created by mmap()
+ * @param  addr: The address returned by mmap().
+ * @param  length: The length of the mapping in bytes.
+ * @retval int: 0 on success and nonzero error number on error.
+ */
+int munmap(void *addr, size_t length);
+
+/**
+ * @brief  Create or open a POSIX shared memory object. The size of the new
+ *         object is zero and should be set with ftruncate() before mapping
+ * @param  name: The name of the shared memory object.
+ * @param  oflag: The flags for opening the object, i.e., O_RDWR with optional
+ *         O_CREAT and O_EXCL.
+ * @param  mode: Not implemented.
+ * @retval int: The file descriptor of the object on success and nonzero error
+ *         number on error.
+ */
+int shm_open(const char *name, int oflag, mode_t mode);
+
+/**
+ * @brief  Remove the name of the shared memory object. The memory is freed
+ *         after all the descriptors are closed and all the mappings are
+ *         deleted
+ * @param  name: The name of the shared memory object.
+ * @retval int: 0 on success and nonzero error number on error.
+ */
+int shm_unlink(const char *name);
+
+#endif
@@ -5,9 +5,19 @@
 #define __REENT_H__
 
 #include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
 
 typedef struct {
     int fd;
+    int mode;      /* Buffering mode: _IOFBF, _IOLBF or _IONBF */
+    char *buf;     /* Stream buffer, allocated at the first access if NULL */
+    size_t size;   /* Size of the stream buffer */
+    size_t pos;    /* Position of the next byte to read from the buffer */
+    size_t len;    /* Number of the valid bytes in the buffer */
+    bool writing;  /* The buffer holds data not yet written */
+    bool own_buf;  /* The buffer is allocated by the stream */
+    bool seekable; /* Data read ahead can be given back with lseek() */
 } __FILE;
 
 #endif
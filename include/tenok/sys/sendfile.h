@@ -0,0 +1,26 @@
+/**
+ * @file
+ */
+#ifndef __SENDFILE_H__
+#define __SENDFILE_H__
+
+#include <stddef.h>
+#include <sys/types.h>
+
+/**
+ * @brief  Copy data from the file descriptor in_fd to the file descriptor
+ *         out_fd within the kernel. Files on the read-only storage (e.g.,
+ *         romfs) are written to out_fd directly from the storage
+ * @param  out_fd: The file descriptor to write to.
+ * @param  in_fd: The file descriptor to read from.
+ * @param  offset: If not NULL, the data is read from the offset it points
+ *         to, which is updated after the transfer, and the file offset of
+ *         in_fd is not changed. Otherwise the file offset of in_fd is used
+ *         and updated.
+ * @param  count: The max number of bytes to copy.
+ * @retval ssize_t: The number of bytes written to out_fd on success and
+ *         nonzero error number on error.
+ */
+ssize_t sendfile(int out_fd, int in_fd, off_t *offset, size_t count);
+
+#endif
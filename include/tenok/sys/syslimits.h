@@ -11,5 +11,6 @@
 #define PATH_MAX _PATH_MAX
 #define OPEN_MAX _OPEN_MAX
 #define LINE_MAX _LINE_MAX
+#define IOV_MAX _IOV_MAX
 
 #endif
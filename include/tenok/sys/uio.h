@@ -0,0 +1,37 @@
+/**
+ * @file
+ */
+#ifndef __UIO_H__
+#define __UIO_H__
+
+#include <stddef.h>
+#include <sys/types.h>
+
+struct iovec {
+    void *iov_base; /* Start address of the buffer */
+    size_t iov_len; /* Size of the buffer in bytes */
+};
+
+/**
+ * @brief  Read data from the file descriptor fd into multiple buffers. The
+ *         buffers are filled in the order of the array
+ * @param  fd: The file descriptor to provide.
+ * @param  iov: The array of the buffers.
+ * @param  iovcnt: The number of the buffers, which must not exceed IOV_MAX.
+ * @retval ssize_t: The total number of bytes read on success and nonzero
+ *         error number on error.
+ */
+ssize_t readv(int fd, const struct iovec *iov, int iovcnt);
+
+/**
+ * @brief  Write data from multiple buffers to the file descriptor fd with a
+ *         single call. The buffers are written in the order of the array
+ * @param  fd: The file descriptor to provide.
+ * @param  iov: The array of the buffers.
+ * @param  iovcnt: The number of the buffers, which must not exceed IOV_MAX.
+ * @retval ssize_t: The total number of bytes written on success and nonzero
+ *         error number on error.
+ */
+ssize_t writev(int fd, const struct iovec *iov, int iovcnt);
+
+#endif
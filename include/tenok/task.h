@@ -6,6 +6,8 @@
 
 #include <stdint.h>
 
+#include <arch/port.h>
+
 typedef void (*task_func_t)(void);
 typedef void (*thread_func_t)(void);
 
@@ -13,6 +15,7 @@ struct task_hook {
     task_func_t task_func;
     int priority;
     int stacksize;
+    void *stackaddr;
 };
 
 /**
@@ -30,6 +33,28 @@ struct task_hook {
             .stacksize = _stacksize,                      \
     }
 
+/**
+ * @brief  Register a user task with statically allocated stack memory to be
+ *         launched at the start of the system
+ * @param  task_func: The task function to run.
+ * @param  priority: The priority of the task.
+ * @param  stacksize: The stack size of the task, the stack guard is
+ *         allocated on top of it.
+ * @retval None
+ */
+#define HOOK_USER_TASK_STATIC(_task_func, _priority, _stacksize)   \
+    static uint32_t                                               \
+        _##_task_func##_stack[((_stacksize) + STACK_GUARD_SIZE) / \
+                              sizeof(uint32_t)]                   \
+        __attribute__((aligned(8)));                              \
+    static struct task_hook _##_task_func                         \
+        __attribute__((section(".tasks"), used)) = {              \
+            .task_func = _task_func,                              \
+            .priority = _priority,                                \
+            .stacksize = (_stacksize) + STACK_GUARD_SIZE,         \
+            .stackaddr = _##_task_func##_stack,                   \
+    }
+
 /**
  * @brief  Create new task
  * @param  task_func: The task function to run.
@@ -40,4 +65,20 @@ struct task_hook {
  */
 int task_create(task_func_t task_func, uint8_t priority, int stack_size);
 
+/**
+ * @brief  Create new task with statically allocated stack memory
+ * @param  task_func: The task function to run.
+ * @param  priority: The priority of the task.
+ * @param  stack: The 8-byte aligned memory space of the stack to provide.
+ * @param  stack_size: The stack size of the task, which must be a multiple
+ *         of 8 and no less than STACK_SIZE_MIN + STACK_GUARD_SIZE as the
+ *         stack guard is placed at the bottom of it.
+ * @retval int: The function returns positive task PID number on
+ *         success; otherwise it returns a negative error number.
+ */
+int task_create_static(task_func_t task_func,
+                       uint8_t priority,
+                       void *stack,
+                       int stack_size);
+
 #endif
@@ -18,17 +18,50 @@ struct thread_stat {
     char *status;
     bool kernel_thread;
     size_t stack_usage;
+    size_t stack_peak;
     size_t stack_size;
     char name[THREAD_NAME_MAX];
 };
 
+struct alloc_stat {
+    int type;
+    int tid;
+    void *caller;
+    size_t size;
+};
+
+struct kmsg_stat {
+    uint32_t seq;
+    uint32_t tv_sec;
+    uint32_t tv_nsec;
+    int level;
+    char text[PRINT_SIZE_MAX];
+};
+
 enum {
     PAGE_TOTAL_SIZE = 0,
     PAGE_FREE_SIZE = 1,
     HEAP_TOTAL_SIZE = 2,
-    HEAP_FREE_SIZE = 3
+    HEAP_FREE_SIZE = 3,
+    PAGE_PEAK_SIZE = 4,
+    HEAP_PEAK_SIZE = 5,
+    KMALLOC_USED_SIZE = 6,
+    KMALLOC_PEAK_SIZE = 7,
+    ALLOC_TRACE_DROPPED = 8,
+    BCACHE_HITS = 9,
+    BCACHE_MISSES = 10,
+    BCACHE_WRITEBACKS = 11,
+    BCACHE_DIRTY = 12,
+    PRINTK_LOST = 13
 } MINFO_NAMES;
 
+enum {
+    ALLOC_KMALLOC = 0,
+    ALLOC_PAGE = 1,
+    ALLOC_HEAP = 2,
+    ALLOC_TYPE_CNT
+} ALLOC_TYPES;
+
 /**
  * @brief  Start the operating system
  * @param  None
@@ -67,4 +100,25 @@ int delay_ticks(uint32_t ticks);
  */
 int minfo(int name);
 
+/**
+ * @brief  Get the live memory allocations iteratively. The records are only
+ *         available if USE_ALLOC_TRACE is enabled
+ * @param  info: For returning the allocation information.
+ * @param  next: The pointer to the next record. The initial argument should
+ *         be set with NULL.
+ * @retval void *: The pointer for continuing the iteration. The function
+ *         returns NULL without filling the info if no more record exists.
+ */
+void *alloc_trace_info(struct alloc_stat *info, void *next);
+
+/**
+ * @brief  Get the kernel messages kept in the log ring iteratively. The
+ *         messages are copied without formatting them again
+ * @param  msg: For returning the message.
+ * @param  seq: The sequence number to start from. The initial argument
+ *         should be set with 0, and the next one with msg->seq + 1.
+ * @retval int: 0 on success and -ENOENT if no more message exists.
+ */
+int kmsg_info(struct kmsg_stat *msg, uint32_t seq);
+
 #endif
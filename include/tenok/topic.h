@@ -0,0 +1,85 @@
+/**
+ * @file
+ */
+#ifndef __TOPIC_H__
+#define __TOPIC_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define TOPIC_CHECK_UPDATE 1 /* ioctl() command of topic_check() */
+
+#define TOPIC_ID(_name) (&__topic_##_name)
+
+#define TOPIC_DECLARE(_name) \
+    extern const struct topic_metadata __topic_##_name
+
+#define TOPIC_DEFINE(_name, _type, _queue_depth)    \
+    const struct topic_metadata __topic_##_name = { \
+        .name = #_name,                             \
+        .size = sizeof(_type),                      \
+        .queue_depth = _queue_depth,                \
+    }
+
+struct topic_metadata {
+    const char *name;         /* Name of the topic */
+    size_t size;              /* Size of the topic message in bytes */
+    unsigned int queue_depth; /* Number of the messages buffered */
+};
+
+/**
+ * @brief  Open a topic for reading or writing. The topic is created with
+ *         the given metadata if it does not exist yet
+ * @param  meta: The metadata of the topic, i.e., TOPIC_ID(name).
+ * @param  flags: O_RDONLY for subscribing or O_WRONLY for publishing.
+ * @retval int: The file descriptor of the topic on success and negative error
+ *         number on error.
+ */
+int topic_open(const struct topic_metadata *meta, int flags);
+
+/**
+ * @brief  Advertise a topic for publishing messages
+ * @param  meta: The metadata of the topic, i.e., TOPIC_ID(name).
+ * @retval int: The file descriptor of the topic on success and negative error
+ *         number on error.
+ */
+int topic_advertise(const struct topic_metadata *meta);
+
+/**
+ * @brief  Subscribe a topic. The returned file descriptor can be polled with
+ *         POLLIN for new messages and should be closed with close()
+ * @param  meta: The metadata of the topic, i.e., TOPIC_ID(name).
+ * @retval int: The file descriptor of the topic on success and negative error
+ *         number on error.
+ */
+int topic_subscribe(const struct topic_metadata *meta);
+
+/**
+ * @brief  Publish a new message to all the subscribers of the topic
+ * @param  meta: The metadata of the topic, i.e., TOPIC_ID(name).
+ * @param  fd: The file descriptor returned by topic_advertise().
+ * @param  data: The message to publish.
+ * @retval int: 0 on success and negative error number on error.
+ */
+int topic_publish(const struct topic_metadata *meta, int fd, const void *data);
+
+/**
+ * @brief  Copy the next unread message of the topic. The latest message is
+ *         copied again if no new message is published since the last copy
+ * @param  meta: The metadata of the topic, i.e., TOPIC_ID(name).
+ * @param  fd: The file descriptor returned by topic_subscribe().
+ * @param  data: For returning the message.
+ * @retval int: 0 on success and negative error number on error. -ENODATA is
+ *         returned if the topic has never been published.
+ */
+int topic_copy(const struct topic_metadata *meta, int fd, void *data);
+
+/**
+ * @brief  Check if the topic has unread messages without copying
+ * @param  fd: The file descriptor returned by topic_subscribe().
+ * @param  updated: For returning true if there are unread messages.
+ * @retval int: 0 on success and negative error number on error.
+ */
+int topic_check(int fd, bool *updated);
+
+#endif
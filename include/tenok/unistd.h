@@ -90,6 +90,23 @@ ssize_t write(int fd, const void *buf, size_t count);
  */
 off_t lseek(int fd, long offset, int whence);
 
+/**
+ * @brief  Truncate or extend the file referred to by the file descriptor fd
+ *         to the size of precisely length bytes
+ * @param  fd: The file descriptor to provide.
+ * @param  length: The new size of the file in bytes.
+ * @retval int: 0 on success and nonzero error number on error.
+ */
+int ftruncate(int fd, off_t length);
+
+/**
+ * @brief  Write the modified blocks held by the buffer cache to the
+ *         underlying storage devices
+ * @param  None
+ * @retval None
+ */
+void sync(void);
+
 /**
  * @brief  Return the ID of the calling task
  * @param  None
@@ -14,15 +14,24 @@
 #define PAGE_SIZE_64K 1 /* Use 64 KiB */
 #define PAGE_SIZE_SELECT PAGE_SIZE_64K
 
-/* Min stack size recommended for task and thread */
-#define STACK_SIZE_MIN 1024 /* Bytes */
-
-/* Daemons */
-#define INIT_STACK_SIZE 4096
-#define IDLE_STACK_SIZE 1024
-#define SOFTIRQD_STACK_SIZE 2048
-#define FILESYSD_STACK_SIZE 2048
-#define PRINTKD_STACK_SIZE 1024
+/* Memory allocation tracing */
+#define USE_ALLOC_TRACE 0   /* 1: Record live allocations, 0: Disable */
+#define ALLOC_TRACE_MAX 100 /* Max number of the recorded allocations */
+
+/* Min stack size recommended for task and thread. The file system calls
+ * (e.g., open() and getcwd()) run on the stack of the caller and take up
+ * to about 1 KiB with their PATH_MAX buffers. The stack guard is allocated
+ * on top of the size, and a statically allocated stack must be larger by
+ * STACK_GUARD_SIZE to hold it */
+#define STACK_SIZE_MIN 2048 /* Bytes */
+
+/* Daemons, sized to fit the stack guard into the power-of-two pages */
+#define INIT_STACK_SIZE (4096 - STACK_GUARD_SIZE)
+#define IDLE_STACK_SIZE (1024 - STACK_GUARD_SIZE)
+#define SOFTIRQD_STACK_SIZE (2048 - STACK_GUARD_SIZE)
+#define PRINTKD_STACK_SIZE (2048 - STACK_GUARD_SIZE)
+#define AIOD_STACK_SIZE (2048 - STACK_GUARD_SIZE)
+#define AIOD_CNT 2 /* Number of the AIO daemons */
 
 /* Task */
 #define TASK_MAX 64 /* Max number of tasks in the system */
@@ -36,10 +45,17 @@
 #define MQUEUE_MAX 50  /* Max number of message queue can be allocated */
 #define _MQ_PRIO_MAX 5 /* Max message queue priority number */
 
-/* Pipe size. Note that if the size is too small, the file system daemon *
- * may not work properly                                                 */
+/* Pipe size */
 #define _PIPE_BUF 100 /* Bytes */
 
+/* Default buffer size of the named pipes, which is rounded up to the page *
+ * size. Can be changed with fcntl(F_SETPIPE_SZ) after opening             */
+#define FIFO_SIZE_DEFAULT 256 /* Bytes */
+
+/* Shared memory */
+#define MMAP_MAX 4     /* Max number of the memory mappings a task can have */
+#define USE_MMAP_MPU 0 /* 1: Enforce mapping permissions with the MPU */
+
 /* Signals */
 #define SIGNAL_QUEUE_SIZE 5
 
@@ -50,17 +66,43 @@
 
 #define PRINT_SIZE_MAX 100 /* Buffer size of the printf and printk */
 
-#define USE_TENOK_PRINTF 0 /* 1: Use Tenok printf, 0: Use NewlibC printf */
+/* Kernel log */
+#define PRINTK_LOG_SIZE 2048   /* Bytes of the log ring, power of 2 */
+#define PRINTK_LEVEL 6         /* Max level of the messages compiled in */
+#define PRINTK_CONSOLE_LEVEL 6 /* Max level of the messages on the console */
+
+#define USE_TENOK_PRINTF 1 /* 1: Use Tenok printf, 0: Use NewlibC printf */
 
 /* File system */
-#define _NAME_MAX 30    /* Max length of files in bytes */
-#define _PATH_MAX 128   /* Max length of pathname in bytes */
-#define _OPEN_MAX 100   /* Max number of files a task can open */
-#define FILE_MAX 100    /* Max number of the files can be created */
-#define MOUNT_MAX 5     /* Max number of storages can be mounted */
-#define INODE_MAX 100   /* Max number of the inode can have */
-#define FS_BLK_SIZE 128 /* Block size of the file system in bytes */
-#define FS_BLK_CNT 100  /* Block number of the file system */
+#define _NAME_MAX 30        /* Max length of files in bytes */
+#define _PATH_MAX 128       /* Max length of pathname in bytes */
+#define _OPEN_MAX 16        /* Max number of files a task can open (<= 32) */
+#define FDTABLE_MAX 100     /* Open file descriptions of all tasks */
+#define _IOV_MAX 8          /* Max number of buffers of readv() and writev() */
+#define SPLICE_BUF_SIZE 256 /* Buffer size of sendfile() and splice() */
+#define FILE_MAX 100        /* Max number of the files can be created */
+#define MOUNT_MAX 5         /* Max number of storages can be mounted */
+#define INODE_MAX 100       /* Max number of the inode can have */
+#define FS_BLK_SIZE 128     /* Block size of the file system in bytes */
+#define FS_BLK_CNT 100      /* Block number of the file system */
+#define DCACHE_SIZE 32      /* Number of the cached path lookups */
+#define DCACHE_HASH_SIZE 16 /* Hash buckets of the dentry cache, power of 2 */
+
+/* Log-structured file system */
+#define USE_LOGFS 0               /* Mount the logfs storage at boot */
+#define LOGFS_DEV_PATH "/dev/ram" /* /dev/ram or /dev/flash */
+#define LOGFS_MOUNT_PATH "/flash" /* Mount point of the logfs */
+#define LOGFS_FILE_MAX 8          /* Max number of logfs files (<= 255) */
+#define RAMDISK_BLK_SIZE 4096     /* Erase block size of /dev/ram */
+#define RAMDISK_BLK_CNT 0         /* Erase blocks of /dev/ram, 0 to disable */
+#define FLASH_LOGFS_SECTORS 0     /* 128K sectors of /dev/flash (<= 7) */
+
+/* Block device layer */
+#define MEMDISK_SIZE 0        /* Size of /dev/memdisk in bytes, 0 to disable */
+#define MEMDISK_QUEUE_DEPTH 4 /* Requests /dev/memdisk processes at once */
+#define BCACHE_BLK_SIZE 256   /* Block size of the buffer cache in bytes */
+#define BCACHE_BLK_CNT 8      /* Cached blocks shared by all block devices */
+#define BCACHE_HASH_SIZE 8    /* Hash buckets of the buffer cache, power of 2 */
 
 /* Shell */
 #define _LINE_MAX 50
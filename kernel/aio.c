@@ -0,0 +1,237 @@
+#include <aio.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <tenok.h>
+
+#include <arch/port.h>
+#include <common/list.h>
+#include <kernel/aio.h>
+#include <kernel/daemon.h>
+#include <kernel/errno.h>
+#include <kernel/kernel.h>
+#include <kernel/preempt.h>
+#include <kernel/sched.h>
+#include <kernel/syscall.h>
+#include <kernel/thread.h>
+#include <kernel/wait.h>
+#include <mm/mm.h>
+
+static LIST_HEAD(aio_queue);     /* Requests waiting for the daemons */
+static LIST_HEAD(aio_running);   /* Requests being executed by the daemons */
+static LIST_HEAD(aiod_wait);     /* The daemons waiting for requests */
+static LIST_HEAD(aio_done_wait); /* Threads waiting in aio_suspend() */
+
+void aio_submit(struct aio_request *req)
+{
+    struct aiocb *aiocbp = req->aiocbp;
+
+    /* Copy the request as the control block may be gone with the stack of
+     * the submitting thread while a daemon is still executing it */
+    req->opcode = aiocbp->aio_lio_opcode;
+    req->buf = (char *) aiocbp->aio_buf;
+    req->nbytes = aiocbp->aio_nbytes;
+    req->offset = aiocbp->aio_offset;
+    req->orphan = false;
+
+    aiocbp->__error = EINPROGRESS;
+    aiocbp->__return = 0;
+
+    /* Requests of a file are executed in the order of submission */
+    list_add(&req->list, &aio_queue);
+    wake_up_all(&aiod_wait);
+}
+
+void aio_thread_exit(uint16_t tid)
+{
+    struct list_head *curr, *next;
+
+    /* Cancel the queued requests of the thread. The control blocks are still
+     * valid as the thread stack is not freed yet */
+    list_for_each_safe (curr, next, &aio_queue) {
+        struct aio_request *req = list_entry(curr, struct aio_request, list);
+        if (req->tid != tid)
+            continue;
+
+        req->aiocbp->__return = -1;
+        req->aiocbp->__error = ECANCELED;
+        list_del(&req->list);
+        kfree(req);
+        wake_up_all(&aio_done_wait);
+    }
+
+    /* The requests in execution can not be aborted, their results are
+     * discarded instead */
+    struct aio_request *req;
+    list_for_each_entry (req, &aio_running, list) {
+        if (req->tid == tid)
+            req->orphan = true;
+    }
+}
+
+bool aio_any_done(const struct aiocb *const list[], int nent)
+{
+    for (int i = 0; i < nent; i++) {
+        if (list[i] && list[i]->__error != EINPROGRESS)
+            return true;
+    }
+
+    return false;
+}
+
+void aio_prepare_to_wait(void)
+{
+    prepare_to_wait(&aio_done_wait, current_thread_info(), THREAD_WAIT);
+}
+
+static ssize_t aio_execute(struct aio_request *req)
+{
+    struct file *filp = req->filp;
+    ssize_t retval;
+
+    /* Access at the requested offset without moving the file offset */
+    bool positional = req->opcode == LIO_READ ? filp->f_op->pread != NULL
+                                              : filp->f_op->pwrite != NULL;
+
+    /* Otherwise move to the requested offset if the file is seekable */
+    if (!positional && filp->f_op->lseek) {
+        retval = filp->f_op->lseek(filp, req->offset, SEEK_SET);
+        if (retval < 0)
+            return retval;
+    }
+
+    /* Pass the flags of the open file description to the file operation */
+    CURRENT_THREAD_INFO(curr_thread);
+    curr_thread->file_flags = req->flags;
+
+    /* Call the file operation like read() and write() do, the daemon sleeps
+     * instead of the submitting thread */
+    while (1) {
+        if (positional && req->opcode == LIO_READ)
+            retval = filp->f_op->pread(filp, req->buf, req->nbytes,
+                                       req->offset);
+        else if (positional)
+            retval = filp->f_op->pwrite(filp, req->buf, req->nbytes,
+                                        req->offset);
+        else if (req->opcode == LIO_READ)
+            retval = filp->f_op->read(filp, req->buf, req->nbytes, 0);
+        else
+            retval = filp->f_op->write(filp, req->buf, req->nbytes, 0);
+
+        if (retval != -ERESTARTSYS)
+            break;
+
+        schedule();
+    }
+
+    return retval;
+}
+
+static bool aio_file_busy(struct file *filp)
+{
+    struct aio_request *req;
+    list_for_each_entry (req, &aio_running, list) {
+        if (req->filp == filp)
+            return true;
+    }
+
+    return false;
+}
+
+static struct aio_request *aio_dequeue(void)
+{
+    /* Pop the oldest request whose file is not in use by another daemon, so
+     * the requests of a file are still executed one by one in order while a
+     * blocking file does not hold up the others */
+    struct aio_request *req;
+    list_for_each_entry (req, &aio_queue, list) {
+        if (!aio_file_busy(req->filp)) {
+            list_move(&req->list, &aio_running);
+            return req;
+        }
+    }
+
+    return NULL;
+}
+
+static void aio_complete(struct aio_request *req, ssize_t retval)
+{
+    struct aiocb *aiocbp = req->aiocbp;
+
+    preempt_disable();
+
+    list_del(&req->list);
+
+    /* Skip the control block if the submitting thread has exited, it may
+     * be gone with the thread stack */
+    if (!req->orphan) {
+        /* Publish the result and wake up the threads in aio_suspend() */
+        aiocbp->__return = retval;
+        aiocbp->__error = (retval < 0) ? -retval : 0;
+        wake_up_all(&aio_done_wait);
+
+        /* Notify the submitting thread */
+        struct thread_info *thread = acquire_thread(req->tid);
+        if (aiocbp->aio_sigevent.sigev_notify == SIGEV_SIGNAL && thread)
+            thread_signal(thread, aiocbp->aio_sigevent.sigev_signo);
+    }
+
+    /* The next request of the file can be executed now */
+    if (!list_empty(&aio_queue))
+        wake_up_all(&aiod_wait);
+
+    preempt_enable();
+}
+
+void aiod(void)
+{
+    setprogname("aiod");
+    set_daemon_id(AIOD);
+
+    while (1) {
+        preempt_disable();
+
+        /* Check if there is any request to execute */
+        struct aio_request *req = aio_dequeue();
+        if (!req) {
+            /* No, suspend the daemon. The request queue is checked with the
+             * preemption disabled so the wake up can not be missed */
+            prepare_to_wait(&aiod_wait, current_thread_info(), THREAD_WAIT);
+            preempt_enable();
+            schedule();
+            continue;
+        }
+
+        preempt_enable();
+
+        aio_complete(req, aio_execute(req));
+        kfree(req);
+    }
+}
+
+NACKED int aio_read(struct aiocb *aiocbp)
+{
+    SYSCALL(AIO_READ);
+}
+
+NACKED int aio_write(struct aiocb *aiocbp)
+{
+    SYSCALL(AIO_WRITE);
+}
+
+NACKED int aio_suspend(const struct aiocb *const list[],
+                       int nent,
+                       const struct timespec *timeout)
+{
+    SYSCALL(AIO_SUSPEND);
+}
+
+int aio_error(const struct aiocb *aiocbp)
+{
+    return aiocbp->__error;
+}
+
+ssize_t aio_return(struct aiocb *aiocbp)
+{
+    return aiocbp->__return;
+}
@@ -14,6 +14,24 @@
 #define THREAD_PSP 0xFFFFFFFD
 #define INITIAL_XPSR 0x01000000
 
+/* MPU region size encoding: size = 2^(SIZE + 1) bytes */
+#define MPU_REGION_SIZE_32B (4 << MPU_RASR_SIZE_Pos)
+#define MPU_REGION_SIZE_512M (28 << MPU_RASR_SIZE_Pos)
+#define MPU_REGION_SIZE_1G (29 << MPU_RASR_SIZE_Pos)
+
+/* MPU access permission encoding */
+#define MPU_AP_NO_ACCESS (0 << MPU_RASR_AP_Pos)
+#define MPU_AP_FULL_ACCESS (3 << MPU_RASR_AP_Pos)
+#define MPU_AP_READ_ONLY (6 << MPU_RASR_AP_Pos)
+
+/* MemManage fault status bits of the CFSR */
+#define MMFSR_MSTKERR (1 << 4)
+#define MMFSR_MMARVALID (1 << 7)
+
+/* The minimal region size of the ARMv7-M MPU, the guard region is placed
+ * inside the STACK_GUARD_SIZE bytes reserved at the bottom of the stack */
+#define STACK_GUARD_REGION_SIZE 32
+
 #define FAULT_DUMP(type)                  \
     do {                                  \
         asm volatile(                     \
@@ -32,6 +50,16 @@ enum {
     USAGE_FAULT = 3,
 };
 
+enum {
+    MPU_REGION_MEMORY = 0,      /* Flash, CCM RAM, system memory and SRAM */
+    MPU_REGION_EXTERNAL = 1,    /* External memory of the FMC, e.g., SDRAM */
+    MPU_REGION_PERIPHERAL = 2,  /* On-chip peripherals */
+    MPU_REGION_USER = 3,        /* Memory mappings of the user, 3 to 6 */
+    MPU_REGION_STACK_GUARD = 7, /* Highest priority region */
+};
+
+static uint32_t stack_guard_start;
+
 struct context {
     /* Pushed by the OS */
     uint32_t r4_to_r11[8]; /* R4, ..., R11 */
@@ -129,6 +157,112 @@ void __stack_init(uint32_t **stack_top,
      */
 }
 
+static void mpu_region_config(uint32_t region, uint32_t base, uint32_t attr)
+{
+    MPU->RNR = region;
+    MPU->RBAR = base;
+    MPU->RASR = attr;
+}
+
+static void mpu_init(void)
+{
+    /* Unprivileged threads can only access the memory covered by the
+     * regions, hence grant full access to the memory map used by Tenok.
+     * The code and the SRAM share one region to leave a region for the
+     * external memory */
+    mpu_region_config(MPU_REGION_MEMORY, 0x00000000,
+                      MPU_AP_FULL_ACCESS | MPU_RASR_S_Msk | MPU_RASR_C_Msk |
+                          MPU_RASR_B_Msk | MPU_REGION_SIZE_1G |
+                          MPU_RASR_ENABLE_Msk);
+
+    /* SDRAM banks of the FMC (e.g., .sdram of stm32f429disc at 0xD0000000).
+     * Boards without the external memory still fault on the bus */
+    mpu_region_config(MPU_REGION_EXTERNAL, 0xC0000000,
+                      MPU_AP_FULL_ACCESS | MPU_RASR_S_Msk | MPU_RASR_C_Msk |
+                          MPU_RASR_B_Msk | MPU_REGION_SIZE_512M |
+                          MPU_RASR_ENABLE_Msk);
+    mpu_region_config(MPU_REGION_PERIPHERAL, 0x40000000,
+                      MPU_AP_FULL_ACCESS | MPU_RASR_XN_Msk | MPU_RASR_S_Msk |
+                          MPU_RASR_B_Msk | MPU_REGION_SIZE_512M |
+                          MPU_RASR_ENABLE_Msk);
+
+    /* The user regions and the stack guard region are enabled before
+     * jumping to a thread */
+    for (int i = 0; i < MPU_USER_REGION_CNT; i++) {
+        mpu_region_config(MPU_REGION_USER + i, 0, 0);
+    }
+    mpu_region_config(MPU_REGION_STACK_GUARD, 0, 0);
+
+    /* Enable the MPU with the default memory map as the privileged
+     * background region */
+    MPU->CTRL = MPU_CTRL_PRIVDEFENA_Msk | MPU_CTRL_ENABLE_Msk;
+
+    /* Report MPU violations with MemManage fault instead of hard fault */
+    SCB->SHCSR |= SCB_SHCSR_MEMFAULTENA_Msk;
+
+    __DSB();
+    __ISB();
+}
+
+void __stack_guard_enable(void *stack)
+{
+    /* The region base address must be aligned to the region size */
+    stack_guard_start = ((uintptr_t) stack + STACK_GUARD_REGION_SIZE - 1) &
+                        ~(STACK_GUARD_REGION_SIZE - 1);
+
+    /* Any access to the lowest part of the stack triggers MemManage fault */
+    mpu_region_config(MPU_REGION_STACK_GUARD, stack_guard_start,
+                      MPU_AP_NO_ACCESS | MPU_RASR_XN_Msk |
+                          MPU_REGION_SIZE_32B | MPU_RASR_ENABLE_Msk);
+
+    __DSB();
+    __ISB();
+}
+
+void __stack_guard_disable(void)
+{
+    MPU->RNR = MPU_REGION_STACK_GUARD;
+    MPU->RASR &= ~MPU_RASR_ENABLE_Msk;
+
+    __DSB();
+    __ISB();
+}
+
+void __mpu_user_region_enable(int idx,
+                              void *base,
+                              size_t size,
+                              bool readable,
+                              bool writable)
+{
+    /* Encode the region size as 2^(SIZE + 1) bytes */
+    uint32_t size_bits = (__builtin_ctz(size) - 1) << MPU_RASR_SIZE_Pos;
+
+    uint32_t ap;
+    if (writable)
+        ap = MPU_AP_FULL_ACCESS;
+    else if (readable)
+        ap = MPU_AP_READ_ONLY;
+    else
+        ap = MPU_AP_NO_ACCESS;
+
+    /* The region overrides the SRAM region with higher priority */
+    mpu_region_config(MPU_REGION_USER + idx, (uintptr_t) base,
+                      ap | MPU_RASR_XN_Msk | MPU_RASR_S_Msk | MPU_RASR_C_Msk |
+                          MPU_RASR_B_Msk | size_bits | MPU_RASR_ENABLE_Msk);
+
+    __DSB();
+    __ISB();
+}
+
+void __mpu_user_region_disable(int idx)
+{
+    MPU->RNR = MPU_REGION_USER + idx;
+    MPU->RASR &= ~MPU_RASR_ENABLE_Msk;
+
+    __DSB();
+    __ISB();
+}
+
 void __platform_init(void)
 {
     /* Priority range of group 4 is 0-15 */
@@ -140,6 +274,9 @@ void __platform_init(void)
     NVIC_SetPriority(SVCall_IRQn, 15);
     NVIC_SetPriority(PendSV_IRQn, 15);
 
+    /* Enable MPU for guarding thread stacks */
+    mpu_init();
+
     /* Enable SysTick timer */
     SysTick_Config(SystemCoreClock / OS_TICK_FREQ);
 
@@ -165,6 +302,23 @@ unsigned long get_syscall_num(void *sp)
     return syscall_num;
 }
 
+unsigned long get_syscall_caller(void *sp)
+{
+    uint32_t lr = ((uint32_t *) sp)[8];
+    unsigned long caller;
+
+    /* EXC_RETURN[4]: 0 = FPU used / 1 = FPU unused */
+    if (lr & 0x10) {
+        struct context *context = (struct context *) sp;
+        caller = context->r12_lr_pc_xpsr[1];
+    } else {
+        struct context_fpu *context = (struct context_fpu *) sp;
+        caller = context->r12_lr_pc_xpsr[1];
+    }
+
+    return caller;
+}
+
 void get_syscall_args(void *sp, unsigned long *pargs[4])
 {
     uint32_t lr = ((uint32_t *) sp)[8];
@@ -219,6 +373,21 @@ void fault_dump(uint32_t fault_type, uint32_t *msp, uint32_t *psp, uint32_t lr)
 {
     CURRENT_THREAD_INFO(curr_thread);
 
+    /* Check if the MPU fault is caused by touching the stack guard region.
+     * Note that the fault address is not provided if the exception entry
+     * failed to push the registers to the overflowed stack */
+    bool stack_overflow = false;
+    if (fault_type == MPU_FAULT) {
+        uint32_t mmfsr = SCB->CFSR & SCB_CFSR_MEMFAULTSR_Msk;
+        bool guard_touched =
+            (mmfsr & MMFSR_MMARVALID) && SCB->MMFAR >= stack_guard_start &&
+            SCB->MMFAR < stack_guard_start + STACK_GUARD_REGION_SIZE;
+        stack_overflow = (mmfsr & MMFSR_MSTKERR) || guard_touched;
+
+        /* Disable the MPU to dump the faulting stack */
+        MPU->CTRL = 0;
+    }
+
     char *fault_location = "";
     uint32_t *fault_stack = NULL;
 
@@ -239,7 +408,13 @@ void fault_dump(uint32_t fault_type, uint32_t *msp, uint32_t *psp, uint32_t lr)
         fault_type_s = "\r================ HARD FAULT ==================\n\r";
         break;
     case MPU_FAULT:
-        fault_type_s = "\r================= MPU FAULT ==================\n\r";
+        if (stack_overflow) {
+            fault_type_s =
+                "\r=============== STACK OVERFLOW ===============\n\r";
+        } else {
+            fault_type_s =
+                "\r================= MPU FAULT ==================\n\r";
+        }
         break;
     case BUS_FAULT:
         fault_type_s = "\r================= BUS FAULT ==================\n\r";
@@ -1,8 +1,11 @@
 #include <dirent.h>
+#include <fcntl.h>
 #include <poll.h>
 #include <stddef.h>
+#include <sys/sendfile.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 
 #include <arch/port.h>
 #include <kernel/syscall.h>
@@ -17,6 +20,11 @@ NACKED int open(const char *pathname, int flags)
     SYSCALL(OPEN);
 }
 
+NACKED int fcntl(int fd, int cmd, ...)
+{
+    SYSCALL(FCNTL);
+}
+
 NACKED int _close(int fd)
 {
     SYSCALL(CLOSE);
@@ -57,6 +65,21 @@ ssize_t write(int fd, const void *buf, size_t count)
     return _write(fd, buf, count);
 }
 
+NACKED ssize_t readv(int fd, const struct iovec *iov, int iovcnt)
+{
+    SYSCALL(READV);
+}
+
+NACKED ssize_t writev(int fd, const struct iovec *iov, int iovcnt)
+{
+    SYSCALL(WRITEV);
+}
+
+NACKED ssize_t sendfile(int out_fd, int in_fd, off_t *offset, size_t count)
+{
+    SYSCALL(SENDFILE);
+}
+
 NACKED int ioctl(int fd, unsigned int cmd, unsigned long arg)
 {
     SYSCALL(IOCTL);
@@ -72,6 +95,16 @@ long lseek(int fd, long offset, int whence)
     return _lseek(fd, offset, whence);
 }
 
+NACKED int ftruncate(int fd, off_t length)
+{
+    SYSCALL(FTRUNCATE);
+}
+
+NACKED void sync(void)
+{
+    SYSCALL(SYNC);
+}
+
 NACKED int _fstat(int fd, struct stat *statbuf)
 {
     SYSCALL(FSTAT);
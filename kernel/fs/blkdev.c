@@ -0,0 +1,264 @@
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <common/list.h>
+#include <fs/blkdev.h>
+#include <fs/buffer.h>
+#include <fs/fs.h>
+#include <kernel/preempt.h>
+#include <kernel/sched.h>
+#include <kernel/thread.h>
+#include <kernel/wait.h>
+
+static struct file_operations blkdev_file_ops;
+
+static bool blk_conflict(struct blk_request *a, struct blk_request *b)
+{
+    /* Reads can be reordered freely */
+    if (a->dir == BLK_READ && b->dir == BLK_READ)
+        return false;
+
+    /* Otherwise the order matters if the ranges overlap */
+    return a->offset < b->offset + (off_t) b->total &&
+           b->offset < a->offset + (off_t) a->total;
+}
+
+static bool blk_try_merge(struct blk_dev *dev, struct blk_request *req)
+{
+    /* Search from the tail since merging places the request at the position
+     * of the pending one, which must not be ahead of any conflicting one */
+    struct blk_request *pending;
+    for (pending = list_entry(dev->queue.prev, struct blk_request, list);
+         !list_entry_is_head(pending, &dev->queue, list);
+         pending = list_prev_entry(pending, list)) {
+        if (blk_conflict(pending, req))
+            return false;
+
+        if (pending->dir != req->dir ||
+            pending->total + req->size > dev->max_size)
+            continue;
+
+        /* The request continues the pending one */
+        if (pending->offset + pending->total == req->offset) {
+            list_add(&req->list, &pending->segments);
+            pending->total += req->size;
+            return true;
+        }
+
+        /* The request precedes the pending one and replaces it in the queue
+         * with the pending one and its segments chained behind */
+        if (req->offset + req->size == pending->offset) {
+            list_add(&req->list, &pending->list);
+            list_del(&pending->list);
+            list_add(&pending->list, &req->segments);
+
+            struct list_head *curr, *next;
+            list_for_each_safe (curr, next, &pending->segments)
+                list_move(curr, &req->segments);
+            INIT_LIST_HEAD(&pending->segments);
+
+            req->total += pending->total;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void blk_insert(struct blk_dev *dev, struct blk_request *req)
+{
+    /* Keep the queue sorted by offset so the device is swept in one
+     * direction, but never move the request ahead of a conflicting one,
+     * e.g., a read of the data still to be written */
+    struct list_head *pos = &dev->queue;
+    struct blk_request *pending;
+    for (pending = list_entry(dev->queue.prev, struct blk_request, list);
+         !list_entry_is_head(pending, &dev->queue, list);
+         pending = list_prev_entry(pending, list)) {
+        if (pending->offset <= req->offset || blk_conflict(pending, req))
+            break;
+
+        pos = &pending->list;
+    }
+
+    list_add(&req->list, pos);
+}
+
+static void blk_dispatch(struct blk_dev *dev)
+{
+    /* The driver may complete the request inside the submit function, which
+     * should not dispatch recursively */
+    if (dev->dispatching)
+        return;
+
+    dev->dispatching = true;
+
+    while (!dev->plug_cnt && dev->inflight < dev->max_inflight &&
+           !list_empty(&dev->queue)) {
+        struct blk_request *req =
+            list_first_entry(&dev->queue, struct blk_request, list);
+        list_del(&req->list);
+        dev->inflight++;
+
+        int retval = dev->submit(dev, req);
+        if (retval < 0)
+            blk_end_request(dev, req, retval);
+    }
+
+    dev->dispatching = false;
+}
+
+static void blk_complete(struct blk_request *req, int status)
+{
+    req->status = status;
+
+    if (req->end_io)
+        req->end_io(req);
+}
+
+void blk_submit(struct blk_dev *dev, struct blk_request *req)
+{
+    req->total = req->size;
+    INIT_LIST_HEAD(&req->segments);
+
+    /* The request must be inside the device */
+    if (req->offset < 0 || req->offset + req->size > dev->size) {
+        blk_complete(req, -EFAULT);
+        return;
+    }
+
+    req->status = -EINPROGRESS;
+
+    preempt_disable();
+
+    if (!blk_try_merge(dev, req))
+        blk_insert(dev, req);
+
+    blk_dispatch(dev);
+
+    preempt_enable();
+}
+
+void blk_plug(struct blk_dev *dev)
+{
+    preempt_disable();
+    dev->plug_cnt++;
+    preempt_enable();
+}
+
+void blk_unplug(struct blk_dev *dev)
+{
+    preempt_disable();
+    dev->plug_cnt--;
+    blk_dispatch(dev);
+    preempt_enable();
+}
+
+void blk_end_request(struct blk_dev *dev, struct blk_request *req, int status)
+{
+    preempt_disable();
+
+    dev->inflight--;
+
+    /* Complete the merged segments first, the callbacks may release the
+     * memory of the requests */
+    struct list_head *curr, *next;
+    list_for_each_safe (curr, next, &req->segments)
+        blk_complete(list_entry(curr, struct blk_request, list), status);
+    blk_complete(req, status);
+
+    /* Wake up the threads waiting in blk_wait() */
+    wake_up_all(&dev->wait_list);
+
+    /* Start the next request */
+    blk_dispatch(dev);
+
+    preempt_enable();
+}
+
+int blk_wait(struct blk_dev *dev, struct blk_request *req)
+{
+    CURRENT_THREAD_INFO(curr_thread);
+
+    while (1) {
+        preempt_disable();
+
+        /* Check the status with the interrupts disabled so the completion
+         * can not be missed */
+        if (req->status != -EINPROGRESS)
+            break;
+
+        prepare_to_wait(&dev->wait_list, curr_thread, THREAD_WAIT);
+        preempt_enable();
+
+        schedule();
+    }
+
+    preempt_enable();
+
+    return req->status;
+}
+
+int blk_rw(struct blk_dev *dev, int dir, char *buf, size_t size, off_t offset)
+{
+    struct blk_request req = {
+        .dir = dir,
+        .offset = offset,
+        .size = size,
+        .buf = buf,
+    };
+
+    blk_submit(dev, &req);
+
+    return blk_wait(dev, &req);
+}
+
+static ssize_t blkdev_read(struct file *filp,
+                           char *buf,
+                           size_t size,
+                           off_t offset)
+{
+    /* Go through the buffer cache so the device file stays coherent with
+     * the mounted file system */
+    return bcache_read(filp, buf, size, offset);
+}
+
+static ssize_t blkdev_write(struct file *filp,
+                            const char *buf,
+                            size_t size,
+                            off_t offset)
+{
+    return bcache_write(filp, buf, size, offset);
+}
+
+static int blkdev_open(struct inode *inode, struct file *file)
+{
+    return 0;
+}
+
+static struct file_operations blkdev_file_ops = {
+    .read = blkdev_read,
+    .write = blkdev_write,
+    .open = blkdev_open,
+};
+
+struct blk_dev *blkdev_from_file(struct file *filp)
+{
+    if (!filp || filp->f_op != &blkdev_file_ops)
+        return NULL;
+
+    return container_of(filp, struct blk_dev, file);
+}
+
+int blkdev_register(char *name, struct blk_dev *dev)
+{
+    INIT_LIST_HEAD(&dev->queue);
+    init_waitqueue_head(&dev->wait_list);
+    dev->inflight = 0;
+    dev->plug_cnt = 0;
+    dev->dispatching = false;
+    dev->file.f_op = &blkdev_file_ops;
+
+    return register_blkdev_file(name, &dev->file);
+}
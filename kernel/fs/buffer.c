@@ -0,0 +1,218 @@
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <common/list.h>
+#include <fs/blkdev.h>
+#include <fs/buffer.h>
+#include <fs/fs.h>
+#include <kernel/mutex.h>
+
+#include "kconfig.h"
+
+/* Cached block of a block device */
+struct buffer_head {
+    struct blk_dev *b_dev; /* NULL if the buffer is unused */
+    uint32_t b_blocknr;
+    bool b_dirty;
+    struct list_head b_hash; /* Entry of the hash bucket */
+    struct list_head b_lru;  /* Entry of the LRU list */
+    char b_data[BCACHE_BLK_SIZE];
+};
+
+static struct buffer_head bcache[BCACHE_BLK_CNT];
+static struct list_head bcache_hash[BCACHE_HASH_SIZE];
+static LIST_HEAD(bcache_lru); /* Least recently used buffer first */
+
+static struct bcache_stat bcache_stat;
+
+/* Serialize the cache accesses, which may sleep on the device I/O */
+static struct mutex bcache_mtx;
+
+void bcache_init(void)
+{
+    mutex_init(&bcache_mtx);
+
+    for (int i = 0; i < BCACHE_HASH_SIZE; i++)
+        INIT_LIST_HEAD(&bcache_hash[i]);
+
+    for (int i = 0; i < BCACHE_BLK_CNT; i++) {
+        bcache[i].b_dev = NULL;
+        INIT_LIST_HEAD(&bcache[i].b_hash);
+        list_add(&bcache[i].b_lru, &bcache_lru);
+    }
+}
+
+static struct list_head *bcache_bucket(struct blk_dev *dev, uint32_t blocknr)
+{
+    uint32_t hash = ((uintptr_t) dev >> 2) ^ (blocknr * 0x9e3779b1);
+    return &bcache_hash[(hash >> 16) & (BCACHE_HASH_SIZE - 1)];
+}
+
+static int bcache_writeback(struct buffer_head *bh)
+{
+    int retval = blk_rw(bh->b_dev, BLK_WRITE, bh->b_data, BCACHE_BLK_SIZE,
+                        (off_t) bh->b_blocknr * BCACHE_BLK_SIZE);
+    if (retval < 0)
+        return retval;
+
+    bh->b_dirty = false;
+    bcache_stat.writebacks++;
+    bcache_stat.dirty--;
+
+    return 0;
+}
+
+/* Get the buffer of the block, read from the device on miss. Returns NULL if
+ * the block can not be cached, e.g., it crosses the end of the device */
+static struct buffer_head *bcache_get(struct blk_dev *dev,
+                                      uint32_t blocknr,
+                                      bool fill)
+{
+    struct list_head *bucket = bcache_bucket(dev, blocknr);
+    struct buffer_head *bh;
+
+    list_for_each_entry (bh, bucket, b_hash) {
+        if (bh->b_dev == dev && bh->b_blocknr == blocknr) {
+            /* Mark as the most recently used */
+            list_move(&bh->b_lru, &bcache_lru);
+            bcache_stat.hits++;
+            return bh;
+        }
+    }
+
+    bcache_stat.misses++;
+
+    /* The whole block must be inside the device */
+    off_t offset = (off_t) blocknr * BCACHE_BLK_SIZE;
+    if (offset + BCACHE_BLK_SIZE > dev->size)
+        return NULL;
+
+    /* Evict the least recently used buffer */
+    bh = list_first_entry(&bcache_lru, struct buffer_head, b_lru);
+    if (bh->b_dev && bh->b_dirty && bcache_writeback(bh) < 0)
+        return NULL;
+
+    list_del_init(&bh->b_hash);
+    bh->b_dev = NULL;
+
+    /* Read the block unless it will be overwritten entirely */
+    if (fill &&
+        blk_rw(dev, BLK_READ, bh->b_data, BCACHE_BLK_SIZE, offset) < 0)
+        return NULL;
+
+    bh->b_dev = dev;
+    bh->b_blocknr = blocknr;
+    bh->b_dirty = false;
+    list_add(&bh->b_hash, bucket);
+    list_move(&bh->b_lru, &bcache_lru);
+
+    return bh;
+}
+
+static ssize_t bcache_rw(struct blk_dev *dev,
+                         int dir,
+                         char *buf,
+                         size_t size,
+                         off_t offset)
+{
+    ssize_t retval = size;
+
+    mutex_lock(&bcache_mtx);
+
+    for (size_t done = 0; done < size;) {
+        off_t pos = offset + done;
+        uint32_t blocknr = pos / BCACHE_BLK_SIZE;
+        size_t blk_off = pos % BCACHE_BLK_SIZE;
+
+        size_t n = BCACHE_BLK_SIZE - blk_off;
+        if (n > size - done)
+            n = size - done;
+
+        /* A write of the whole block does not need the old content */
+        bool fill = (dir == BLK_READ) || (n != BCACHE_BLK_SIZE);
+        struct buffer_head *bh = bcache_get(dev, blocknr, fill);
+
+        if (!bh) {
+            /* Access the device directly */
+            int err = blk_rw(dev, dir, &buf[done], n, pos);
+            if (err < 0) {
+                retval = err;
+                break;
+            }
+        } else if (dir == BLK_READ) {
+            memcpy(&buf[done], &bh->b_data[blk_off], n);
+        } else {
+            memcpy(&bh->b_data[blk_off], &buf[done], n);
+            if (!bh->b_dirty) {
+                bh->b_dirty = true;
+                bcache_stat.dirty++;
+            }
+        }
+
+        done += n;
+    }
+
+    mutex_unlock(&bcache_mtx);
+
+    return retval;
+}
+
+ssize_t bcache_read(struct file *dev_file,
+                    char *buf,
+                    size_t size,
+                    off_t offset)
+{
+    struct blk_dev *dev = blkdev_from_file(dev_file);
+
+    /* The device is not a block device, e.g., the memory-mapped romfs */
+    if (!dev)
+        return dev_file->f_op->read(dev_file, buf, size, offset);
+
+    return bcache_rw(dev, BLK_READ, buf, size, offset);
+}
+
+ssize_t bcache_write(struct file *dev_file,
+                     const char *buf,
+                     size_t size,
+                     off_t offset)
+{
+    struct blk_dev *dev = blkdev_from_file(dev_file);
+
+    if (!dev)
+        return dev_file->f_op->write(dev_file, buf, size, offset);
+
+    return bcache_rw(dev, BLK_WRITE, (char *) buf, size, offset);
+}
+
+int bcache_sync(struct file *dev_file)
+{
+    struct blk_dev *dev = dev_file ? blkdev_from_file(dev_file) : NULL;
+    int retval = 0;
+
+    /* Not a block device, nothing is cached */
+    if (dev_file && !dev)
+        return 0;
+
+    mutex_lock(&bcache_mtx);
+
+    for (int i = 0; i < BCACHE_BLK_CNT; i++) {
+        struct buffer_head *bh = &bcache[i];
+        if (!bh->b_dev || !bh->b_dirty || (dev && bh->b_dev != dev))
+            continue;
+
+        int err = bcache_writeback(bh);
+        if (err < 0)
+            retval = err;
+    }
+
+    mutex_unlock(&bcache_mtx);
+
+    return retval;
+}
+
+void bcache_get_stat(struct bcache_stat *stat)
+{
+    *stat = bcache_stat;
+}
@@ -10,10 +10,11 @@
 
 #include <arch/port.h>
 #include <common/bitops.h>
+#include <fs/buffer.h>
 #include <fs/fs.h>
 #include <fs/reg_file.h>
-#include <kernel/daemon.h>
 #include <kernel/kernel.h>
+#include <kernel/mutex.h>
 #include <kernel/pipe.h>
 #include <kernel/preempt.h>
 #include <mm/mm.h>
@@ -41,9 +42,10 @@ uint32_t bitmap_blks[BITMAP_SIZE(FS_BLK_CNT)];
 struct mount mount_points[MOUNT_MAX + 1]; /* 0 is reserved for the rootfs */
 int mount_cnt;
 
-__FILE __stdin = {.fd = STDIN_FILENO};
-__FILE __stdout = {.fd = STDOUT_FILENO};
-__FILE __stderr = {.fd = STDERR_FILENO};
+/* The standard streams are unbuffered unless changed with setvbuf() */
+__FILE __stdin = {.fd = STDIN_FILENO, .mode = _IONBF};
+__FILE __stdout = {.fd = STDOUT_FILENO, .mode = _IONBF};
+__FILE __stderr = {.fd = STDERR_FILENO, .mode = _IONBF};
 FILE *stdin = (FILE *) &__stdin;
 FILE *stdout = (FILE *) &__stdout;
 FILE *stderr = (FILE *) &__stderr;
@@ -52,6 +54,22 @@ struct inode *shell_dir_curr;
 
 struct kmem_cache *file_caches;
 
+/* Serialize the file system operations executed by the callers */
+static struct mutex fs_mtx;
+
+/* Cached result of looking up a name under a directory */
+struct dcache_entry {
+    uint32_t d_parent;       /* inode number of the directory */
+    int32_t d_inode;         /* inode number of the file, -1 if not found */
+    char d_name[NAME_MAX];   /* File name */
+    struct list_head d_hash; /* List of the hash bucket */
+    struct list_head d_lru;  /* List ordered by the last use */
+};
+
+static struct dcache_entry dcache[DCACHE_SIZE];
+static struct list_head dcache_hash[DCACHE_HASH_SIZE];
+static LIST_HEAD(dcache_lru); /* Least recently used entry comes first */
+
 static struct file_operations rootfs_file_ops = {
     .read = rootfs_read,
     .write = rootfs_write,
@@ -59,7 +77,7 @@ static struct file_operations rootfs_file_ops = {
 
 void link_stdin_dev(char *path)
 {
-    int fd = fs_open_file(path);
+    int fd = vfs_open(path);
     if (fd < 0)
         halt();
     files[STDIN_FILENO] = files[fd];
@@ -67,7 +85,7 @@ void link_stdin_dev(char *path)
 
 void link_stdout_dev(char *path)
 {
-    int fd = fs_open_file(path);
+    int fd = vfs_open(path);
     if (fd < 0)
         halt();
     files[STDOUT_FILENO] = files[fd];
@@ -75,7 +93,7 @@ void link_stdout_dev(char *path)
 
 void link_stderr_dev(char *path)
 {
-    int fd = fs_open_file(path);
+    int fd = vfs_open(path);
     if (fd < 0)
         halt();
     files[STDERR_FILENO] = files[fd];
@@ -87,7 +105,7 @@ int register_chrdev(char *name, struct file_operations *fops)
     snprintf(dev_path, PATH_MAX, "/dev/%s", name);
 
     /* Create new character device file */
-    int fd = fs_create_file(dev_path, S_IFCHR);
+    int fd = vfs_create(dev_path, S_IFCHR);
 
     /* Link the file operations */
     files[fd]->f_op = fops;
@@ -101,7 +119,7 @@ int register_blkdev(char *name, struct file_operations *fops)
     snprintf(dev_path, PATH_MAX, "/dev/%s", name);
 
     /* Create new block device file */
-    int fd = fs_create_file(dev_path, S_IFBLK);
+    int fd = vfs_create(dev_path, S_IFBLK);
 
     /* Link the file operations */
     files[fd]->f_op = fops;
@@ -109,6 +127,28 @@ int register_blkdev(char *name, struct file_operations *fops)
     return 0;
 }
 
+int register_blkdev_file(char *name, struct file *dev_file)
+{
+    char dev_path[100] = {0};
+    snprintf(dev_path, PATH_MAX, "/dev/%s", name);
+
+    /* Create new block device file */
+    int fd = vfs_create(dev_path, S_IFBLK);
+    if (fd < 0)
+        return -ENOSPC;
+
+    /* Replace the allocated file with the one embedded in the driver */
+    struct file *old_file = files[fd];
+    dev_file->f_inode = old_file->f_inode;
+    files[fd] = dev_file;
+
+    preempt_disable();
+    kmem_cache_free(file_caches, old_file);
+    preempt_enable();
+
+    return 0;
+}
+
 struct file *fs_alloc_file(void)
 {
     preempt_disable();
@@ -156,11 +196,98 @@ static uint8_t *fs_alloc_block(void)
     return new_block;
 }
 
+static void fs_dcache_init(void)
+{
+    for (int i = 0; i < DCACHE_HASH_SIZE; i++)
+        INIT_LIST_HEAD(&dcache_hash[i]);
+
+    /* All entries are free and placed on the LRU list */
+    for (int i = 0; i < DCACHE_SIZE; i++) {
+        INIT_LIST_HEAD(&dcache[i].d_hash);
+        list_add(&dcache[i].d_lru, &dcache_lru);
+    }
+}
+
+static struct list_head *fs_dcache_bucket(uint32_t parent, const char *name)
+{
+    /* FNV-1a hash of the name seeded with the directory inode number */
+    uint32_t hash = 2166136261u ^ parent;
+    while (*name) {
+        hash ^= (uint8_t) *name++;
+        hash *= 16777619u;
+    }
+
+    return &dcache_hash[hash & (DCACHE_HASH_SIZE - 1)];
+}
+
+static struct dcache_entry *fs_dcache_lookup(uint32_t parent, const char *name)
+{
+    struct dcache_entry *entry;
+    list_for_each_entry (entry, fs_dcache_bucket(parent, name), d_hash) {
+        if (entry->d_parent == parent && strcmp(entry->d_name, name) == 0) {
+            /* Mark the entry as the most recently used */
+            list_move(&entry->d_lru, &dcache_lru);
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+static void fs_dcache_add(uint32_t parent,
+                          const char *name,
+                          struct inode *inode)
+{
+    /* Names that do not fit are not cached */
+    if (strlen(name) >= NAME_MAX)
+        return;
+
+    /* Recycle the least recently used entry */
+    struct dcache_entry *entry =
+        list_first_entry(&dcache_lru, struct dcache_entry, d_lru);
+    list_del_init(&entry->d_hash);
+
+    entry->d_parent = parent;
+    entry->d_inode = inode ? (int32_t) inode->i_ino : -1;
+    strcpy(entry->d_name, name);
+
+    list_add(&entry->d_hash, fs_dcache_bucket(parent, name));
+    list_move(&entry->d_lru, &dcache_lru);
+}
+
+static void fs_dcache_drop(struct dcache_entry *entry)
+{
+    list_del_init(&entry->d_hash);
+
+    /* Place the entry in front of the LRU list for being recycled first */
+    list_del(&entry->d_lru);
+    list_add(&entry->d_lru, dcache_lru.next);
+}
+
+static void fs_dcache_invalidate(uint32_t parent, const char *name)
+{
+    struct dcache_entry *entry = fs_dcache_lookup(parent, name);
+    if (entry)
+        fs_dcache_drop(entry);
+}
+
+static void fs_dcache_flush(void)
+{
+    for (int i = 0; i < DCACHE_SIZE; i++) {
+        if (!list_empty(&dcache[i].d_hash))
+            fs_dcache_drop(&dcache[i]);
+    }
+}
+
 void rootfs_init(void)
 {
     file_caches = kmem_cache_create("file_cache", sizeof(struct file),
                                     sizeof(uint32_t), 0, NULL);
 
+    mutex_init(&fs_mtx);
+    fs_dcache_init();
+    bcache_init();
+
     /* Configure the super block */
     struct super_block *rootfs_super_blk = &mount_points[RDEV_ROOTFS].super_blk;
     rootfs_super_blk->s_inode_cnt = 0;
@@ -249,8 +376,7 @@ static void fs_read_list(struct file *dev_file,
                          struct list_head *list)
 {
     /* Read list of the file */
-    dev_file->f_op->read(dev_file, (char *) list, sizeof(struct list_head),
-                         list_addr);
+    bcache_read(dev_file, (char *) list, sizeof(struct list_head), list_addr);
 }
 
 static void fs_read_dentry(struct file *dev_file,
@@ -258,8 +384,7 @@ static void fs_read_dentry(struct file *dev_file,
                            struct dentry *dentry)
 {
     /* Read dentry of the file */
-    dev_file->f_op->read(dev_file, (char *) dentry, sizeof(struct dentry),
-                         dentry_addr);
+    bcache_read(dev_file, (char *) dentry, sizeof(struct dentry), dentry_addr);
 }
 
 static void fs_read_inode(uint8_t rdev,
@@ -273,8 +398,7 @@ static void fs_read_inode(uint8_t rdev,
         super_blk->s_ino_addr + (sizeof(struct inode) * inode_num);
 
     /* Read the inode */
-    dev_file->f_op->read(dev_file, (char *) inode, sizeof(struct inode),
-                         inode_addr);
+    bcache_read(dev_file, (char *) inode, sizeof(struct inode), inode_addr);
 }
 
 /* Search a file under the given directory
@@ -295,19 +419,30 @@ static struct inode *fs_search_file(struct inode *inode_dir, char *file_name)
     if (strncmp("..", file_name, NAME_MAX) == 0)
         return &inodes[inode_dir->i_parent];
 
+    /* Look up the dentry cache first */
+    struct dcache_entry *entry = fs_dcache_lookup(inode_dir->i_ino, file_name);
+    if (entry)
+        return (entry->d_inode >= 0) ? &inodes[entry->d_inode] : NULL;
+
     /* Mount directory to synchronize it */
     if (inode_dir->i_sync == false)
         fs_mount_directory(inode_dir, inode_dir);
 
     /* Traverse the dentry list */
+    struct inode *inode = NULL;
     struct dentry *dentry;
     list_for_each_entry (dentry, &inode_dir->i_dentry, d_list) {
         /* Compare the file name with the dentry */
-        if (strcmp(dentry->d_name, file_name) == 0)
-            return &inodes[dentry->d_inode];
+        if (strcmp(dentry->d_name, file_name) == 0) {
+            inode = &inodes[dentry->d_inode];
+            break;
+        }
     }
 
-    return NULL;
+    /* Cache the result, including the missing file */
+    fs_dcache_add(inode_dir->i_ino, file_name, inode);
+
+    return inode;
 }
 
 static int fs_calculate_dentry_blocks(size_t block_size, size_t dentry_cnt)
@@ -351,7 +486,9 @@ static struct dentry *fs_allocate_dentry(struct inode *inode_dir)
     return (struct dentry *) dir_data_p;
 }
 
-uint32_t fs_file_append_block(struct inode *inode)
+/* Append a new block after the last block of the file. The address of the
+ * last block is given by the caller to avoid walking the block chain */
+uint32_t fs_file_append_block(struct inode *inode, uint32_t last_blk)
 {
     uint8_t rdev = inode->i_rdev;
 
@@ -377,21 +514,32 @@ uint32_t fs_file_append_block(struct inode *inode)
         return new_blk;
     }
 
-    struct block_header *blk_head;
-
-    /* Iterate to the last block of the file */
-    blk_head = (struct block_header *) inode->i_data;
-    for (int i = 1; i < inode->i_blocks; i++) {
-        blk_head = (struct block_header *) blk_head->b_next;
-    }
-
     /* Append new block */
-    blk_head->b_next = new_blk;
+    ((struct block_header *) last_blk)->b_next = new_blk;
     inode->i_blocks++;
 
     return new_blk;
 }
 
+static void fs_link_dentry(struct inode *inode_dir, struct dentry *new_dentry)
+{
+    /* Currently the directory has no file yet */
+    if (list_empty(&inode_dir->i_dentry) == true)
+        inode_dir->i_data = (uint32_t) new_dentry; /* Add first dentry */
+
+    /* insert the new file under the directory */
+    list_add(&new_dentry->d_list, &inode_dir->i_dentry);
+
+    /* Drop the cached lookup that may report the file as missing */
+    fs_dcache_invalidate(inode_dir->i_ino, new_dentry->d_name);
+
+    /* Update the inode size and block information */
+    inode_dir->i_size += sizeof(struct dentry);
+
+    int dentry_cnt = inode_dir->i_size / sizeof(struct dentry);
+    inode_dir->i_blocks = fs_calculate_dentry_blocks(FS_BLK_SIZE, dentry_cnt);
+}
+
 /* Create a file under the given directory (currently only supports rootfs) */
 static struct inode *fs_add_file(struct inode *inode_dir,
                                  char *file_name,
@@ -429,14 +577,19 @@ static struct inode *fs_add_file(struct inode *inode_dir,
     case S_IFIFO: {
         /* Named pipe */
         struct pipe *pipe = kmalloc(sizeof(struct pipe));
-        struct kfifo *pipe_fifo = kfifo_alloc(1, PIPE_BUF);
+        struct kfifo *pipe_fifo = kmalloc(sizeof(struct kfifo));
 
         /* Allocation failure */
         if (!pipe || !pipe_fifo)
             goto failed;
 
+        /* The buffer is allocated from the page allocator by
+         * fifo_resize() */
+        kfifo_init(pipe_fifo, NULL, sizeof(char), 0);
         pipe->fifo = pipe_fifo;
         result = fifo_init(fd, (struct file **) &files, new_inode, pipe);
+        if (fifo_resize(pipe, FIFO_SIZE_DEFAULT) < 0)
+            goto failed;
 
         new_inode->i_mode = S_IFIFO;
         new_inode->i_size = 0;
@@ -489,13 +642,13 @@ static struct inode *fs_add_file(struct inode *inode_dir,
         if (!reg_file)
             goto failed;
 
-        result = reg_file_init((struct file **) &files, new_inode, reg_file);
-
         new_inode->i_mode = S_IFREG;
         new_inode->i_size = 0;
         new_inode->i_blocks = 0;
         new_inode->i_data = (uint32_t) NULL; /* Empty content */
 
+        result = reg_file_init((struct file **) &files, new_inode, reg_file);
+
         break;
     }
     case S_IFDIR:
@@ -520,18 +673,8 @@ static struct inode *fs_add_file(struct inode *inode_dir,
     /* Update file count */
     file_cnt++;
 
-    /* Currently the directory has no file yet */
-    if (list_empty(&inode_dir->i_dentry) == true)
-        inode_dir->i_data = (uint32_t) new_dentry; /* Add first dentry */
-
-    /* insert the new file under the directory */
-    list_add(&new_dentry->d_list, &inode_dir->i_dentry);
-
-    /* Update the inode size and block information */
-    inode_dir->i_size += sizeof(struct dentry);
-
-    int dentry_cnt = inode_dir->i_size / sizeof(struct dentry);
-    inode_dir->i_blocks = fs_calculate_dentry_blocks(FS_BLK_SIZE, dentry_cnt);
+    /* Insert the new file under the directory */
+    fs_link_dentry(inode_dir, new_dentry);
 
     return new_inode;
 
@@ -540,6 +683,57 @@ failed:
     return NULL;
 }
 
+/* Add a file whose content is managed by the storage mounted on the directory,
+ * the file object is provided by the storage driver */
+struct inode *fs_link_file(struct inode *inode_dir,
+                           const char *name,
+                           struct file *filp)
+{
+    /* inodes table is full */
+    if (mount_points[RDEV_ROOTFS].super_blk.s_inode_cnt >= INODE_MAX)
+        return NULL;
+
+    /* File table is full */
+    if (file_cnt >= FILE_MAX)
+        return NULL;
+
+    /* Allocate new dentry */
+    struct dentry *new_dentry = fs_allocate_dentry(inode_dir);
+    if (!new_dentry)
+        return NULL;
+
+    /* Dispatch new file descriptor number */
+    int fd = file_cnt + FILE_RESERVED_NUM;
+
+    /* Allocate new inode for the file */
+    struct inode *new_inode = fs_alloc_inode();
+    new_inode->i_mode = S_IFREG;
+    new_inode->i_rdev = inode_dir->i_rdev;
+    new_inode->i_parent = inode_dir->i_ino;
+    new_inode->i_fd = fd;
+    new_inode->i_sync = true;
+    new_inode->i_size = 0;
+    new_inode->i_blocks = 0;
+    new_inode->i_data = (uint32_t) NULL;
+
+    /* Configure new dentry */
+    new_dentry->d_inode = new_inode->i_ino;
+    new_dentry->d_parent = inode_dir->i_ino;
+    strncpy(new_dentry->d_name, name, NAME_MAX - 1);
+    new_dentry->d_name[NAME_MAX - 1] = '\0';
+
+    /* Register the file object of the driver */
+    filp->f_inode = new_inode;
+    filp->f_events = 0;
+    files[fd] = filp;
+    file_cnt++;
+
+    /* Insert the new file under the directory */
+    fs_link_dentry(inode_dir, new_dentry);
+
+    return new_inode;
+}
+
 /* Must be called by the fs_mount_directory() function since current design only
  * supports mounting a whole directory */
 static struct inode *fs_mount_file(struct inode *inode_dir,
@@ -611,6 +805,9 @@ static bool fs_sync_file(struct inode *inode)
 
     /* Create new regular file */
     struct reg_file *reg_file = kmalloc(sizeof(struct reg_file));
+    if (!reg_file)
+        return false;
+
     int result = reg_file_init((struct file **) &files, inode, reg_file);
 
     /* Failed to create new regular file */
@@ -646,8 +843,6 @@ static void fs_mount_directory(struct inode *inode_src,
 
     /* Load the driver file of the storage device */
     struct file *dev_file = mount_points[inode_src->i_rdev].dev_file;
-    ssize_t (*dev_read)(struct file * filp, char *buf, size_t size,
-                        off_t offset) = dev_file->f_op->read;
 
     dentry_addr = (uint32_t) inode_src->i_data;
 
@@ -659,11 +854,11 @@ static void fs_mount_directory(struct inode *inode_src,
 
     while (1) {
         /* Load the dentry from the storage device */
-        dev_read(dev_file, (char *) &dentry, dentry_size, dentry_addr);
+        bcache_read(dev_file, (char *) &dentry, dentry_size, dentry_addr);
 
         /* Load the file inode from the storage device */
         inode_addr = sb_size + (inode_size * dentry.d_inode);
-        dev_read(dev_file, (char *) &inode, inode_size, inode_addr);
+        bcache_read(dev_file, (char *) &inode, inode_size, inode_addr);
 
         /* Overwrite the device number */
         inode.i_rdev = inode_src->i_rdev;
@@ -782,7 +977,17 @@ static int fs_create_file(char *pathname, uint8_t file_type)
                 return -1;
 
             /* Create new inode for the file */
-            inode = fs_add_file(inode_curr, file_name, file_type);
+            struct file *dev_file = mount_points[inode_curr->i_rdev].dev_file;
+            if (inode_curr->i_rdev != RDEV_ROOTFS && dev_file->f_op->create) {
+                /* The storage creates the file by itself */
+                struct file *filp =
+                    (file_type == S_IFREG)
+                        ? dev_file->f_op->create(dev_file, file_name)
+                        : NULL;
+                inode = filp ? fs_link_file(inode_curr, file_name, filp) : NULL;
+            } else {
+                inode = fs_add_file(inode_curr, file_name, file_type);
+            }
 
             /* Failed to create the file */
             if (inode == NULL)
@@ -929,6 +1134,11 @@ struct inode *fs_open_directory(char *pathname)
 
 static int fs_mount(char *source, char *target)
 {
+    /* Mount table is full. Checked before anything is done since both the
+     * mount hook and the romfs path below fill mount_points[mount_cnt] */
+    if (mount_cnt > MOUNT_MAX)
+        return -1;
+
     /* Get the file of the storage to mount */
     int source_fd = fs_open_file(source);
     if (source_fd < 0)
@@ -943,9 +1153,24 @@ static int fs_mount(char *source, char *target)
     struct file *dev_file = files[source_fd];
     mount_points[mount_cnt].dev_file = dev_file;
 
-    /* Get the function pointer of the device read() */
-    ssize_t (*dev_read)(struct file * filp, char *buf, size_t size,
-                        off_t offset) = dev_file->f_op->read;
+    /* The storage driver adds its files under the directory by itself */
+    if (dev_file->f_op->mount) {
+        memset(&mount_points[mount_cnt].super_blk, 0,
+               sizeof(struct super_block));
+
+        uint8_t old_rdev = target_inode->i_rdev;
+        target_inode->i_rdev = mount_cnt;
+
+        if (dev_file->f_op->mount(dev_file, target_inode) < 0) {
+            target_inode->i_rdev = old_rdev;
+            return -1;
+        }
+
+        fs_dcache_flush();
+        mount_cnt++;
+
+        return 0;
+    }
 
     /* Calculate the start address of the super block, inode table, and block
      * region */
@@ -955,12 +1180,12 @@ static int fs_mount(char *source, char *target)
     off_t inodes_addr = super_blk_addr + sb_size;
 
     /* Read the super block from the device */
-    dev_read(dev_file, (char *) &mount_points[mount_cnt].super_blk, sb_size,
-             super_blk_addr);
+    bcache_read(dev_file, (char *) &mount_points[mount_cnt].super_blk, sb_size,
+                super_blk_addr);
 
     /* Read the root inode of the storage */
     struct inode inode_root;
-    dev_read(dev_file, (char *) &inode_root, inode_size, inodes_addr);
+    bcache_read(dev_file, (char *) &inode_root, inode_size, inodes_addr);
 
     /* Overwrite the device number */
     inode_root.i_rdev = mount_cnt;
@@ -968,12 +1193,15 @@ static int fs_mount(char *source, char *target)
     /* Mount the root directory */
     fs_mount_directory(&inode_root, target_inode);
 
+    /* Files are added under the target directory */
+    fs_dcache_flush();
+
     mount_cnt++;
 
     return 0;
 }
 
-char *fs_getcwd(char *buf, size_t len)
+static char *fs_getcwd(char *buf, size_t len)
 {
     char old_path[PATH_MAX] = {0};
     char new_path[PATH_MAX] = {0};
@@ -1007,7 +1235,7 @@ char *fs_getcwd(char *buf, size_t len)
     return buf;
 }
 
-int fs_chdir(const char *path)
+static int fs_chdir(const char *path)
 {
     char path_tmp[PATH_MAX] = {0};
 
@@ -1069,273 +1297,80 @@ int fs_read_dir(DIR *dirp, struct dirent *dirent)
     return 0;
 }
 
-/* Given a block index and return the address of that block */
-uint32_t fs_get_block_addr(struct inode *inode, int blk_index)
+/* Walk the block chain of the file once and record the address of every
+ * block into the block map */
+void fs_load_block_map(struct inode *inode, uint32_t *blk_map)
 {
     /* Load the device file */
     struct file *dev_file = mount_points[inode->i_rdev].dev_file;
 
-    uint32_t blk_addr = (uint32_t) NULL;
+    /* The first block address = inode->i_data */
     struct block_header blk_head = {
         .b_next = inode->i_data,
-    }; /* The first block address = inode->i_data */
+    };
 
-    int i;
-    for (i = 0; i < (blk_index + 1); i++) {
+    for (int i = 0; i < inode->i_blocks; i++) {
         /* Get the address of the next block */
-        blk_addr = blk_head.b_next;
+        blk_map[i] = blk_head.b_next;
 
         /* Read the block header */
-        dev_file->f_op->read(NULL, (char *) &blk_head,
-                             sizeof(struct block_header), blk_addr);
+        bcache_read(dev_file, (char *) &blk_head, sizeof(struct block_header),
+                    blk_map[i]);
     }
-
-    return blk_addr;
-}
-
-void request_create_file(int thread_id, const char *path, uint8_t file_type)
-{
-    preempt_disable();
-
-    int fs_cmd = FS_CREATE_FILE;
-    int reply_fd = THREAD_PIPE_FD(thread_id);
-    const size_t overhead =
-        sizeof(fs_cmd) + sizeof(reply_fd) + sizeof(path) + sizeof(file_type);
-    char buf[overhead];
-    int buf_size = 0;
-
-    memcpy(&buf[buf_size], &fs_cmd, sizeof(fs_cmd));
-    buf_size += sizeof(fs_cmd);
-
-    memcpy(&buf[buf_size], &reply_fd, sizeof(reply_fd));
-    buf_size += sizeof(reply_fd);
-
-    memcpy(&buf[buf_size], &path, sizeof(path));
-    buf_size += sizeof(path);
-
-    memcpy(&buf[buf_size], &file_type, sizeof(file_type));
-    buf_size += sizeof(file_type);
-
-    const int filesysd_fd = THREAD_PIPE_FD(get_daemon_id(FILESYSD));
-    fifo_write(files[filesysd_fd], buf, buf_size, 0);
-
-    preempt_enable();
 }
 
-void request_open_file(int thread_id, const char *path)
+int vfs_create(const char *path, uint8_t file_type)
 {
-    preempt_disable();
+    mutex_lock(&fs_mtx);
+    int retval = fs_create_file((char *) path, file_type);
+    mutex_unlock(&fs_mtx);
 
-    int fs_cmd = FS_OPEN_FILE;
-    int reply_fd = THREAD_PIPE_FD(thread_id);
-    const size_t overhead = sizeof(fs_cmd) + sizeof(reply_fd) + sizeof(path);
-    char buf[overhead];
-    int buf_size = 0;
-
-    memcpy(&buf[buf_size], &fs_cmd, sizeof(fs_cmd));
-    buf_size += sizeof(fs_cmd);
-
-    memcpy(&buf[buf_size], &reply_fd, sizeof(reply_fd));
-    buf_size += sizeof(reply_fd);
-
-    memcpy(&buf[buf_size], &path, sizeof(path));
-    buf_size += sizeof(path);
-
-    const int filesysd_fd = THREAD_PIPE_FD(get_daemon_id(FILESYSD));
-    fifo_write(files[filesysd_fd], buf, buf_size, 0);
-
-    preempt_enable();
+    return retval;
 }
 
-void request_open_directory(int thread_id, const char *path)
+int vfs_open(const char *path)
 {
-    preempt_disable();
+    mutex_lock(&fs_mtx);
+    int retval = fs_open_file((char *) path);
+    mutex_unlock(&fs_mtx);
 
-    int fs_cmd = FS_OPEN_DIR;
-    int reply_fd = THREAD_PIPE_FD(thread_id);
-    const size_t overhead = sizeof(fs_cmd) + sizeof(reply_fd) + sizeof(path);
-    char buf[overhead];
-    int buf_size = 0;
-
-    memcpy(&buf[buf_size], &fs_cmd, sizeof(fs_cmd));
-    buf_size += sizeof(fs_cmd);
-
-    memcpy(&buf[buf_size], &reply_fd, sizeof(reply_fd));
-    buf_size += sizeof(reply_fd);
-
-    memcpy(&buf[buf_size], &path, sizeof(path));
-    buf_size += sizeof(path);
-
-    const int filesysd_fd = THREAD_PIPE_FD(get_daemon_id(FILESYSD));
-    fifo_write(files[filesysd_fd], buf, buf_size, 0);
-
-    preempt_enable();
+    return retval;
 }
 
-void request_mount(int thread_id, const char *source, const char *target)
+struct inode *vfs_opendir(const char *path)
 {
-    preempt_disable();
+    mutex_lock(&fs_mtx);
+    struct inode *retval = fs_open_directory((char *) path);
+    mutex_unlock(&fs_mtx);
 
-    int fs_cmd = FS_MOUNT;
-    int reply_fd = THREAD_PIPE_FD(thread_id);
-    const size_t overhead = sizeof(fs_cmd) + sizeof(reply_fd) +
-                            sizeof(sizeof(source)) + sizeof(sizeof(target));
-    char buf[overhead];
-    int buf_size = 0;
-
-    memcpy(&buf[buf_size], &fs_cmd, sizeof(fs_cmd));
-    buf_size += sizeof(fs_cmd);
-
-    memcpy(&buf[buf_size], &reply_fd, sizeof(reply_fd));
-    buf_size += sizeof(reply_fd);
-
-    memcpy(&buf[buf_size], &source, sizeof(source));
-    buf_size += sizeof(source);
-
-    memcpy(&buf[buf_size], &target, sizeof(target));
-    buf_size += sizeof(target);
-
-    const int filesysd_fd = THREAD_PIPE_FD(get_daemon_id(FILESYSD));
-    fifo_write(files[filesysd_fd], buf, buf_size, 0);
-
-    preempt_enable();
+    return retval;
 }
 
-void request_getcwd(int thread_id, char *path, size_t len)
+int vfs_mount(const char *source, const char *target)
 {
-    preempt_disable();
-
-    int fs_cmd = FS_GET_CWD;
-    int reply_fd = THREAD_PIPE_FD(thread_id);
-    const size_t overhead =
-        sizeof(fs_cmd) + sizeof(path) + sizeof(len) + sizeof(reply_fd);
-    char buf[overhead];
-    int buf_size = 0;
-
-    memcpy(&buf[buf_size], &fs_cmd, sizeof(fs_cmd));
-    buf_size += sizeof(fs_cmd);
-
-    memcpy(&buf[buf_size], &reply_fd, sizeof(reply_fd));
-    buf_size += sizeof(reply_fd);
-
-    memcpy(&buf[buf_size], &path, sizeof(path));
-    buf_size += sizeof(path);
-
-    memcpy(&buf[buf_size], &len, sizeof(len));
-    buf_size += sizeof(len);
-
-    const int filesysd_fd = THREAD_PIPE_FD(get_daemon_id(FILESYSD));
-    fifo_write(files[filesysd_fd], buf, buf_size, 0);
+    mutex_lock(&fs_mtx);
+    int retval = fs_mount((char *) source, (char *) target);
+    mutex_unlock(&fs_mtx);
 
-    preempt_enable();
+    return retval;
 }
 
-void request_chdir(int thread_id, const char *path)
+char *vfs_getcwd(char *buf, size_t len)
 {
-    preempt_disable();
-
-    int fs_cmd = FS_CHANGE_DIR;
-    int reply_fd = THREAD_PIPE_FD(thread_id);
-    const size_t overhead = sizeof(fs_cmd) + sizeof(path) + sizeof(reply_fd);
-    char buf[overhead];
-    int buf_size = 0;
-
-    memcpy(&buf[buf_size], &fs_cmd, sizeof(fs_cmd));
-    buf_size += sizeof(fs_cmd);
-
-    memcpy(&buf[buf_size], &reply_fd, sizeof(reply_fd));
-    buf_size += sizeof(reply_fd);
-
-    memcpy(&buf[buf_size], &path, sizeof(path));
-    buf_size += sizeof(path);
-
-    const int filesysd_fd = THREAD_PIPE_FD(get_daemon_id(FILESYSD));
-    fifo_write(files[filesysd_fd], buf, buf_size, 0);
+    mutex_lock(&fs_mtx);
+    char *retval = fs_getcwd(buf, len);
+    mutex_unlock(&fs_mtx);
 
-    preempt_enable();
+    return retval;
 }
 
-void filesysd(void)
+int vfs_chdir(const char *path)
 {
-    setprogname("filesysd");
-    set_daemon_id(FILESYSD);
-
-    const int filesysd_fd = THREAD_PIPE_FD(get_daemon_id(FILESYSD));
-
-    while (1) {
-        int file_cmd;
-        read(filesysd_fd, &file_cmd, sizeof(file_cmd));
-
-        int reply_fd;
-        read(filesysd_fd, &reply_fd, sizeof(reply_fd));
-
-        switch (file_cmd) {
-        case FS_CREATE_FILE: {
-            char *path;
-            read(filesysd_fd, &path, sizeof(path));
-
-            uint8_t file_type;
-            read(filesysd_fd, &file_type, sizeof(file_type));
+    mutex_lock(&fs_mtx);
+    int retval = fs_chdir(path);
+    mutex_unlock(&fs_mtx);
 
-            int new_fd = fs_create_file(path, file_type);
-            write(reply_fd, &new_fd, sizeof(new_fd));
-
-            break;
-        }
-        case FS_OPEN_FILE: {
-            char *path;
-            read(filesysd_fd, &path, sizeof(path));
-
-            int open_fd = fs_open_file(path);
-            write(reply_fd, &open_fd, sizeof(open_fd));
-
-            break;
-        }
-        case FS_OPEN_DIR: {
-            char *path;
-            read(filesysd_fd, &path, sizeof(path));
-
-            struct inode *inode_dir = fs_open_directory(path);
-
-            write(reply_fd, &inode_dir, sizeof(inode_dir));
-
-            break;
-        }
-        case FS_MOUNT: {
-            char *source;
-            read(filesysd_fd, &source, sizeof(source));
-
-            char *target;
-            read(filesysd_fd, &target, sizeof(target));
-
-            int result = fs_mount(source, target);
-            write(reply_fd, &result, sizeof(result));
-
-            break;
-        }
-        case FS_GET_CWD: {
-            char *buf;
-            read(filesysd_fd, &buf, sizeof(buf));
-
-            size_t len;
-            read(filesysd_fd, &len, sizeof(len));
-
-            char *retval = fs_getcwd(buf, len);
-            write(reply_fd, &retval, sizeof(retval));
-
-            break;
-        }
-        case FS_CHANGE_DIR: {
-            char *path;
-            read(filesysd_fd, &path, sizeof(path));
-
-            int result = fs_chdir(path);
-            write(reply_fd, &result, sizeof(result));
-
-            break;
-        }
-        }
-    }
+    return retval;
 }
 
 /**
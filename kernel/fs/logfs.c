@@ -0,0 +1,961 @@
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <common/list.h>
+#include <fs/fs.h>
+#include <fs/logfs.h>
+#include <kernel/mutex.h>
+
+#include "kconfig.h"
+
+#define LOGFS_MAGIC 0x53464f4c    /* "LOFS" */
+#define LOGFS_REC_MAGIC 0x4352    /* "RC" */
+#define LOGFS_CHUNK_SIZE 32       /* Size of the copy buffer on the stack */
+#define LOGFS_ALIGN(size) (((size) + 3) & ~3)
+
+enum {
+    LOGFS_REC_CREATE = 1, /* File is created or truncated, payload is name */
+    LOGFS_REC_DATA = 2,   /* File content is appended */
+};
+
+/* Placed at the beginning of every erase block. The first part is programmed
+ * right after the erase so that the wear survives the reboot, and the
+ * sequence number is programmed later when the block joins the log */
+struct logfs_block_header {
+    uint32_t magic;
+    uint32_t erase_cnt; /* Wear of the block */
+    uint32_t crc;       /* CRC-32 of the fields above */
+    uint32_t seq;       /* Position of the block in the log, blank if free */
+    uint32_t seq_inv;   /* Bitwise NOT of the sequence number */
+};
+
+#define LOGFS_BLANK 0xffffffff
+
+/* Placed before the payload of every record. The header is programmed first
+ * so a record torn by power loss fails the CRC check and ends the log */
+struct logfs_record {
+    uint16_t magic;
+    uint8_t type;
+    uint8_t id;      /* Index of the file */
+    uint16_t gen;    /* Generation of the file content */
+    uint16_t len;    /* Size of the payload */
+    uint32_t offset; /* File offset of the payload */
+    uint32_t crc;    /* CRC-32 of the fields above and the payload */
+};
+
+static struct file_operations logfs_file_ops;
+
+static int logfs_gc(struct logfs *fs);
+
+static uint32_t logfs_crc32(uint32_t crc, const void *data, size_t size)
+{
+    const uint8_t *p = data;
+
+    crc = ~crc;
+    while (size--) {
+        crc ^= *p++;
+        for (int i = 0; i < 8; i++)
+            crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+    }
+
+    return ~crc;
+}
+
+static inline size_t logfs_record_size(struct logfs_record *rec)
+{
+    return sizeof(struct logfs_record) + LOGFS_ALIGN(rec->len);
+}
+
+static bool logfs_blank(struct logfs *fs, int blk, uint32_t off, size_t size)
+{
+    uint32_t chunk[LOGFS_CHUNK_SIZE / 4];
+
+    /* Check if the region is still in the erased state */
+    while (size > 0) {
+        size_t n = (size < LOGFS_CHUNK_SIZE) ? size : LOGFS_CHUNK_SIZE;
+        if (fs->dev->read(fs->dev, blk, off, chunk, n) < 0)
+            return false;
+
+        for (size_t i = 0; i < n / 4; i++) {
+            if (chunk[i] != 0xffffffff)
+                return false;
+        }
+
+        off += n;
+        size -= n;
+    }
+
+    return true;
+}
+
+/* Read the record header at the given offset, return false at the end of the
+ * block */
+static bool logfs_read_record(struct logfs *fs,
+                              int blk,
+                              uint32_t off,
+                              struct logfs_record *rec)
+{
+    if (off + sizeof(struct logfs_record) > fs->blocks[blk].end)
+        return false;
+
+    if (fs->dev->read(fs->dev, blk, off, rec, sizeof(*rec)) < 0)
+        return false;
+
+    return rec->magic == LOGFS_REC_MAGIC &&
+           off + logfs_record_size(rec) <= fs->blocks[blk].end;
+}
+
+static bool logfs_check_record(struct logfs *fs,
+                               int blk,
+                               uint32_t off,
+                               struct logfs_record *rec)
+{
+    uint8_t chunk[LOGFS_CHUNK_SIZE];
+
+    /* Compute the CRC of the header and the payload */
+    uint32_t crc = logfs_crc32(0, rec, offsetof(struct logfs_record, crc));
+    off += sizeof(struct logfs_record);
+
+    for (size_t done = 0; done < rec->len;) {
+        size_t n = rec->len - done;
+        if (n > LOGFS_CHUNK_SIZE)
+            n = LOGFS_CHUNK_SIZE;
+
+        if (fs->dev->read(fs->dev, blk, off + done, chunk, n) < 0)
+            return false;
+
+        crc = logfs_crc32(crc, chunk, n);
+        done += n;
+    }
+
+    return crc == rec->crc;
+}
+
+/* Collect the used blocks in the log order, return the number of them */
+static int logfs_log_order(struct logfs *fs, int *order)
+{
+    int cnt = 0;
+
+    for (int blk = 0; blk < fs->dev->blk_cnt; blk++) {
+        if (!fs->blocks[blk].seq)
+            continue;
+
+        /* Insertion sort by the sequence number */
+        int i = cnt++;
+        while (i > 0 && fs->blocks[order[i - 1]].seq > fs->blocks[blk].seq) {
+            order[i] = order[i - 1];
+            i--;
+        }
+        order[i] = blk;
+    }
+
+    return cnt;
+}
+
+static int logfs_erase(struct logfs *fs, int blk)
+{
+    int retval = fs->dev->erase(fs->dev, blk);
+    if (retval < 0)
+        return retval;
+
+    fs->blocks[blk].erase_cnt++;
+
+    /* Record the wear of the block. The sequence number is left blank */
+    struct logfs_block_header header = {
+        .magic = LOGFS_MAGIC,
+        .erase_cnt = fs->blocks[blk].erase_cnt,
+    };
+    header.crc =
+        logfs_crc32(0, &header, offsetof(struct logfs_block_header, crc));
+
+    retval = fs->dev->prog(fs->dev, blk, 0, &header,
+                           offsetof(struct logfs_block_header, seq));
+    if (retval < 0)
+        return retval;
+
+    fs->blocks[blk].erased = true;
+
+    return 0;
+}
+
+/* Start a new head block for appending */
+static int logfs_alloc_block(struct logfs *fs)
+{
+    int retval;
+
+    /* Pick the free block erased the least times for wear leveling */
+    int blk = -1;
+    for (int i = 0; i < fs->dev->blk_cnt; i++) {
+        if (fs->blocks[i].seq)
+            continue;
+
+        if (blk < 0 || fs->blocks[i].erase_cnt < fs->blocks[blk].erase_cnt)
+            blk = i;
+    }
+
+    if (blk < 0)
+        return -ENOSPC;
+
+    if (!fs->blocks[blk].erased) {
+        retval = logfs_erase(fs, blk);
+        if (retval < 0)
+            return retval;
+    }
+
+    /* Add the block to the log with the sequence number */
+    uint32_t seq[2] = {fs->seq, ~fs->seq};
+
+    fs->blocks[blk].erased = false;
+    retval = fs->dev->prog(fs->dev, blk,
+                           offsetof(struct logfs_block_header, seq), seq,
+                           sizeof(seq));
+    if (retval < 0)
+        return retval;
+
+    fs->blocks[blk].seq = fs->seq++;
+    fs->blocks[blk].end = sizeof(struct logfs_block_header);
+    fs->free_cnt--;
+    fs->head = blk;
+    fs->head_off = sizeof(struct logfs_block_header);
+
+    return 0;
+}
+
+/* Make room for the record of the given size in the head block. The last
+ * free block is reserved for the garbage collection */
+static int logfs_make_room(struct logfs *fs, size_t size, bool gc)
+{
+    if (fs->head_off + size <= fs->dev->blk_size)
+        return 0;
+
+    for (int i = 0; !gc && fs->free_cnt < 2; i++) {
+        /* Nothing can be reclaimed */
+        if (i >= fs->dev->blk_cnt)
+            return -ENOSPC;
+
+        int retval = logfs_gc(fs);
+        if (retval < 0)
+            return retval;
+
+        /* The garbage collection may have started a new head block */
+        if (fs->head_off + size <= fs->dev->blk_size)
+            return 0;
+    }
+
+    return logfs_alloc_block(fs);
+}
+
+static int logfs_prog_record(struct logfs *fs,
+                             int blk,
+                             uint32_t off,
+                             struct logfs_record *rec,
+                             const void *payload)
+{
+    int retval;
+
+    /* Program the header before the payload */
+    retval = fs->dev->prog(fs->dev, blk, off, rec, sizeof(*rec));
+    if (retval < 0)
+        return retval;
+    off += sizeof(*rec);
+
+    size_t aligned = rec->len & ~3;
+    if (aligned) {
+        retval = fs->dev->prog(fs->dev, blk, off, payload, aligned);
+        if (retval < 0)
+            return retval;
+    }
+
+    /* Pad the tail of the payload to the program unit */
+    if (rec->len > aligned) {
+        uint32_t tail = 0xffffffff;
+        memcpy(&tail, (const uint8_t *) payload + aligned, rec->len - aligned);
+        retval = fs->dev->prog(fs->dev, blk, off + aligned, &tail, 4);
+    }
+
+    return retval;
+}
+
+static int logfs_append(struct logfs *fs,
+                        struct logfs_record *rec,
+                        const void *payload)
+{
+    size_t size = logfs_record_size(rec);
+
+    int retval = logfs_make_room(fs, size, false);
+    if (retval < 0)
+        return retval;
+
+    rec->magic = LOGFS_REC_MAGIC;
+    rec->crc = logfs_crc32(0, rec, offsetof(struct logfs_record, crc));
+    rec->crc = logfs_crc32(rec->crc, payload, rec->len);
+
+    retval = logfs_prog_record(fs, fs->head, fs->head_off, rec, payload);
+    if (retval < 0) {
+        /* Never program the damaged region again */
+        fs->head_off = fs->dev->blk_size;
+        return retval;
+    }
+
+    fs->head_off += size;
+    fs->blocks[fs->head].end = fs->head_off;
+
+    return 0;
+}
+
+static int logfs_copy_record(struct logfs *fs,
+                             int blk,
+                             uint32_t off,
+                             size_t size,
+                             uint32_t *new_off)
+{
+    uint8_t chunk[LOGFS_CHUNK_SIZE];
+
+    int retval = logfs_make_room(fs, size, true);
+    if (retval < 0)
+        return retval;
+
+    *new_off = fs->head_off;
+
+    /* Copy the record verbatim, the header is copied first */
+    for (size_t done = 0; done < size; done += LOGFS_CHUNK_SIZE) {
+        size_t n = size - done;
+        if (n > LOGFS_CHUNK_SIZE)
+            n = LOGFS_CHUNK_SIZE;
+
+        retval = fs->dev->read(fs->dev, blk, off + done, chunk, n);
+        if (retval < 0)
+            break;
+
+        retval = fs->dev->prog(fs->dev, fs->head, fs->head_off + done, chunk,
+                               n);
+        if (retval < 0)
+            break;
+    }
+
+    if (retval < 0) {
+        fs->head_off = fs->dev->blk_size;
+        return retval;
+    }
+
+    fs->head_off += size;
+    fs->blocks[fs->head].end = fs->head_off;
+
+    return 0;
+}
+
+/* Reclaim the oldest block by moving its live records to the head */
+static int logfs_gc(struct logfs *fs)
+{
+    int order[LOGFS_BLK_MAX];
+    int retval;
+
+    /* The head block is never reclaimed */
+    if (logfs_log_order(fs, order) < 2)
+        return -ENOSPC;
+
+    int victim = order[0];
+
+    struct logfs_record rec;
+    uint32_t off = sizeof(struct logfs_block_header);
+
+    while (logfs_read_record(fs, victim, off, &rec)) {
+        size_t size = logfs_record_size(&rec);
+        struct logfs_node *node = &fs->nodes[rec.id];
+
+        /* Records of the deleted or truncated content are dropped */
+        if (rec.id < LOGFS_FILE_MAX && node->used && node->gen == rec.gen) {
+            uint32_t new_off;
+            retval = logfs_copy_record(fs, victim, off, size, &new_off);
+            if (retval < 0)
+                return retval;
+
+            /* Keep the read cursor on the moved record */
+            if (node->cur_blk == victim && node->cur_off == off) {
+                node->cur_blk = fs->head;
+                node->cur_off = new_off;
+            }
+        }
+
+        off += size;
+    }
+
+    /* Drop the cursors left in the victim block */
+    for (int i = 0; i < LOGFS_FILE_MAX; i++) {
+        if (fs->nodes[i].cur_blk == victim)
+            fs->nodes[i].cur_blk = -1;
+    }
+
+    retval = logfs_erase(fs, victim);
+    if (retval < 0)
+        return retval;
+
+    fs->blocks[victim].seq = 0;
+    fs->blocks[victim].end = 0;
+    fs->free_cnt++;
+
+    return 0;
+}
+
+/* Program the append buffer into the log */
+static int logfs_flush(struct logfs *fs)
+{
+    if (!fs->buf_len)
+        return 0;
+
+    struct logfs_node *node = &fs->nodes[fs->buf_id];
+    struct logfs_record rec = {
+        .type = LOGFS_REC_DATA,
+        .id = fs->buf_id,
+        .gen = node->gen,
+        .len = fs->buf_len,
+        .offset = fs->buf_off,
+    };
+
+    int retval = logfs_append(fs, &rec, fs->buf);
+    if (retval < 0)
+        return retval;
+
+    fs->buf_id = -1;
+    fs->buf_len = 0;
+
+    return 0;
+}
+
+static void logfs_replay_record(struct logfs *fs,
+                                int blk,
+                                uint32_t off,
+                                struct logfs_record *rec)
+{
+    struct logfs_node *node = &fs->nodes[rec->id];
+
+    /* The record belongs to the content replaced by a truncation */
+    if (node->used && (int16_t) (rec->gen - node->gen) < 0)
+        return;
+
+    /* Records of a file may precede its creation record after the garbage
+     * collection moved the latter, so the file is created by any record */
+    if (!node->used || rec->gen != node->gen) {
+        node->used = true;
+        node->gen = rec->gen;
+        node->size = 0;
+    }
+
+    if (rec->type == LOGFS_REC_CREATE) {
+        size_t len = (rec->len < NAME_MAX) ? rec->len : NAME_MAX - 1;
+        fs->dev->read(fs->dev, blk, off + sizeof(*rec), node->name, len);
+        node->name[len] = '\0';
+    } else if (rec->offset + rec->len > node->size) {
+        node->size = rec->offset + rec->len;
+    }
+}
+
+/* Rebuild the in-memory state by replaying the log */
+static int logfs_scan(struct logfs *fs)
+{
+    struct flash_dev *dev = fs->dev;
+    struct logfs_block_header header;
+
+    fs->seq = 1;
+    fs->free_cnt = 0;
+
+    for (int i = 0; i < LOGFS_FILE_MAX; i++) {
+        fs->nodes[i].used = false;
+        fs->nodes[i].gen = 0;
+        fs->nodes[i].size = 0;
+    }
+
+    /* Classify the blocks with their headers */
+    for (int blk = 0; blk < dev->blk_cnt; blk++) {
+        memset(&fs->blocks[blk], 0, sizeof(struct logfs_block));
+
+        if (dev->read(dev, blk, 0, &header, sizeof(header)) < 0)
+            return -EIO;
+
+        uint32_t crc =
+            logfs_crc32(0, &header, offsetof(struct logfs_block_header, crc));
+        bool formatted = header.magic == LOGFS_MAGIC && header.crc == crc;
+        bool in_log = header.seq == ~header.seq_inv &&
+                      header.seq != 0 && header.seq != LOGFS_BLANK;
+
+        /* The wear is unknown if the erase is never recorded */
+        if (formatted)
+            fs->blocks[blk].erase_cnt = header.erase_cnt;
+
+        if (formatted && in_log) {
+            fs->blocks[blk].seq = header.seq;
+            fs->blocks[blk].end = dev->blk_size;
+
+            if (header.seq >= fs->seq)
+                fs->seq = header.seq + 1;
+        } else {
+            /* The free block can be used without erasing if nothing but
+             * the wear has been programmed */
+            uint32_t off = offsetof(struct logfs_block_header, seq);
+            fs->blocks[blk].erased =
+                formatted && logfs_blank(fs, blk, off, dev->blk_size - off);
+            fs->free_cnt++;
+        }
+    }
+
+    /* Replay the records in the log order */
+    int order[LOGFS_BLK_MAX];
+    int cnt = logfs_log_order(fs, order);
+
+    for (int i = 0; i < cnt; i++) {
+        int blk = order[i];
+        struct logfs_record rec;
+        uint32_t off = sizeof(header);
+
+        /* The log of the block ends at the first invalid record */
+        while (logfs_read_record(fs, blk, off, &rec) &&
+               rec.id < LOGFS_FILE_MAX &&
+               logfs_check_record(fs, blk, off, &rec)) {
+            logfs_replay_record(fs, blk, off, &rec);
+            off += logfs_record_size(&rec);
+        }
+
+        fs->blocks[blk].end = off;
+    }
+
+    /* Format the empty device */
+    if (cnt == 0)
+        return logfs_alloc_block(fs);
+
+    fs->head = order[cnt - 1];
+    fs->head_off = fs->blocks[fs->head].end;
+
+    /* Do not append after a torn record */
+    if (!logfs_blank(fs, fs->head, fs->head_off,
+                     dev->blk_size - fs->head_off))
+        fs->head_off = dev->blk_size;
+
+    return 0;
+}
+
+/* Find the data record covering the file position. The search starts from the
+ * record read last time so sequential reads find the record immediately */
+static bool logfs_find_record(struct logfs *fs,
+                              struct logfs_node *node,
+                              uint32_t pos,
+                              struct logfs_record *rec)
+{
+    int order[LOGFS_BLK_MAX];
+    int cnt = logfs_log_order(fs, order);
+    if (!cnt)
+        return false;
+
+    /* Locate the cursor in the log */
+    int start = 0;
+    uint32_t start_off = sizeof(struct logfs_block_header);
+    for (int i = 0; node->cur_blk >= 0 && i < cnt; i++) {
+        if (order[i] == node->cur_blk) {
+            start = i;
+            start_off = node->cur_off;
+            break;
+        }
+    }
+
+    /* Visit the whole log once, wrapping around to the records before the
+     * cursor */
+    for (int i = 0; i <= cnt; i++) {
+        int blk = order[(start + i) % cnt];
+        uint32_t off = (i == 0) ? start_off : sizeof(struct logfs_block_header);
+        uint32_t stop = (i == cnt) ? start_off : fs->blocks[blk].end;
+
+        while (off < stop && logfs_read_record(fs, blk, off, rec)) {
+            if (rec->type == LOGFS_REC_DATA && rec->id == node - fs->nodes &&
+                rec->gen == node->gen && rec->offset <= pos &&
+                pos < rec->offset + rec->len) {
+                node->cur_blk = blk;
+                node->cur_off = off;
+                return true;
+            }
+
+            off += logfs_record_size(rec);
+        }
+    }
+
+    return false;
+}
+
+static ssize_t __logfs_file_read(struct logfs_node *node,
+                                 char *buf,
+                                 size_t size,
+                                 uint32_t offset)
+{
+    struct logfs *fs = node->fs;
+    int id = node - fs->nodes;
+
+    /* Read until the end of the file */
+    if (offset >= node->size)
+        return 0;
+
+    if (size > node->size - offset)
+        size = node->size - offset;
+
+    size_t done = 0;
+    while (done < size) {
+        uint32_t pos = offset + done;
+        size_t n = size - done;
+
+        if (fs->buf_id == id && pos >= fs->buf_off) {
+            /* The data is still in the append buffer */
+            if (n > fs->buf_off + fs->buf_len - pos)
+                n = fs->buf_off + fs->buf_len - pos;
+
+            memcpy(buf + done, &fs->buf[pos - fs->buf_off], n);
+        } else {
+            /* The data is in the log */
+            struct logfs_record rec;
+            if (!logfs_find_record(fs, node, pos, &rec))
+                break;
+
+            uint32_t skip = pos - rec.offset;
+            if (n > rec.len - skip)
+                n = rec.len - skip;
+
+            uint32_t off = node->cur_off + sizeof(rec) + skip;
+            if (fs->dev->read(fs->dev, node->cur_blk, off, buf + done, n) < 0)
+                break;
+        }
+
+        done += n;
+    }
+
+    return done ? done : -EIO;
+}
+
+static ssize_t __logfs_file_write(struct logfs_node *node,
+                                  const char *buf,
+                                  size_t size)
+{
+    struct logfs *fs = node->fs;
+    int id = node - fs->nodes;
+    int retval;
+
+    size_t done = 0;
+    while (done < size) {
+        /* The buffer is owned by another file or full */
+        bool full = fs->buf_len == LOGFS_BUF_SIZE;
+        if (fs->buf_len && (fs->buf_id != id || full)) {
+            retval = logfs_flush(fs);
+            if (retval < 0)
+                return done ? done : retval;
+        }
+
+        if (!fs->buf_len) {
+            fs->buf_id = id;
+            fs->buf_off = node->size;
+        }
+
+        /* Data is always appended to the end of the file */
+        size_t n = size - done;
+        if (n > LOGFS_BUF_SIZE - fs->buf_len)
+            n = LOGFS_BUF_SIZE - fs->buf_len;
+
+        memcpy(&fs->buf[fs->buf_len], buf + done, n);
+        fs->buf_len += n;
+        node->size += n;
+        done += n;
+    }
+
+    node->file.f_inode->i_size = node->size;
+
+    return done;
+}
+
+static int __logfs_file_truncate(struct logfs_node *node, off_t length)
+{
+    struct logfs *fs = node->fs;
+    int id = node - fs->nodes;
+
+    /* The log only supports discarding the whole content */
+    if (length != 0)
+        return -EINVAL;
+
+    /* Start a new generation of the content */
+    struct logfs_record rec = {
+        .type = LOGFS_REC_CREATE,
+        .id = id,
+        .gen = node->gen + 1,
+        .len = strlen(node->name) + 1,
+    };
+
+    int retval = logfs_append(fs, &rec, node->name);
+    if (retval < 0)
+        return retval;
+
+    /* Drop the buffered data of the old content */
+    if (fs->buf_id == id) {
+        fs->buf_id = -1;
+        fs->buf_len = 0;
+    }
+
+    node->gen++;
+    node->size = 0;
+    node->pos = 0;
+    node->cur_blk = -1;
+    node->file.f_inode->i_size = 0;
+
+    return 0;
+}
+
+static ssize_t logfs_file_read(struct file *filp,
+                               char *buf,
+                               size_t size,
+                               off_t offset)
+{
+    struct logfs_node *node = container_of(filp, struct logfs_node, file);
+
+    mutex_lock(&node->fs->lock);
+    ssize_t retval = __logfs_file_read(node, buf, size, node->pos);
+    if (retval > 0)
+        node->pos += retval;
+    mutex_unlock(&node->fs->lock);
+
+    return retval;
+}
+
+static ssize_t logfs_file_pread(struct file *filp,
+                                char *buf,
+                                size_t size,
+                                off_t offset)
+{
+    struct logfs_node *node = container_of(filp, struct logfs_node, file);
+
+    if (offset < 0)
+        return -EINVAL;
+
+    /* Read at the given offset and leave the file offset untouched */
+    mutex_lock(&node->fs->lock);
+    ssize_t retval = __logfs_file_read(node, buf, size, offset);
+    mutex_unlock(&node->fs->lock);
+
+    return retval;
+}
+
+static ssize_t logfs_file_write(struct file *filp,
+                                const char *buf,
+                                size_t size,
+                                off_t offset)
+{
+    struct logfs_node *node = container_of(filp, struct logfs_node, file);
+
+    mutex_lock(&node->fs->lock);
+    ssize_t retval = __logfs_file_write(node, buf, size);
+    mutex_unlock(&node->fs->lock);
+
+    return retval;
+}
+
+static off_t logfs_file_lseek(struct file *filp, off_t offset, int whence)
+{
+    struct logfs_node *node = container_of(filp, struct logfs_node, file);
+    off_t new_pos;
+
+    mutex_lock(&node->fs->lock);
+
+    switch (whence) {
+    case SEEK_SET:
+        new_pos = offset;
+        break;
+    case SEEK_END:
+        new_pos = node->size + offset;
+        break;
+    case SEEK_CUR:
+        new_pos = node->pos + offset;
+        break;
+    default:
+        new_pos = -EINVAL;
+    }
+
+    /* The read position must be inside the file */
+    if (new_pos < 0 || new_pos > node->size)
+        new_pos = -EINVAL;
+    else
+        node->pos = new_pos;
+
+    mutex_unlock(&node->fs->lock);
+
+    return new_pos;
+}
+
+static int logfs_file_truncate(struct file *filp, off_t length)
+{
+    struct logfs_node *node = container_of(filp, struct logfs_node, file);
+
+    mutex_lock(&node->fs->lock);
+    int retval = __logfs_file_truncate(node, length);
+    mutex_unlock(&node->fs->lock);
+
+    return retval;
+}
+
+static int logfs_file_open(struct inode *inode, struct file *file)
+{
+    return 0;
+}
+
+static int logfs_file_release(struct inode *inode, struct file *file)
+{
+    struct logfs_node *node = container_of(file, struct logfs_node, file);
+    struct logfs *fs = node->fs;
+    int retval = 0;
+
+    /* Program the buffered data of the file */
+    mutex_lock(&fs->lock);
+    if (fs->buf_id == node - fs->nodes)
+        retval = logfs_flush(fs);
+    mutex_unlock(&fs->lock);
+
+    return retval;
+}
+
+static void logfs_reset(struct logfs *fs)
+{
+    /* Drop the state built by the scan of the log */
+    fs->seq = 0;
+    fs->buf_id = -1;
+    fs->buf_len = 0;
+
+    for (int i = 0; i < LOGFS_FILE_MAX; i++) {
+        fs->nodes[i].used = false;
+        fs->nodes[i].pos = 0;
+        fs->nodes[i].cur_blk = -1;
+    }
+}
+
+static int logfs_mount(struct file *dev_file, struct inode *inode_dir)
+{
+    struct logfs *fs = container_of(dev_file, struct logfs, dev_file);
+
+    /* The file system can only be mounted once */
+    if (fs->seq)
+        return -EBUSY;
+
+    mutex_lock(&fs->lock);
+    int retval = logfs_scan(fs);
+    mutex_unlock(&fs->lock);
+
+    if (retval < 0)
+        goto fail;
+
+    /* Add the files under the mount directory. The files linked by an
+     * earlier failed mount are still there and not linked again */
+    for (int i = 0; i < LOGFS_FILE_MAX; i++) {
+        struct logfs_node *node = &fs->nodes[i];
+        if (!node->used)
+            continue;
+
+        struct inode *inode = node->file.f_inode;
+        if (!inode)
+            inode = fs_link_file(inode_dir, node->name, &node->file);
+
+        if (!inode) {
+            retval = -ENOSPC;
+            goto fail;
+        }
+
+        inode->i_size = node->size;
+    }
+
+    return 0;
+
+fail:
+    /* Leave the device unmounted so the mount can be retried */
+    mutex_lock(&fs->lock);
+    logfs_reset(fs);
+    mutex_unlock(&fs->lock);
+
+    return retval;
+}
+
+static struct file *logfs_create(struct file *dev_file, const char *name)
+{
+    struct logfs *fs = container_of(dev_file, struct logfs, dev_file);
+    struct file *filp = NULL;
+
+    mutex_lock(&fs->lock);
+
+    /* Find a free file slot */
+    int id;
+    for (id = 0; id < LOGFS_FILE_MAX; id++) {
+        if (!fs->nodes[id].used)
+            break;
+    }
+
+    if (id >= LOGFS_FILE_MAX)
+        goto leave;
+
+    struct logfs_node *node = &fs->nodes[id];
+
+    /* Record the creation of the file */
+    struct logfs_record rec = {
+        .type = LOGFS_REC_CREATE,
+        .id = id,
+        .gen = node->gen + 1,
+        .len = strlen(name) + 1,
+    };
+
+    if (rec.len > NAME_MAX || logfs_append(fs, &rec, name) < 0)
+        goto leave;
+
+    strcpy(node->name, name);
+    node->used = true;
+    node->gen = rec.gen;
+    node->size = 0;
+    node->pos = 0;
+    node->cur_blk = -1;
+    filp = &node->file;
+
+leave:
+    mutex_unlock(&fs->lock);
+    return filp;
+}
+
+static struct file_operations logfs_file_ops = {
+    .lseek = logfs_file_lseek,
+    .read = logfs_file_read,
+    .write = logfs_file_write,
+    .pread = logfs_file_pread,
+    .open = logfs_file_open,
+    .release = logfs_file_release,
+    .truncate = logfs_file_truncate,
+};
+
+static struct file_operations logfs_dev_ops = {
+    .mount = logfs_mount,
+    .create = logfs_create,
+};
+
+int logfs_init(struct logfs *fs, struct flash_dev *dev, char *name)
+{
+    /* The log needs a head block, a reserved block for the garbage collection
+     * and at least one block to reclaim */
+    if (dev->blk_cnt < 3 || dev->blk_cnt > LOGFS_BLK_MAX)
+        return -EINVAL;
+
+    /* The largest record must fit in one block */
+    if (dev->blk_size < sizeof(struct logfs_block_header) +
+                            sizeof(struct logfs_record) + LOGFS_BUF_SIZE)
+        return -EINVAL;
+
+    memset(fs, 0, sizeof(*fs));
+    fs->dev = dev;
+    fs->buf_id = -1;
+    fs->dev_file.f_op = &logfs_dev_ops;
+    mutex_init(&fs->lock);
+
+    for (int i = 0; i < LOGFS_FILE_MAX; i++) {
+        fs->nodes[i].fs = fs;
+        fs->nodes[i].file.f_op = &logfs_file_ops;
+        fs->nodes[i].cur_blk = -1;
+    }
+
+    return register_blkdev_file(name, &fs->dev_file);
+}
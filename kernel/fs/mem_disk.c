@@ -0,0 +1,77 @@
+#include <string.h>
+
+#include <common/list.h>
+#include <fs/blkdev.h>
+#include <fs/mem_disk.h>
+#include <kernel/preempt.h>
+#include <kernel/printk.h>
+#include <kernel/softirq.h>
+
+#include "kconfig.h"
+
+#define MEMDISK_REQ_SIZE_MAX 4096 /* Max size of a merged request */
+
+static char mem_disk_data[MEMDISK_SIZE];
+static struct blk_dev mem_disk;
+
+static LIST_HEAD(mem_disk_inflight);
+static struct tasklet_struct mem_disk_tasklet;
+
+static void mem_disk_transfer(struct blk_request *req)
+{
+    char *addr = &mem_disk_data[req->offset];
+
+    if (req->dir == BLK_READ)
+        memcpy(req->buf, addr, req->size);
+    else
+        memcpy(addr, req->buf, req->size);
+}
+
+/* Run in the softirq daemon to emulate the DMA completion interrupt */
+static void mem_disk_complete(unsigned long data)
+{
+    preempt_disable();
+
+    while (!list_empty(&mem_disk_inflight)) {
+        struct blk_request *req =
+            list_first_entry(&mem_disk_inflight, struct blk_request, list);
+        list_del(&req->list);
+
+        /* Transfer the request and its merged segments */
+        mem_disk_transfer(req);
+
+        struct blk_request *seg;
+        list_for_each_entry (seg, &req->segments, list)
+            mem_disk_transfer(seg);
+
+        blk_end_request(&mem_disk, req, 0);
+    }
+
+    preempt_enable();
+}
+
+static int mem_disk_submit(struct blk_dev *dev, struct blk_request *req)
+{
+    /* Defer the transfer as if it were started on the DMA */
+    list_add(&req->list, &mem_disk_inflight);
+    tasklet_schedule(&mem_disk_tasklet);
+
+    return 0;
+}
+
+void mem_disk_init(void)
+{
+    mem_disk.size = MEMDISK_SIZE;
+    mem_disk.max_size = MEMDISK_REQ_SIZE_MAX;
+    mem_disk.max_inflight = MEMDISK_QUEUE_DEPTH;
+    mem_disk.submit = mem_disk_submit;
+
+    tasklet_init(&mem_disk_tasklet, mem_disk_complete, 0);
+
+    if (blkdev_register("memdisk", &mem_disk) < 0) {
+        pr_err("blkdev memdisk: failed to initialize");
+        return;
+    }
+
+    printk("blkdev memdisk: ram disk with request queue");
+}
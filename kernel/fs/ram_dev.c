@@ -0,0 +1,65 @@
+#include <stdint.h>
+#include <string.h>
+
+#include <fs/logfs.h>
+#include <kernel/printk.h>
+
+#include "kconfig.h"
+
+/* /dev/ram is disabled without the erase blocks */
+#if (RAMDISK_BLK_CNT != 0)
+
+static uint8_t ram_dev_blks[RAMDISK_BLK_CNT][RAMDISK_BLK_SIZE];
+
+static struct logfs ram_logfs;
+
+static int ram_dev_read(struct flash_dev *dev,
+                        int blk,
+                        off_t offset,
+                        void *buf,
+                        size_t size)
+{
+    memcpy(buf, &ram_dev_blks[blk][offset], size);
+    return 0;
+}
+
+static int ram_dev_prog(struct flash_dev *dev,
+                        int blk,
+                        off_t offset,
+                        const void *buf,
+                        size_t size)
+{
+    const uint8_t *src = buf;
+
+    /* Emulate the flash programming that can only clear bits */
+    for (size_t i = 0; i < size; i++)
+        ram_dev_blks[blk][offset + i] &= src[i];
+
+    return 0;
+}
+
+static int ram_dev_erase(struct flash_dev *dev, int blk)
+{
+    memset(ram_dev_blks[blk], 0xff, RAMDISK_BLK_SIZE);
+    return 0;
+}
+
+static struct flash_dev ram_flash_dev = {
+    .blk_size = RAMDISK_BLK_SIZE,
+    .blk_cnt = RAMDISK_BLK_CNT,
+    .read = ram_dev_read,
+    .prog = ram_dev_prog,
+    .erase = ram_dev_erase,
+};
+
+void ram_dev_init(void)
+{
+    if (logfs_init(&ram_logfs, &ram_flash_dev, "ram") < 0) {
+        pr_err("blkdev ram: failed to initialize");
+        return;
+    }
+
+    printk("blkdev ram: logfs storage");
+}
+
+#endif
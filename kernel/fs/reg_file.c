@@ -1,11 +1,15 @@
+#include <errno.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
 
 #include <common/list.h>
+#include <fs/buffer.h>
 #include <fs/fs.h>
 #include <fs/reg_file.h>
 #include <kernel/preempt.h>
+#include <mm/mm.h>
 
 #include "kconfig.h"
 
@@ -16,10 +20,45 @@ int reg_file_open(struct inode *inode, struct file *file)
     return 0;
 }
 
+static bool reg_file_is_extent(struct inode *inode)
+{
+    /* Files on the read-only storage are stored as contiguous extents by
+     * mkromfs instead of the chained blocks */
+    return mount_points[inode->i_rdev].super_blk.s_rd_only;
+}
+
+static int reg_file_grow_block_map(struct reg_file *reg_file, int blk_cnt)
+{
+    /* The block map is large enough */
+    if (blk_cnt <= reg_file->blk_map_size)
+        return 0;
+
+    /* Double the capacity to amortize the reallocation */
+    int new_size = reg_file->blk_map_size ? reg_file->blk_map_size : 4;
+    while (new_size < blk_cnt)
+        new_size *= 2;
+
+    uint32_t *blk_map = kmalloc(sizeof(uint32_t) * new_size);
+    if (!blk_map)
+        return -ENOMEM;
+
+    /* Move the recorded block addresses to the new map */
+    if (reg_file->blk_map) {
+        memcpy(blk_map, reg_file->blk_map,
+               sizeof(uint32_t) * reg_file->blk_map_size);
+        kfree(reg_file->blk_map);
+    }
+
+    reg_file->blk_map = blk_map;
+    reg_file->blk_map_size = new_size;
+
+    return 0;
+}
+
 static ssize_t __reg_file_read(struct file *filp,
                                char *buf,
                                size_t size,
-                               off_t offset)
+                               off_t pos)
 {
     struct reg_file *reg_file = container_of(filp, struct reg_file, file);
 
@@ -38,13 +77,17 @@ static ssize_t __reg_file_read(struct file *filp,
     while (remained_size) {
         /* Calculate the block index corresponding to the current file read
          * position */
-        int blk_i = reg_file->pos / blk_free_size;
+        int blk_i = pos / blk_free_size;
 
-        /* Get the start address of the block */
-        uint32_t blk_start_addr = fs_get_block_addr(inode, blk_i);
+        /* No more block to read */
+        if (blk_i >= inode->i_blocks)
+            break;
+
+        /* Get the start address of the block from the block map */
+        uint32_t blk_start_addr = reg_file->blk_map[blk_i];
 
         /* Calculate the block offset of the current read position */
-        uint8_t blk_pos = reg_file->pos % blk_free_size;
+        uint8_t blk_pos = pos % blk_free_size;
 
         /* Calculate the read address */
         uint32_t read_addr = blk_start_addr + blk_head_size + blk_pos;
@@ -59,8 +102,8 @@ static ssize_t __reg_file_read(struct file *filp,
 
         /* Read data */
         int buf_pos = size - remained_size;
-        int retval = driver_file->f_op->read(NULL, (char *) &buf[buf_pos],
-                                             read_size, read_addr);
+        int retval = bcache_read(driver_file, (char *) &buf[buf_pos],
+                                 read_size, read_addr);
 
         /* Read failure */
         if (retval < 0)
@@ -69,15 +112,85 @@ static ssize_t __reg_file_read(struct file *filp,
         /* Update the remained size */
         remained_size -= read_size;
 
-        /* Update the file read position */
-        reg_file->pos += read_size;
+        /* Update the read position */
+        pos += read_size;
     }
 
     return size - remained_size;
 }
 
+static size_t reg_file_extent_size(struct inode *inode, off_t pos, size_t size)
+{
+    /* End of the file */
+    if (pos >= inode->i_size)
+        return 0;
+
+    /* Stop at the end of the file */
+    size_t read_size = inode->i_size - pos;
+    return size < read_size ? size : read_size;
+}
+
+static ssize_t reg_file_read_extent(struct file *filp,
+                                    char *buf,
+                                    size_t size,
+                                    off_t pos)
+{
+    struct inode *inode = filp->f_inode;
+    struct file *driver_file = mount_points[inode->i_rdev].dev_file;
+
+    if (!size)
+        return 0;
+
+    /* Read the whole request with one driver call */
+    int retval = bcache_read(driver_file, buf, size, inode->i_data + pos);
+    if (retval < 0)
+        return retval;
+
+    return size;
+}
+
 ssize_t reg_file_read(struct file *filp, char *buf, size_t size, off_t offset)
 {
+    struct reg_file *reg_file = container_of(filp, struct reg_file, file);
+    struct inode *inode = filp->f_inode;
+
+    /* The driver is called with the preemption enabled since the block
+     * layer may sleep until the transfer is completed */
+    if (reg_file_is_extent(inode)) {
+        /* Claim the range to read by advancing the read position */
+        preempt_disable();
+        off_t pos = reg_file->pos;
+        size = reg_file_extent_size(inode, pos, size);
+        reg_file->pos += size;
+        preempt_enable();
+
+        return reg_file_read_extent(filp, buf, size, pos);
+    }
+
+    preempt_disable();
+    ssize_t retval = __reg_file_read(filp, buf, size, reg_file->pos);
+    reg_file->pos += retval;
+    preempt_enable();
+
+    return retval;
+}
+
+static ssize_t reg_file_pread(struct file *filp,
+                              char *buf,
+                              size_t size,
+                              off_t offset)
+{
+    struct inode *inode = filp->f_inode;
+
+    if (offset < 0)
+        return -EINVAL;
+
+    /* Same as reg_file_read() but the read position is left untouched */
+    if (reg_file_is_extent(inode)) {
+        size = reg_file_extent_size(inode, offset, size);
+        return reg_file_read_extent(filp, buf, size, offset);
+    }
+
     preempt_disable();
     ssize_t retval = __reg_file_read(filp, buf, size, offset);
     preempt_enable();
@@ -88,7 +201,7 @@ ssize_t reg_file_read(struct file *filp, char *buf, size_t size, off_t offset)
 static ssize_t __reg_file_write(struct file *filp,
                                 const char *buf,
                                 size_t size,
-                                off_t offset)
+                                off_t pos)
 {
     struct reg_file *reg_file = container_of(filp, struct reg_file, file);
 
@@ -111,20 +224,30 @@ static ssize_t __reg_file_write(struct file *filp,
     while (remained_size) {
         /* Calculate the block index corresponding to the current file read
          * position */
-        int blk_i = reg_file->pos / blk_free_size;
+        int blk_i = pos / blk_free_size;
 
         /* Get the start address of the block */
-        uint32_t blk_start_addr = (blk_i >= filp->f_inode->i_blocks)
-                                      ? fs_file_append_block(inode)
-                                      : fs_get_block_addr(inode, blk_i);
+        uint32_t blk_start_addr;
+        if (blk_i >= inode->i_blocks) {
+            /* Make room for recording the new block */
+            if (reg_file_grow_block_map(reg_file, blk_i + 1) < 0)
+                break;
 
-        /* Check if the block address is valid */
-        if (blk_start_addr == (uint32_t) NULL) {
-            break;
+            /* Append new block after the last one */
+            uint32_t last_blk = blk_i ? reg_file->blk_map[blk_i - 1] : 0;
+            blk_start_addr = fs_file_append_block(inode, last_blk);
+
+            /* Check if the block address is valid */
+            if (blk_start_addr == (uint32_t) NULL)
+                break;
+
+            reg_file->blk_map[blk_i] = blk_start_addr;
+        } else {
+            blk_start_addr = reg_file->blk_map[blk_i];
         }
 
         /* Calculate the block offset of the current read position */
-        uint8_t blk_pos = reg_file->pos % blk_free_size;
+        uint8_t blk_pos = pos % blk_free_size;
 
         /* Calculate the write address */
         uint32_t write_addr = blk_start_addr + blk_head_size + blk_pos;
@@ -139,8 +262,8 @@ static ssize_t __reg_file_write(struct file *filp,
 
         /* Write data */
         int buf_pos = size - remained_size;
-        int retval = driver_file->f_op->write(NULL, (char *) &buf[buf_pos],
-                                              write_size, write_addr);
+        int retval = bcache_write(driver_file, (char *) &buf[buf_pos],
+                                  write_size, write_addr);
 
         /* Write failure */
         if (retval < 0)
@@ -149,12 +272,13 @@ static ssize_t __reg_file_write(struct file *filp,
         /* Update the remained size */
         remained_size -= write_size;
 
-        /* Update the file read position */
-        reg_file->pos += write_size;
+        /* Update the write position */
+        pos += write_size;
     }
 
-    /* Update the file size */
-    filp->f_inode->i_size += size;
+    /* Update the file size if the data is written beyond the end */
+    if (pos > inode->i_size)
+        inode->i_size = pos;
 
     return size - remained_size;
 }
@@ -164,6 +288,25 @@ ssize_t reg_file_write(struct file *filp,
                        size_t size,
                        off_t offset)
 {
+    struct reg_file *reg_file = container_of(filp, struct reg_file, file);
+
+    preempt_disable();
+    ssize_t retval = __reg_file_write(filp, buf, size, reg_file->pos);
+    reg_file->pos += retval;
+    preempt_enable();
+
+    return retval;
+}
+
+static ssize_t reg_file_pwrite(struct file *filp,
+                               const char *buf,
+                               size_t size,
+                               off_t offset)
+{
+    /* The file can not have holes */
+    if (offset < 0 || offset > filp->f_inode->i_size)
+        return -EINVAL;
+
     preempt_disable();
     ssize_t retval = __reg_file_write(filp, buf, size, offset);
     preempt_enable();
@@ -178,7 +321,7 @@ static off_t __reg_file_lseek(struct file *filp, off_t offset, int whence)
     /* Get the inode of the regular file */
     struct inode *inode = reg_file->file.f_inode;
 
-    char new_pos;
+    off_t new_pos;
 
     switch (whence) {
     case SEEK_SET:
@@ -194,8 +337,9 @@ static off_t __reg_file_lseek(struct file *filp, off_t offset, int whence)
         return -1;
     }
 
-    /* Check if the new position is valid or not */
-    if ((new_pos >= 0) && (new_pos < inode->i_size)) {
+    /* Check if the new position is valid or not. The end of the file is
+     * valid for appending */
+    if ((new_pos >= 0) && (new_pos <= inode->i_size)) {
         reg_file->pos = new_pos;
         return new_pos;
     } else {
@@ -212,11 +356,51 @@ off_t reg_file_lseek(struct file *filp, off_t offset, int whence)
     return retval;
 }
 
+static int reg_file_mmap(struct file *filp,
+                         off_t offset,
+                         size_t length,
+                         int prot,
+                         void **addr)
+{
+    /* Get the inode of the regular file */
+    struct inode *inode = filp->f_inode;
+
+    /* Only the file stored contiguously can be mapped */
+    if (!reg_file_is_extent(inode))
+        return -ENODEV;
+
+    /* The file is on the read-only storage */
+    if (prot & PROT_WRITE)
+        return -EACCES;
+
+    /* The mapping must be inside the file */
+    if (offset < 0 || offset + length > inode->i_size)
+        return -ENXIO;
+
+    /* Get the driver file of the storage device */
+    struct file *driver_file = mount_points[inode->i_rdev].dev_file;
+    if (!driver_file->f_op->mmap)
+        return -ENODEV;
+
+    /* Map the file content in place on the storage */
+    return driver_file->f_op->mmap(driver_file, inode->i_data + offset,
+                                   length, prot, addr);
+}
+
+static void reg_file_munmap(struct file *filp, void *addr, size_t length)
+{
+    /* Nothing to release since the content is mapped in place */
+}
+
 static struct file_operations reg_file_ops = {
     .lseek = reg_file_lseek,
     .read = reg_file_read,
     .write = reg_file_write,
+    .pread = reg_file_pread,
+    .pwrite = reg_file_pwrite,
     .open = reg_file_open,
+    .mmap = reg_file_mmap,
+    .munmap = reg_file_munmap,
 };
 
 int reg_file_init(struct file **files,
@@ -226,6 +410,16 @@ int reg_file_init(struct file **files,
     /* Initialize the data pointer */
     reg_file->pos = 0;
 
+    /* Resolve the addresses of all blocks once so that any block can be
+     * located in constant time */
+    reg_file->blk_map = NULL;
+    reg_file->blk_map_size = 0;
+    if (!reg_file_is_extent(file_inode)) {
+        if (reg_file_grow_block_map(reg_file, file_inode->i_blocks) < 0)
+            return -ENOMEM;
+        fs_load_block_map(file_inode, reg_file->blk_map);
+    }
+
     /* Register regular file on the file table */
     memset(&reg_file->file, 0, sizeof(reg_file->file));
     reg_file->file.f_inode = file_inode;
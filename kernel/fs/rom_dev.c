@@ -2,6 +2,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
 
 #include <fs/fs.h>
 #include <kernel/printk.h>
@@ -26,6 +27,27 @@ ssize_t rom_dev_read(struct file *filp, char *buf, size_t size, off_t offset)
     return size;
 }
 
+static int rom_dev_mmap(struct file *filp,
+                        off_t offset,
+                        size_t length,
+                        int prot,
+                        void **addr)
+{
+    /* The flash can not be written through the mapping */
+    if (prot & PROT_WRITE)
+        return -EACCES;
+
+    char *map_addr = &_rom_start + offset;
+
+    if ((uint32_t) (map_addr + length) > (uint32_t) &_rom_end)
+        return -EFAULT;
+
+    /* The content is read directly from the memory-mapped flash */
+    *addr = map_addr;
+
+    return 0;
+}
+
 ssize_t rom_dev_write(struct file *filp,
                       const char *buf,
                       size_t size,
@@ -38,6 +60,7 @@ static struct file_operations rom_dev_ops = {
     .read = rom_dev_read,
     .write = rom_dev_write,
     .open = rom_dev_open,
+    .mmap = rom_dev_mmap,
 };
 
 void rom_dev_init(void)
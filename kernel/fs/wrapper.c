@@ -1,12 +1,63 @@
 #include <fcntl.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/reent.h>
 #include <unistd.h>
 
-#define MAX_READ_SIZE 100
-#define MAX_WRITE_SIZE 100
+static bool stream_alloc_buf(__FILE *_stream)
+{
+    /* The buffer is provided by the user or already allocated */
+    if (_stream->buf)
+        return true;
+
+    _stream->buf = malloc(_stream->size);
+    if (!_stream->buf)
+        return false;
+
+    _stream->own_buf = true;
+
+    return true;
+}
+
+static int stream_flush_write(__FILE *_stream)
+{
+    size_t pos = 0;
+
+    /* Write out all the buffered data */
+    while (pos < _stream->len) {
+        ssize_t retval =
+            write(_stream->fd, &_stream->buf[pos], _stream->len - pos);
+        if (retval <= 0) {
+            /* Keep the unwritten data in the buffer */
+            memmove(_stream->buf, &_stream->buf[pos], _stream->len - pos);
+            _stream->len -= pos;
+            return EOF;
+        }
+
+        pos += retval;
+    }
+
+    _stream->len = 0;
+    _stream->writing = false;
+
+    return 0;
+}
+
+static void stream_drop_read(__FILE *_stream)
+{
+    /* Move the file position back to the first unread byte. The stream
+     * never reads ahead from the file that can not seek, e.g., tty or
+     * pipe */
+    size_t unread = _stream->len - _stream->pos;
+    if (unread && _stream->seekable)
+        lseek(_stream->fd, -(off_t) unread, SEEK_CUR);
+
+    _stream->pos = 0;
+    _stream->len = 0;
+}
 
 FILE *_fopen(const char *pathname, const char *mode)
 {
@@ -27,7 +78,13 @@ FILE *_fopen(const char *pathname, const char *mode)
         return NULL;
     }
 
+    /* The stream is fully buffered by default and the buffer is allocated
+     * at the first access */
+    memset(_stream, 0, sizeof(__FILE));
     _stream->fd = fd;
+    _stream->mode = _IOFBF;
+    _stream->size = BUFSIZ;
+    _stream->seekable = lseek(fd, 0, SEEK_CUR) >= 0;
 
     return stream;
 }
@@ -35,33 +92,118 @@ FILE *_fopen(const char *pathname, const char *mode)
 int _fclose(FILE *stream)
 {
     __FILE *_stream = (__FILE *) stream;
+
+    /* Write out the buffered data before closing */
+    _fflush(stream);
+
+    if (_stream->own_buf)
+        free(_stream->buf);
+
     int retval = close(_stream->fd);
     free(_stream);
     return retval;
 }
 
+int _fflush(FILE *stream)
+{
+    /* Flush the standard output streams */
+    if (!stream) {
+        int retval = _fflush(stdout);
+        return _fflush(stderr) ? EOF : retval;
+    }
+
+    __FILE *_stream = (__FILE *) stream;
+
+    if (_stream->writing)
+        return stream_flush_write(_stream);
+
+    /* Discard the data read ahead */
+    stream_drop_read(_stream);
+
+    return 0;
+}
+
+int _setvbuf(FILE *stream, char *buf, int mode, size_t size)
+{
+    __FILE *_stream = (__FILE *) stream;
+
+    if (mode != _IOFBF && mode != _IOLBF && mode != _IONBF)
+        return EOF;
+
+    /* Write out or discard the buffered data with the old buffer */
+    if (_fflush(stream))
+        return EOF;
+
+    if (_stream->own_buf)
+        free(_stream->buf);
+
+    _stream->mode = mode;
+    _stream->own_buf = false;
+
+    if (mode == _IONBF) {
+        _stream->buf = NULL;
+        _stream->size = 0;
+    } else {
+        /* Allocate the buffer at the first access if not provided */
+        _stream->buf = buf;
+        _stream->size = size ? size : BUFSIZ;
+    }
+
+    return 0;
+}
+
 size_t _fread(void *ptr, size_t size, size_t nmemb, FILE *stream)
 {
     __FILE *_stream = (__FILE *) stream;
 
     size_t nbytes = size * nmemb;
-    int times = (nbytes - 1) / MAX_READ_SIZE + 1;
-    int total = 0;
+    size_t total = 0;
+    ssize_t retval;
+
+    /* Unbuffered stream reads directly */
+    if (_stream->mode == _IONBF) {
+        retval = read(_stream->fd, ptr, nbytes);
+        return (retval > 0) ? retval : 0;
+    }
+
+    /* Write out the buffered data before reading */
+    if (_stream->writing && stream_flush_write(_stream))
+        return 0;
 
-    int retval;
-    for (int i = 0; i < times; i++) {
-        int rsize = (nbytes >= MAX_READ_SIZE) ? MAX_READ_SIZE : nbytes;
-        retval = read(_stream->fd, (char *) ((uintptr_t) ptr + total), rsize);
+    /* Consume the data read ahead */
+    size_t avail = _stream->len - _stream->pos;
+    if (avail) {
+        size_t copy_size = (nbytes < avail) ? nbytes : avail;
+        memcpy(ptr, &_stream->buf[_stream->pos], copy_size);
+        _stream->pos += copy_size;
+        total += copy_size;
+    }
 
-        total += rsize;
-        nbytes -= rsize;
+    if (total == nbytes)
+        return total;
 
-        if (retval != rsize) {
-            break; /* EOF or read error */
-        }
+    char *dest = (char *) ((uintptr_t) ptr + total);
+    size_t remained = nbytes - total;
+
+    /* Large request bypasses the buffer */
+    if (remained >= _stream->size || !stream_alloc_buf(_stream)) {
+        retval = read(_stream->fd, dest, remained);
+        return (retval > 0) ? total + retval : total;
     }
 
-    return total;
+    /* Refill the buffer with one read. The file that can not seek only
+     * reads the requested size, as reading more may block until the whole
+     * buffer arrives and the extra data could not be given back */
+    size_t refill_size = _stream->seekable ? _stream->size : remained;
+    retval = read(_stream->fd, _stream->buf, refill_size);
+    if (retval <= 0)
+        return total;
+
+    _stream->len = retval;
+    _stream->pos = (remained < (size_t) retval) ? remained : (size_t) retval;
+    memcpy(dest, _stream->buf, _stream->pos);
+
+    return total + _stream->pos;
 }
 
 size_t _fwrite(const void *ptr, size_t size, size_t nmemb, FILE *stream)
@@ -69,29 +211,50 @@ size_t _fwrite(const void *ptr, size_t size, size_t nmemb, FILE *stream)
     __FILE *_stream = (__FILE *) stream;
 
     size_t nbytes = size * nmemb;
-    int times = (nbytes - 1) / MAX_WRITE_SIZE + 1;
-    int total = 0;
+    ssize_t retval;
 
-    int retval;
-    for (int i = 0; i < times; i++) {
-        /* Write file */
-        int wsize = (nbytes >= MAX_WRITE_SIZE) ? MAX_WRITE_SIZE : nbytes;
-        retval = write(_stream->fd, (char *) ((uintptr_t) ptr + total), wsize);
+    /* Unbuffered stream writes directly */
+    if (_stream->mode == _IONBF) {
+        retval = write(_stream->fd, ptr, nbytes);
+        return (retval > 0) ? retval : 0;
+    }
 
-        total += wsize;
-        nbytes -= wsize;
+    /* Discard the data read ahead before writing */
+    if (!_stream->writing)
+        stream_drop_read(_stream);
 
-        if (retval != wsize) {
-            break; /* EOF or write error */
-        }
+    /* Write out the buffered data if the new data does not fit */
+    if (_stream->len + nbytes > _stream->size &&
+        stream_flush_write(_stream))
+        return 0;
+
+    /* Large request bypasses the buffer */
+    if (nbytes >= _stream->size || !stream_alloc_buf(_stream)) {
+        retval = write(_stream->fd, ptr, nbytes);
+        return (retval > 0) ? retval : 0;
     }
 
-    return total;
+    /* Append the data to the buffer */
+    memcpy(&_stream->buf[_stream->len], ptr, nbytes);
+    _stream->len += nbytes;
+    _stream->writing = true;
+
+    /* Line buffered stream is flushed when a newline is written */
+    if ((_stream->mode == _IOLBF && memchr(ptr, '\n', nbytes)) ||
+        _stream->len == _stream->size)
+        stream_flush_write(_stream);
+
+    return nbytes;
 }
 
 int _fseek(FILE *stream, long offset, int whence)
 {
     __FILE *_stream = (__FILE *) stream;
+
+    /* The buffered data belongs to the old position */
+    if (_fflush(stream))
+        return EOF;
+
     return lseek(_stream->fd, offset, whence);
 }
 
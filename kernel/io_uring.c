@@ -0,0 +1,103 @@
+#include <errno.h>
+#include <io_uring.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <arch/port.h>
+#include <kernel/syscall.h>
+
+int io_uring_init(struct io_uring *ring,
+                  struct io_uring_sqe *sqes,
+                  struct io_uring_cqe *cqes,
+                  unsigned int entries)
+{
+    /* The size must be power of 2 for wrapping the indices with a mask */
+    if (entries == 0 || (entries & (entries - 1)))
+        return -EINVAL;
+
+    ring->sqes = sqes;
+    ring->cqes = cqes;
+    ring->entries = entries;
+    ring->sq_head = 0;
+    ring->sq_tail = 0;
+    ring->cq_head = 0;
+    ring->cq_tail = 0;
+
+    return 0;
+}
+
+struct io_uring_sqe *io_uring_get_sqe(struct io_uring *ring)
+{
+    /* Submission queue is full */
+    if (ring->sq_tail - ring->sq_head >= ring->entries)
+        return NULL;
+
+    struct io_uring_sqe *sqe =
+        &ring->sqes[ring->sq_tail & (ring->entries - 1)];
+    memset(sqe, 0, sizeof(*sqe));
+    ring->sq_tail++;
+
+    return sqe;
+}
+
+void io_uring_prep_read(struct io_uring_sqe *sqe,
+                        int fd,
+                        void *buf,
+                        unsigned int nbytes)
+{
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = (unsigned long) buf;
+    sqe->len = nbytes;
+}
+
+void io_uring_prep_write(struct io_uring_sqe *sqe,
+                         int fd,
+                         const void *buf,
+                         unsigned int nbytes)
+{
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->fd = fd;
+    sqe->addr = (unsigned long) buf;
+    sqe->len = nbytes;
+}
+
+void io_uring_prep_ioctl(struct io_uring_sqe *sqe,
+                         int fd,
+                         unsigned int cmd,
+                         unsigned long arg)
+{
+    sqe->opcode = IORING_OP_IOCTL;
+    sqe->fd = fd;
+    sqe->addr = arg;
+    sqe->len = cmd;
+}
+
+int io_uring_submit(struct io_uring *ring)
+{
+    return io_uring_enter(ring);
+}
+
+struct io_uring_cqe *io_uring_peek_cqe(struct io_uring *ring)
+{
+    /* Completion queue is empty */
+    if (ring->cq_head == ring->cq_tail)
+        return NULL;
+
+    return &ring->cqes[ring->cq_head & (ring->entries - 1)];
+}
+
+void io_uring_cqe_seen(struct io_uring *ring, struct io_uring_cqe *cqe)
+{
+    ring->cq_head++;
+}
+
+void io_uring_cq_advance(struct io_uring *ring, unsigned int nr)
+{
+    ring->cq_head += nr;
+}
+
+NACKED int io_uring_enter(struct io_uring *ring)
+{
+    SYSCALL(IO_URING_ENTER);
+}
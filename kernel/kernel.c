@@ -1,6 +1,8 @@
+#include <aio.h>
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <io_uring.h>
 #include <mpool.h>
 #include <mqueue.h>
 #include <poll.h>
@@ -13,20 +15,27 @@
 #include <string.h>
 #include <strings.h>
 #include <sys/limits.h>
+#include <sys/mman.h>
 #include <sys/mount.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <task.h>
 #include <tenok.h>
 #include <time.h>
+#include <topic.h>
 #include <unistd.h>
 
 #include <arch/port.h>
 #include <common/bitops.h>
 #include <common/list.h>
 #include <common/util.h>
+#include <fs/buffer.h>
 #include <fs/fs.h>
+#include <fs/mem_disk.h>
 #include <fs/null_dev.h>
+#include <fs/ram_dev.h>
 #include <fs/rom_dev.h>
+#include <kernel/aio.h>
 #include <kernel/daemon.h>
 #include <kernel/errno.h>
 #include <kernel/kernel.h>
@@ -34,17 +43,21 @@
 #include <kernel/mqueue.h>
 #include <kernel/mutex.h>
 #include <kernel/pipe.h>
+#include <kernel/poll.h>
 #include <kernel/preempt.h>
 #include <kernel/printk.h>
 #include <kernel/sched.h>
 #include <kernel/semaphore.h>
+#include <kernel/shm.h>
 #include <kernel/signal.h>
 #include <kernel/softirq.h>
 #include <kernel/syscall.h>
 #include <kernel/thread.h>
 #include <kernel/time.h>
+#include <kernel/topic.h>
 #include <kernel/tty.h>
 #include <kernel/wait.h>
+#include <mm/alloc_trace.h>
 #include <mm/mm.h>
 #include <mm/page.h>
 #include <mm/slab.h>
@@ -54,6 +67,8 @@
 #define PRI_RESERVED 2
 #define KTHREAD_PRI_MAX (THREAD_PRIORITY_MAX + PRI_RESERVED)
 
+#define STACK_PAINT_PATTERN 0xdeadbeef /* For measuring the stack usage */
+
 static LIST_HEAD(tasks_list);   /* List of all tasks in the system */
 static LIST_HEAD(threads_list); /* List of all threads in the system */
 static LIST_HEAD(sleep_list);   /* List of all threads in the sleeping state */
@@ -93,9 +108,9 @@ static char *deamon_names[] = {DAEMON_LIST};
 struct file *files[FILE_RESERVED_NUM + FILE_MAX];
 int file_cnt;
 
-/* File descriptor table */
-static struct fdtable fdtable[OPEN_MAX];
-static uint32_t bitmap_fds[BITMAP_SIZE(OPEN_MAX)];
+/* Open file descriptions shared by the file descriptor tables of the tasks */
+static struct fdtable fdtable[FDTABLE_MAX];
+static uint32_t bitmap_fdtable[BITMAP_SIZE(FDTABLE_MAX)];
 
 /* Message queue descriptor table */
 static struct mq_desc mqd_table[MQUEUE_MAX];
@@ -207,7 +222,7 @@ void *kmalloc(size_t size)
             ptr = alloc_pages(page_order);
         } else {
             /* Failed, the reqeust size is too large to handle */
-            printk("kmalloc(): failed as the request size %d is too large",
+            pr_err("kmalloc(): failed as the request size %d is too large",
                    size);
         }
     }
@@ -216,6 +231,9 @@ void *kmalloc(size_t size)
         /* Record the allocated size and return the start address */
         ((struct kmalloc_header *) ptr)->size = size;
         retval = (void *) ((uintptr_t) ptr + header_size);
+
+        alloc_trace_add(ALLOC_KMALLOC, retval, size,
+                        __builtin_return_address(0));
     }
 
     /* End the critical section */
@@ -237,6 +255,9 @@ void kfree(void *ptr)
     /* Get allocated size */
     size_t alloc_size = addr->size;
 
+    /* Remove the record of the allocation */
+    alloc_trace_del(ALLOC_KMALLOC, ptr, alloc_size);
+
     /* Find the kmalloc slab that the memory belongs to */
     int i;
     for (i = 0; i < KMALLOC_SLAB_TABLE_SIZE; i++) {
@@ -253,7 +274,7 @@ void kfree(void *ptr)
             free_pages((unsigned long) addr, page_order);
         } else {
             /* Invalid size */
-            printk("kfree(): failed as the header is corrupted (address: %p)",
+            pr_err("kfree(): failed as the header is corrupted (address: %p)",
                    addr);
         }
     }
@@ -373,6 +394,14 @@ static int thread_create(struct thread_info **new_thread,
     if (bad_detach_state || bad_priority || bad_sched_policy)
         return -EINVAL;
 
+    /* The stack provided by the user can not be rounded up without running
+     * off the memory, hence it must be 8-byte aligned and large enough to
+     * hold the stack guard as well */
+    if (attr->stackaddr &&
+        ((uintptr_t) attr->stackaddr % 8 || attr->stacksize % 8 ||
+         attr->stacksize < STACK_SIZE_MIN + STACK_GUARD_SIZE))
+        return -EINVAL;
+
     /* Allocate new thread Id */
     int tid = find_first_zero_bit(bitmap_threads, THREAD_MAX);
     if (tid >= THREAD_MAX)
@@ -388,11 +417,19 @@ static int thread_create(struct thread_info **new_thread,
     /* Reset thread data */
     memset(thread, 0, sizeof(struct thread_info));
 
-    /* Allocate thread stack memory */
-    thread->stack = alloc_pages(size_to_page_order(stack_size));
-    if (thread->stack == NULL) {
-        bitmap_clear_bit(bitmap_threads, tid);
-        return -ENOMEM;
+    /* Allocate thread stack memory unless it is provided by the user */
+    if (attr->stackaddr) {
+        thread->stack = attr->stackaddr;
+        thread->stack_static = true;
+    } else {
+        /* Reserve the stack guard on top of the requested size */
+        stack_size += STACK_GUARD_SIZE;
+
+        thread->stack = alloc_pages(size_to_page_order(stack_size));
+        if (thread->stack == NULL) {
+            bitmap_clear_bit(bitmap_threads, tid);
+            return -ENOMEM;
+        }
     }
 
     thread->stack_top =
@@ -404,12 +441,17 @@ static int thread_create(struct thread_info **new_thread,
     thread->stack_top =
         thread_signal_queue_alloc(&thread->signal_queue, thread->stack_top);
 
+    /* Paint the unused stack for tracking the high-water mark */
+    for (unsigned long *p = thread->stack; p < thread->stack_top; p++)
+        *p = STACK_PAINT_PATTERN;
+
     /* Initialize thread stack */
     uint32_t func_args[4] = {0};
     if (thread_arg)
         func_args[0] = (uint32_t) thread_arg;
     __stack_init((uint32_t **) &thread->stack_top, (uint32_t) thread_func,
                  (uint32_t) thread_return_handler, func_args);
+    thread->stack_watermark = thread->stack_top;
 
     /* Initialize thread parameters */
     thread->stack_size = stack_size; /* Bytes */
@@ -445,14 +487,41 @@ static int thread_create(struct thread_info **new_thread,
     return 0;
 }
 
+static void thread_stack_free(struct thread_info *thread)
+{
+    /* Statically allocated stack is owned by the user */
+    if (thread->stack_static)
+        return;
+
+    free_pages((uint32_t) thread->stack,
+               size_to_page_order(thread->stack_size));
+}
+
+static void thread_release(struct thread_info *thread)
+{
+    /* Detach the asynchronous I/O requests from the thread before its
+     * stack holding the control blocks is gone */
+    aio_thread_exit(thread->tid);
+
+    /* Free the pipe buffer enlarged with fcntl(F_SETPIPE_SZ) before the
+     * pipe is reinitialized for the next thread with the same ID */
+    struct pipe *pipe =
+        container_of(files[THREAD_PIPE_FD(thread->tid)], struct pipe, file);
+    fifo_release(pipe);
+
+    /* Free the thread stack memory */
+    thread_stack_free(thread);
+}
+
 static int _task_create(thread_func_t task_func,
                         uint8_t priority,
+                        void *stack,
                         int stack_size,
                         bool kernel_thread)
 {
     struct thread_attr attr = {
         .schedparam.sched_priority = priority,
-        .stackaddr = NULL,
+        .stackaddr = stack,
         .stacksize = stack_size,
         .schedpolicy = SCHED_RR,
         .detachstate = PTHREAD_CREATE_JOINABLE,
@@ -488,26 +557,136 @@ int kthread_create(task_func_t task_func, uint8_t priority, int stack_size)
 {
     preempt_disable();
 
-    int retval = _task_create(task_func, priority, stack_size, true);
+    int retval = _task_create(task_func, priority, NULL, stack_size, true);
     if (retval < 0)
-        printk("kthread_create(): failed to create new task");
+        pr_err("kthread_create(): failed to create new task");
 
     preempt_enable();
 
     return retval;
 }
 
+static struct fdtable *fdesc_get(struct task_struct *task, int fd)
+{
+    /* Calculate the index number of the file descriptor on the table */
+    int fdesc_idx = fd - FILE_RESERVED_NUM;
+
+    /* Check if the file descriptor is invalid */
+    if (fdesc_idx < 0 || fdesc_idx >= OPEN_MAX ||
+        !bitmap_get_bit(task->bitmap_fds, fdesc_idx))
+        return NULL;
+
+    return task->fdtable[fdesc_idx];
+}
+
+static int fd_alloc(struct task_struct *task)
+{
+    /* Find the lowest free file descriptor with a bit scan per word */
+    for (int i = 0; i < BITMAP_SIZE(OPEN_MAX); i++) {
+        int bit = __builtin_ffs(~task->bitmap_fds[i]) - 1;
+        if (bit < 0)
+            continue;
+
+        int fdesc_idx = i * 32 + bit;
+        if (fdesc_idx >= OPEN_MAX)
+            break;
+
+        return fdesc_idx;
+    }
+
+    return -EMFILE;
+}
+
+static int fd_install(struct task_struct *task, struct file *filp, int flags)
+{
+    /* Find a free entry on the file descriptor table of the task */
+    int fdesc_idx = fd_alloc(task);
+    if (fdesc_idx < 0)
+        return fdesc_idx;
+
+    /* Allocate a new open file description */
+    int desc_idx = find_first_zero_bit(bitmap_fdtable, FDTABLE_MAX);
+    if (desc_idx >= FDTABLE_MAX)
+        return -ENFILE;
+    bitmap_set_bit(bitmap_fdtable, desc_idx);
+
+    struct fdtable *fdesc = &fdtable[desc_idx];
+    fdesc->file = filp;
+    fdesc->flags = flags;
+    fdesc->refcnt = 1;
+
+    /* Register new file descriptor on the table */
+    task->fdtable[fdesc_idx] = fdesc;
+    bitmap_set_bit(task->bitmap_fds, fdesc_idx);
+
+    /* Return the file descriptor number */
+    return fdesc_idx + FILE_RESERVED_NUM;
+}
+
+static bool file_in_use(struct file *filp)
+{
+    for (int i = 0; i < FDTABLE_MAX; i++) {
+        if (bitmap_get_bit(bitmap_fdtable, i) && fdtable[i].file == filp)
+            return true;
+    }
+
+    return false;
+}
+
+static void fd_close(struct task_struct *task, int fdesc_idx)
+{
+    struct fdtable *fdesc = task->fdtable[fdesc_idx];
+
+    /* Free the file descriptor */
+    bitmap_clear_bit(task->bitmap_fds, fdesc_idx);
+    task->fdtable[fdesc_idx] = NULL;
+
+    /* Other file descriptors still refer to the open file description */
+    if (--fdesc->refcnt)
+        return;
+
+    bitmap_clear_bit(bitmap_fdtable, fdesc - fdtable);
+
+    /* Release the file if no other open file description refers to it */
+    struct file *filp = fdesc->file;
+    if (filp->f_op->release && !file_in_use(filp))
+        filp->f_op->release(filp->f_inode, filp);
+}
+
+static void mqd_release(mqd_t mqdes)
+{
+    /* Take back the message buffers still lent through the descriptor */
+    struct mqueue *mq = mqd_table[mqdes].mq;
+    if (mq)
+        __mq_reclaim(mq, &mqd_table[mqdes].attr, mqdes);
+
+    bitmap_clear_bit(bitmap_mqds, mqdes);
+}
+
 static void task_delete(struct task_struct *task)
 {
     list_del(&task->list);
     bitmap_clear_bit(bitmap_tasks, task->pid);
 
-    for (int i = 0; i < BITMAP_SIZE(OPEN_MAX); i++) {
-        bitmap_fds[i] &= ~task->bitmap_fds[i];
+    /* Close the file descriptors left by the task */
+    for (int i = 0; i < OPEN_MAX; i++) {
+        if (bitmap_get_bit(task->bitmap_fds, i))
+            fd_close(task, i);
+    }
+
+    /* Close the message queue descriptors left by the task */
+    for (int i = 0; i < MQUEUE_MAX; i++) {
+        if (bitmap_get_bit(task->bitmap_mqds, i))
+            mqd_release(i);
     }
 
-    for (int i = 0; i < BITMAP_SIZE(MQUEUE_MAX); i++) {
-        bitmap_mqds[i] &= ~task->bitmap_mqds[i];
+    /* Delete the memory mappings left by the task */
+    for (int i = 0; i < MMAP_MAX; i++) {
+        struct vm_area *vma = &task->mmaps[i];
+        if (vma->start) {
+            vma->filp->f_op->munmap(vma->filp, vma->start, vma->size);
+            vma->start = NULL;
+        }
     }
 }
 
@@ -529,7 +708,7 @@ static void enqueue_pending_signal(struct thread_info *thread,
                                    uint32_t args[4])
 {
     if (thread->signal_cnt >= SIGNAL_QUEUE_SIZE)
-        printk("Warning: the oldest pending signal is overwritten");
+        pr_warn("the oldest pending signal is overwritten");
 
     /* Push new signal into the pending queue */
     struct staged_handler_info info;
@@ -591,12 +770,11 @@ static void thread_delete(struct thread_info *thread)
     thread->status = THREAD_TERMINATED;
     bitmap_clear_bit(bitmap_threads, thread->tid);
 
-    /* Free the thread stack memory */
-    free_pages((uint32_t) thread->stack,
-               size_to_page_order(thread->stack_size));
+    /* Release the resources owned by the thread */
+    thread_release(thread);
 
     /* Remove the task from the system if it contains no more thread */
-    struct task_struct *task = current_task_info();
+    struct task_struct *task = thread->task;
     if (list_empty(&task->threads_list))
         task_delete(task);
 }
@@ -695,9 +873,8 @@ static inline void thread_join_handler(void)
     running_thread->status = THREAD_TERMINATED;
     bitmap_clear_bit(bitmap_threads, running_thread->tid);
 
-    /* Free the thread stack memory */
-    free_pages((uint32_t) running_thread->stack,
-               size_to_page_order(running_thread->stack_size));
+    /* Release the resources owned by the thread */
+    thread_release(running_thread);
 }
 
 static struct thread_info *thread_info_find_next(struct thread_info *curr)
@@ -717,6 +894,23 @@ static struct thread_info *thread_info_find_next(struct thread_info *curr)
     return thread;
 }
 
+static size_t thread_stack_peak(struct thread_info *thread)
+{
+    /* The stack above the last known watermark is already used, hence only
+     * the remaining painted words below it need to be scanned. The stack
+     * guard is skipped as it is not accessible while running a syscall */
+    unsigned long *watermark =
+        (unsigned long *) ((uintptr_t) thread->stack + STACK_GUARD_SIZE);
+    while (watermark < thread->stack_watermark &&
+           *watermark == STACK_PAINT_PATTERN)
+        watermark++;
+    thread->stack_watermark = watermark;
+
+    /* Return the peak stack usage in bytes */
+    return (uintptr_t) thread->stack + thread->stack_size -
+           (uintptr_t) watermark;
+}
+
 static void *sys_thread_info(struct thread_stat *info, void *next)
 {
     preempt_disable();
@@ -759,6 +953,7 @@ static void *sys_thread_info(struct thread_stat *info, void *next)
     info->stack_usage =
         (size_t) ((uintptr_t) thread->stack + thread->stack_size -
                   (uintptr_t) thread->stack_top);
+    info->stack_peak = thread_stack_peak(thread);
     info->stack_size = thread->stack_size;
     strncpy(info->name, thread->name, THREAD_NAME_MAX);
 
@@ -815,9 +1010,30 @@ static int sys_task_create(task_func_t task_func,
 {
     preempt_disable();
 
-    int retval = _task_create(task_func, priority, stack_size, false);
+    int retval = _task_create(task_func, priority, NULL, stack_size, false);
+    if (retval < 0)
+        pr_err("task_create(): failed to create new task");
+
+    preempt_enable();
+
+    /* Return task creation result */
+    return retval;
+}
+
+static int sys_task_create_static(task_func_t task_func,
+                                  uint8_t priority,
+                                  void *stack,
+                                  int stack_size)
+{
+    /* Check if the stack memory is provided */
+    if (!stack)
+        return -EINVAL;
+
+    preempt_disable();
+
+    int retval = _task_create(task_func, priority, stack, stack_size, false);
     if (retval < 0)
-        printk("task_create(): failed to create new task");
+        pr_err("task_create_static(): failed to create new task");
 
     preempt_enable();
 
@@ -848,6 +1064,7 @@ static int sys_minfo(int name)
 {
     preempt_disable();
 
+    struct bcache_stat bcache_stat;
     int retval = -1;
 
     switch (name) {
@@ -863,6 +1080,40 @@ static int sys_minfo(int name)
     case HEAP_FREE_SIZE:
         retval = heap_get_free_size();
         break;
+    case PAGE_PEAK_SIZE:
+        retval = alloc_trace_peak(ALLOC_PAGE);
+        break;
+    case HEAP_PEAK_SIZE:
+        retval = alloc_trace_peak(ALLOC_HEAP);
+        break;
+    case KMALLOC_USED_SIZE:
+        retval = alloc_trace_used(ALLOC_KMALLOC);
+        break;
+    case KMALLOC_PEAK_SIZE:
+        retval = alloc_trace_peak(ALLOC_KMALLOC);
+        break;
+    case ALLOC_TRACE_DROPPED:
+        retval = alloc_trace_dropped();
+        break;
+    case BCACHE_HITS:
+        bcache_get_stat(&bcache_stat);
+        retval = bcache_stat.hits;
+        break;
+    case BCACHE_MISSES:
+        bcache_get_stat(&bcache_stat);
+        retval = bcache_stat.misses;
+        break;
+    case BCACHE_WRITEBACKS:
+        bcache_get_stat(&bcache_stat);
+        retval = bcache_stat.writebacks;
+        break;
+    case BCACHE_DIRTY:
+        bcache_get_stat(&bcache_stat);
+        retval = bcache_stat.dirty;
+        break;
+    case PRINTK_LOST:
+        retval = printk_lost_cnt();
+        break;
     }
 
     preempt_enable();
@@ -871,6 +1122,21 @@ static int sys_minfo(int name)
     return retval;
 }
 
+static void *sys_alloc_trace_info(struct alloc_stat *info, void *next)
+{
+    preempt_disable();
+    void *retval = alloc_trace_iterate(info, next);
+    preempt_enable();
+
+    return retval;
+}
+
+static int sys_kmsg_info(struct kmsg_stat *msg, uint32_t seq)
+{
+    /* The log ring is read without locking */
+    return printk_kmsg_info(msg, seq);
+}
+
 static int sys_sched_yield(void)
 {
     /* Suspend current thread */
@@ -903,9 +1169,8 @@ static void sys_exit(int status)
         thread->status = THREAD_TERMINATED;
         bitmap_clear_bit(bitmap_threads, thread->tid);
 
-        /* Free the stack memory */
-        free_pages((uint32_t) thread->stack,
-                   size_to_page_order(thread->stack_size));
+        /* Release the resources owned by the thread */
+        thread_release(thread);
     }
 
     /* Remove the task from the system */
@@ -920,92 +1185,43 @@ static int sys_mount(const char *source, const char *target)
     if (strlen(source) >= PATH_MAX || strlen(target) >= PATH_MAX)
         return -ENAMETOOLONG;
 
-    int tid = running_thread->tid;
-
-    /* Send mount request to the file system daemon */
-    request_mount(tid, source, target);
-
-    /* Read mount result from the file system daemon */
-    int fifo_retval, mnt_result;
-    while (1) {
-        fifo_retval = fifo_read(files[THREAD_PIPE_FD(tid)],
-                                (char *) &mnt_result, sizeof(mnt_result), 0);
-
-        if (fifo_retval != -ERESTARTSYS)
-            break;
-
-        schedule();
-    }
-
-    return mnt_result;
+    return vfs_mount(source, target);
 }
 
 static int sys_open(const char *pathname, int flags)
 {
-    preempt_disable();
-
-    int retval;
-
     /* Check the length of the pathname */
-    if (strlen(pathname) >= PATH_MAX) {
-        retval = -ENAMETOOLONG;
-        goto err;
-    }
-
-    /* Acquire the running task */
-    struct task_struct *task = current_task_info();
+    if (strlen(pathname) >= PATH_MAX)
+        return -ENAMETOOLONG;
 
-    /* Acquire the thread ID */
-    int tid = running_thread->tid;
+    /* Look up the file (must be done with preemption enabled) */
+    int file_idx = vfs_open(pathname);
 
-    /* Send file open request to the file system daemon */
-    request_open_file(tid, pathname);
+    /* File not found */
+    if (file_idx == -1)
+        return -ENOENT;
 
-    /* Read the file index from the file system daemon */
-    int file_idx;
-    int fifo_retval;
-    while (1) {
-        fifo_retval = fifo_read(files[THREAD_PIPE_FD(tid)], (char *) &file_idx,
-                                sizeof(file_idx), 0);
+    preempt_disable();
 
-        if (fifo_retval != -ERESTARTSYS)
-            break;
+    int retval;
 
-        schedule();
-    }
+    /* Acquire the running task */
+    struct task_struct *task = current_task_info();
 
-    /* File not found */
-    if (file_idx == -1) {
-        /* Return error */
-        retval = -ENOENT;
-        goto err;
-    }
+    struct file *filp = files[file_idx];
 
-    /* Find a free entry on the file descriptor entry table */
-    int fdesc_idx = find_first_zero_bit(bitmap_fds, OPEN_MAX);
-    if (fdesc_idx >= OPEN_MAX) {
+    /* Check if the file operation is undefined */
+    if (!filp->f_op->open) {
         /* Return error */
-        retval = -ENOMEM;
+        retval = -ENXIO;
         goto err;
     }
-    bitmap_set_bit(bitmap_fds, fdesc_idx);
-    bitmap_set_bit(task->bitmap_fds, fdesc_idx);
-
-    struct file *filp = files[file_idx];
 
     /* Register new file descriptor on the table */
-    struct fdtable *fdesc = &fdtable[fdesc_idx];
-    fdesc->file = filp;
-    fdesc->flags = flags;
-
-    /* Check if the file operation is undefined */
-    if (!filp->f_op->open) {
-        /* Release the file descriptor */
-        bitmap_clear_bit(bitmap_fds, fdesc_idx);
-        bitmap_clear_bit(task->bitmap_fds, fdesc_idx);
-
+    int fd = fd_install(task, filp, flags);
+    if (fd < 0) {
         /* Return error */
-        retval = -ENXIO;
+        retval = fd;
         goto err;
     }
 
@@ -1015,7 +1231,6 @@ static int sys_open(const char *pathname, int flags)
     filp->f_op->open(filp->f_inode, filp);
 
     /* Return the file descriptor number */
-    int fd = fdesc_idx + FILE_RESERVED_NUM;
     return fd;
 
 err:
@@ -1032,25 +1247,14 @@ static int sys_close(int fd)
     /* Acquire the running task */
     struct task_struct *task = current_task_info();
 
-    /* Invalid file descriptor number */
-    if (fd < FILE_RESERVED_NUM) {
-        retval = -EBADF;
-        goto leave;
-    }
-
-    /* Calculate the index number of the file descriptor */
-    int fdesc_idx = fd - FILE_RESERVED_NUM;
-
     /* Check if the file descriptor belongs to current task */
-    if (!bitmap_get_bit(bitmap_fds, fdesc_idx) ||
-        !bitmap_get_bit(task->bitmap_fds, fdesc_idx)) {
+    if (!fdesc_get(task, fd)) {
         retval = -EBADF;
         goto leave;
     }
 
-    /* Free the file descriptor */
-    bitmap_clear_bit(bitmap_fds, fdesc_idx);
-    bitmap_clear_bit(task->bitmap_fds, fdesc_idx);
+    /* Free the file descriptor and release the file if unused */
+    fd_close(task, fd - FILE_RESERVED_NUM);
 
     /* Return success */
     retval = 0;
@@ -1066,35 +1270,27 @@ static int sys_dup(int oldfd)
 
     int retval;
 
-    if (oldfd < FILE_RESERVED_NUM) {
-        retval = -EBADF;
-        goto leave;
-    }
-
-    /* Convert oldfd to the index numbers on the table */
-    int old_fdesc_idx = oldfd - FILE_RESERVED_NUM;
-
     /* Acquire the running task */
     struct task_struct *task = current_task_info();
 
     /* Check if the file descriptor is invalid */
-    if (!bitmap_get_bit(bitmap_fds, old_fdesc_idx) ||
-        !bitmap_get_bit(task->bitmap_fds, old_fdesc_idx)) {
+    struct fdtable *fdesc = fdesc_get(task, oldfd);
+    if (!fdesc) {
         retval = -EBADF;
         goto leave;
     }
 
     /* Find a free entry on the file descriptor table */
-    int fdesc_idx = find_first_zero_bit(bitmap_fds, OPEN_MAX);
-    if (fdesc_idx >= OPEN_MAX) {
-        retval = -ENOMEM;
+    int fdesc_idx = fd_alloc(task);
+    if (fdesc_idx < 0) {
+        retval = fdesc_idx;
         goto leave;
     }
-    bitmap_set_bit(bitmap_fds, fdesc_idx);
-    bitmap_set_bit(task->bitmap_fds, fdesc_idx);
 
-    /* Copy the old file descriptor content to the new one */
-    fdtable[fdesc_idx] = fdtable[old_fdesc_idx];
+    /* Share the open file description with the old file descriptor */
+    fdesc->refcnt++;
+    task->fdtable[fdesc_idx] = fdesc;
+    bitmap_set_bit(task->bitmap_fds, fdesc_idx);
 
     /* Return new file descriptor number */
     retval = fdesc_idx + FILE_RESERVED_NUM;
@@ -1110,29 +1306,34 @@ static int sys_dup2(int oldfd, int newfd)
 
     int retval;
 
-    /* Convert fds to the index numbers on the table */
-    int old_fdesc_idx = oldfd - FILE_RESERVED_NUM;
+    /* Acquire the running task */
+    struct task_struct *task = current_task_info();
+
+    /* Convert newfd to the index number on the table */
     int new_fdesc_idx = newfd - FILE_RESERVED_NUM;
 
-    if (oldfd < FILE_RESERVED_NUM || newfd < FILE_RESERVED_NUM) {
+    /* Check if the file descriptors are invalid */
+    struct fdtable *fdesc = fdesc_get(task, oldfd);
+    if (!fdesc || new_fdesc_idx < 0 || new_fdesc_idx >= OPEN_MAX) {
         retval = -EBADF;
         goto leave;
     }
 
-    /* Acquire the running task */
-    struct task_struct *task = current_task_info();
-
-    /* Check if the file descriptors are invalid */
-    if (!bitmap_get_bit(bitmap_fds, old_fdesc_idx) ||
-        !bitmap_get_bit(bitmap_fds, new_fdesc_idx) ||
-        !bitmap_get_bit(task->bitmap_fds, old_fdesc_idx) ||
-        !bitmap_get_bit(task->bitmap_fds, new_fdesc_idx)) {
-        retval = -EBADF;
+    /* Nothing to do if both refer to the same open file description */
+    if (task->fdtable[new_fdesc_idx] == fdesc &&
+        bitmap_get_bit(task->bitmap_fds, new_fdesc_idx)) {
+        retval = newfd;
         goto leave;
     }
 
-    /* Copy the old file descriptor content to the new one */
-    fdtable[new_fdesc_idx] = fdtable[old_fdesc_idx];
+    /* Close newfd if it is in use */
+    if (bitmap_get_bit(task->bitmap_fds, new_fdesc_idx))
+        fd_close(task, new_fdesc_idx);
+
+    /* Share the open file description with the old file descriptor */
+    fdesc->refcnt++;
+    task->fdtable[new_fdesc_idx] = fdesc;
+    bitmap_set_bit(task->bitmap_fds, new_fdesc_idx);
 
     /* Return new file descriptor */
     retval = newfd;
@@ -1156,20 +1357,19 @@ static ssize_t sys_read(int fd, void *buf, size_t count)
     if (fd < FILE_RESERVED_NUM) {
         /* Read target is the anonymous pipe of a thread */
         filp = files[fd];
+        running_thread->file_flags = 0;
     } else {
-        /* Calculate the index number of the file descriptor
-         * on the table */
-        int fdesc_idx = fd - FILE_RESERVED_NUM;
-
-        /* Check if the file descriptor is invalid */
-        if (!bitmap_get_bit(bitmap_fds, fdesc_idx) ||
-            !bitmap_get_bit(task->bitmap_fds, fdesc_idx)) {
+        /* Look up the file descriptor table of the task */
+        struct fdtable *fdesc = fdesc_get(task, fd);
+        if (!fdesc) {
             retval = -EBADF;
             goto err;
         }
 
-        filp = fdtable[fdesc_idx].file;
-        filp->f_flags = fdtable[fdesc_idx].flags;
+        filp = fdesc->file;
+
+        /* Pass the flags of the open file description to the file operation */
+        running_thread->file_flags = fdesc->flags;
     }
 
     /* Check if the file operation is undefined */
@@ -1212,20 +1412,19 @@ static ssize_t sys_write(int fd, const void *buf, size_t count)
     if (fd < FILE_RESERVED_NUM) {
         /* Write target is the anonymous pipe of a thread */
         filp = files[fd];
+        running_thread->file_flags = 0;
     } else {
-        /* Calculate the index number of the file descriptor
-         * on the table */
-        int fdesc_idx = fd - FILE_RESERVED_NUM;
-
-        /* Check if the file descriptor is invalid */
-        if (!bitmap_get_bit(bitmap_fds, fdesc_idx) ||
-            !bitmap_get_bit(task->bitmap_fds, fdesc_idx)) {
+        /* Look up the file descriptor table of the task */
+        struct fdtable *fdesc = fdesc_get(task, fd);
+        if (!fdesc) {
             retval = -EBADF;
             goto err;
         }
 
-        filp = fdtable[fdesc_idx].file;
-        filp->f_flags = fdtable[fdesc_idx].flags;
+        filp = fdesc->file;
+
+        /* Pass the flags of the open file description to the file operation */
+        running_thread->file_flags = fdesc->flags;
     }
 
     /* Check if the file operation is undefined */
@@ -1254,92 +1453,98 @@ err:
     return retval;
 }
 
-static int sys_ioctl(int fd, unsigned int request, unsigned long arg)
+static ssize_t file_rw_iter(struct file *filp,
+                            const struct iovec *iov,
+                            int iovcnt,
+                            bool write)
 {
-    int retval;
-
-    preempt_disable();
+    ssize_t retval;
 
-    /* Acquire the running task */
-    struct task_struct *task = current_task_info();
+    /* Transfer all the buffers with one call if the file supports it */
+    if (write ? filp->f_op->write_iter : filp->f_op->read_iter) {
+        while (1) {
+            retval = write ? filp->f_op->write_iter(filp, iov, iovcnt, 0)
+                           : filp->f_op->read_iter(filp, iov, iovcnt, 0);
 
-    /* Get the file pointer */
-    struct file *filp;
-    if (fd < FILE_RESERVED_NUM) {
-        /* I/O control target is the anonymous pipe of a thread */
-        filp = files[fd];
-    } else {
-        /* calculate the index number of the file descriptor
-         * on the table */
-        int fdesc_idx = fd - FILE_RESERVED_NUM;
+            if (retval != -ERESTARTSYS)
+                break;
 
-        /* Check if the file descriptor is invalid */
-        if (!bitmap_get_bit(bitmap_fds, fdesc_idx) ||
-            !bitmap_get_bit(task->bitmap_fds, fdesc_idx)) {
-            retval = -EBADF;
-            goto err;
+            schedule();
         }
 
-        filp = fdtable[fdesc_idx].file;
+        return retval;
     }
 
-    /* Check if the file operation is undefined */
-    if (!filp->f_op->ioctl) {
-        /* Return error */
-        retval = -ENXIO;
-        goto err;
-    }
+    /* Otherwise transfer the buffers one by one */
+    ssize_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        while (1) {
+            retval = write ? filp->f_op->write(filp, iov[i].iov_base,
+                                               iov[i].iov_len, 0)
+                           : filp->f_op->read(filp, iov[i].iov_base,
+                                              iov[i].iov_len, 0);
 
-    preempt_enable();
+            if (retval != -ERESTARTSYS)
+                break;
 
-    /* Call ioctl operation */
-    while (1) {
-        retval = filp->f_op->ioctl(filp, request, arg);
+            schedule();
+        }
 
-        if (retval != -ERESTARTSYS)
-            break;
+        /* Report the error only if nothing has been transferred */
+        if (retval < 0)
+            return total ? total : retval;
 
-        schedule();
-    }
+        total += retval;
 
-    return retval;
+        /* Stop at the first partial transfer */
+        if (retval < iov[i].iov_len)
+            break;
+    }
 
-err:
-    preempt_enable();
-    return retval;
+    return total;
 }
 
-static off_t sys_lseek(int fd, long offset, int whence)
+static ssize_t sys_rw_vector(int fd,
+                             const struct iovec *iov,
+                             int iovcnt,
+                             bool write)
 {
-    off_t retval;
+    ssize_t retval;
 
     preempt_disable();
 
     /* Acquire the running task */
     struct task_struct *task = current_task_info();
 
+    /* Check the number of the buffers */
+    if (iovcnt <= 0 || iovcnt > IOV_MAX) {
+        retval = -EINVAL;
+        goto err;
+    }
+
     /* Get the file pointer */
     struct file *filp;
     if (fd < FILE_RESERVED_NUM) {
-        /* lseek target is the anonymous pipe of a thread */
+        /* Target is the anonymous pipe of a thread */
         filp = files[fd];
+        running_thread->file_flags = 0;
     } else {
-        /* Calculate the index number of the file descriptor
-         * on the table */
-        int fdesc_idx = fd - FILE_RESERVED_NUM;
-
-        /* Check if the file descriptor is invalid */
-        if (!bitmap_get_bit(bitmap_fds, fdesc_idx) ||
-            !bitmap_get_bit(task->bitmap_fds, fdesc_idx)) {
+        /* Look up the file descriptor table of the task */
+        struct fdtable *fdesc = fdesc_get(task, fd);
+        if (!fdesc) {
             retval = -EBADF;
             goto err;
         }
 
-        filp = fdtable[fdesc_idx].file;
+        filp = fdesc->file;
+
+        /* Pass the flags of the open file description to the file operation */
+        running_thread->file_flags = fdesc->flags;
     }
 
     /* Check if the file operation is undefined */
-    if (!filp->f_op->lseek) {
+    if ((write && !filp->f_op->write && !filp->f_op->write_iter) ||
+        (!write && !filp->f_op->read && !filp->f_op->read_iter)) {
         /* Return error */
         retval = -ENXIO;
         goto err;
@@ -1347,23 +1552,577 @@ static off_t sys_lseek(int fd, long offset, int whence)
 
     preempt_enable();
 
-    /* Call lseek operation */
-    while (1) {
-        retval = filp->f_op->lseek(filp, offset, whence);
-
-        if (retval != -ERESTARTSYS)
-            break;
+    /* Call read or write operation */
+    return file_rw_iter(filp, iov, iovcnt, write);
 
-        schedule();
+err:
+    preempt_enable();
+    return retval;
+}
+
+static ssize_t sys_readv(int fd, const struct iovec *iov, int iovcnt)
+{
+    return sys_rw_vector(fd, iov, iovcnt, false);
+}
+
+static ssize_t sys_writev(int fd, const struct iovec *iov, int iovcnt)
+{
+    return sys_rw_vector(fd, iov, iovcnt, true);
+}
+
+static struct file *fd_to_file(struct task_struct *task, int fd, int *flags)
+{
+    if (fd < 0)
+        return NULL;
+
+    if (fd < FILE_RESERVED_NUM) {
+        /* The file is the anonymous pipe of a thread */
+        *flags = 0;
+        return files[fd];
+    }
+
+    /* Look up the file descriptor table of the task */
+    struct fdtable *fdesc = fdesc_get(task, fd);
+    if (!fdesc)
+        return NULL;
+
+    *flags = fdesc->flags;
+    return fdesc->file;
+}
+
+static off_t file_seek(struct file *filp, off_t offset, int whence)
+{
+    off_t retval;
+
+    while (1) {
+        retval = filp->f_op->lseek(filp, offset, whence);
+
+        if (retval != -ERESTARTSYS)
+            break;
+
+        schedule();
+    }
+
+    return retval;
+}
+
+static ssize_t file_splice_io(struct file *filp,
+                              int flags,
+                              char *buf,
+                              size_t size,
+                              off_t *ppos,
+                              bool write)
+{
+    ssize_t retval;
+
+    while (1) {
+        /* Pass the flags of the open file description to the file
+         * operation, which differ between the two ends */
+        running_thread->file_flags = flags;
+
+        if (ppos) {
+            /* Access at the given offset and keep the file offset */
+            retval = write ? filp->f_op->pwrite(filp, buf, size, *ppos)
+                           : filp->f_op->pread(filp, buf, size, *ppos);
+        } else if (file_is_fifo(filp)) {
+            /* Only wait until any data or free space is in the pipe */
+            retval = write ? fifo_splice_write(filp, buf, size)
+                           : fifo_splice_read(filp, buf, size);
+        } else {
+            retval = write ? filp->f_op->write(filp, buf, size, 0)
+                           : filp->f_op->read(filp, buf, size, 0);
+        }
+
+        if (retval != -ERESTARTSYS)
+            break;
+
+        schedule();
+    }
+
+    /* Advance the given offset over the transferred data */
+    if (ppos && retval > 0)
+        *ppos += retval;
+
+    return retval;
+}
+
+static ssize_t file_splice_write(struct file *out,
+                                 int flags,
+                                 off_t *ppos,
+                                 const char *buf,
+                                 size_t size)
+{
+    size_t total = 0;
+
+    /* Write until all data is taken since the pipe may take only a part */
+    while (total < size) {
+        ssize_t retval = file_splice_io(out, flags, (char *) buf + total,
+                                        size - total, ppos, true);
+
+        /* Report the error only if nothing has been written */
+        if (retval <= 0)
+            return total ? total : retval;
+
+        total += retval;
+    }
+
+    return total;
+}
+
+static ssize_t file_splice_mapped(struct file *in,
+                                  off_t *off_in,
+                                  struct file *out,
+                                  int out_flags,
+                                  off_t *off_out,
+                                  size_t count)
+{
+    /* Read from the given offset, or the file offset if none is given */
+    off_t pos = off_in ? *off_in : file_seek(in, 0, SEEK_CUR);
+    if (pos < 0 || pos >= in->f_inode->i_size)
+        return -ENODEV;
+
+    /* Find the size of the rest of the file */
+    size_t size = in->f_inode->i_size - pos;
+    if (count < size)
+        size = count;
+
+    /* Map the file content in place, which is only possible for the
+     * file on the read-only storage (e.g., romfs). Return -ENODEV to fall
+     * back to the copy otherwise */
+    void *addr;
+    if (in->f_op->mmap(in, pos, size, PROT_READ, &addr))
+        return -ENODEV;
+
+    /* Write the data out from the storage directly */
+    ssize_t retval = file_splice_write(out, out_flags, off_out, addr, size);
+    if (in->f_op->munmap)
+        in->f_op->munmap(in, addr, size);
+
+    /* Advance the offset over the written data */
+    if (retval > 0) {
+        if (off_in)
+            *off_in += retval;
+        else
+            file_seek(in, pos + retval, SEEK_SET);
+    }
+
+    return retval;
+}
+
+static ssize_t file_splice(struct file *in,
+                           int in_flags,
+                           off_t *off_in,
+                           struct file *out,
+                           int out_flags,
+                           off_t *off_out,
+                           size_t count)
+{
+    ssize_t retval = 0;
+
+    /* The given offsets are accessed with the positional operations so
+     * the file offsets shared with the other threads stay untouched */
+    if ((off_in && !in->f_op->pread) || (off_out && !out->f_op->pwrite))
+        return -ESPIPE;
+
+    if ((off_in && *off_in < 0) || (off_out && *off_out < 0))
+        return -EINVAL;
+
+    /* Skip the copy if the input can be mapped */
+    if (in->f_op->mmap && (off_in || in->f_op->lseek)) {
+        retval =
+            file_splice_mapped(in, off_in, out, out_flags, off_out, count);
+        if (retval != -ENODEV)
+            return retval;
+        retval = 0;
+    }
+
+    /* Otherwise move the data through a kernel buffer in large chunks */
+    char *buf = kmalloc(SPLICE_BUF_SIZE);
+    if (!buf)
+        return -ENOMEM;
+
+    size_t total = 0;
+    while (total < count) {
+        size_t size = count - total;
+        if (size > SPLICE_BUF_SIZE)
+            size = SPLICE_BUF_SIZE;
+
+        /* Read the next chunk */
+        ssize_t read_size =
+            file_splice_io(in, in_flags, buf, size, off_in, false);
+        if (read_size <= 0) {
+            retval = read_size;
+            break;
+        }
+
+        /* Write the chunk out */
+        ssize_t write_size =
+            file_splice_write(out, out_flags, off_out, buf, read_size);
+        if (write_size > 0)
+            total += write_size;
+
+        if (write_size < read_size) {
+            /* Give the data not written back to the seekable input */
+            size_t unwritten = read_size - (write_size > 0 ? write_size : 0);
+            if (off_in)
+                *off_in -= unwritten;
+            else if (in->f_op->lseek && !file_is_fifo(in))
+                file_seek(in, -(off_t) unwritten, SEEK_CUR);
+
+            retval = write_size;
+            break;
+        }
+
+        /* Stop at the short read, e.g., the end of the file or the pipe
+         * has no more data */
+        if (read_size < size)
+            break;
+    }
+
+    kfree(buf);
+
+    /* Report the error only if nothing has been transferred */
+    return total ? total : retval;
+}
+
+static ssize_t sys_sendfile(int out_fd, int in_fd, off_t *offset, size_t count)
+{
+    ssize_t retval;
+
+    preempt_disable();
+
+    /* Acquire the running task */
+    struct task_struct *task = current_task_info();
+
+    /* Get the file pointers */
+    int in_flags, out_flags;
+    struct file *in = fd_to_file(task, in_fd, &in_flags);
+    struct file *out = fd_to_file(task, out_fd, &out_flags);
+    if (!in || !out) {
+        retval = -EBADF;
+        goto err;
+    }
+
+    /* Check if the file operations are undefined */
+    if (!in->f_op->read || !out->f_op->write) {
+        retval = -ENXIO;
+        goto err;
+    }
+
+    preempt_enable();
+
+    return file_splice(in, in_flags, offset, out, out_flags, NULL, count);
+
+err:
+    preempt_enable();
+    return retval;
+}
+
+static ssize_t sys_splice(const struct splice_args *args)
+{
+    ssize_t retval;
+
+    preempt_disable();
+
+    /* Acquire the running task */
+    struct task_struct *task = current_task_info();
+
+    /* Get the file pointers */
+    int in_flags, out_flags;
+    struct file *in = fd_to_file(task, args->fd_in, &in_flags);
+    struct file *out = fd_to_file(task, args->fd_out, &out_flags);
+    if (!in || !out) {
+        retval = -EBADF;
+        goto err;
+    }
+
+    /* One end must be a pipe, and the two ends must be different */
+    bool in_fifo = file_is_fifo(in), out_fifo = file_is_fifo(out);
+    unsigned int valid_flags =
+        SPLICE_F_MOVE | SPLICE_F_NONBLOCK | SPLICE_F_MORE;
+    if ((!in_fifo && !out_fifo) || in == out || (args->flags & ~valid_flags)) {
+        retval = -EINVAL;
+        goto err;
+    }
+
+    /* The pipe has no file offset */
+    if ((in_fifo && args->off_in) || (out_fifo && args->off_out)) {
+        retval = -ESPIPE;
+        goto err;
+    }
+
+    /* Check if the file operations are undefined */
+    if (!in->f_op->read || !out->f_op->write) {
+        retval = -ENXIO;
+        goto err;
     }
 
+    /* SPLICE_F_NONBLOCK only applies to the pipe */
+    if (args->flags & SPLICE_F_NONBLOCK) {
+        if (in_fifo)
+            in_flags |= O_NONBLOCK;
+        if (out_fifo)
+            out_flags |= O_NONBLOCK;
+    }
+
+    preempt_enable();
+
+    return file_splice(in, in_flags, args->off_in, out, out_flags,
+                       args->off_out, args->len);
+
+err:
+    preempt_enable();
     return retval;
+}
+
+static int sys_ioctl(int fd, unsigned int request, unsigned long arg)
+{
+    int retval;
+
+    preempt_disable();
+
+    /* Acquire the running task */
+    struct task_struct *task = current_task_info();
+
+    /* Get the file pointer */
+    struct file *filp;
+    if (fd < FILE_RESERVED_NUM) {
+        /* I/O control target is the anonymous pipe of a thread */
+        filp = files[fd];
+    } else {
+        /* Look up the file descriptor table of the task */
+        struct fdtable *fdesc = fdesc_get(task, fd);
+        if (!fdesc) {
+            retval = -EBADF;
+            goto err;
+        }
+
+        filp = fdesc->file;
+    }
+
+    /* Check if the file operation is undefined */
+    if (!filp->f_op->ioctl) {
+        /* Return error */
+        retval = -ENXIO;
+        goto err;
+    }
+
+    preempt_enable();
+
+    /* Call ioctl operation */
+    while (1) {
+        retval = filp->f_op->ioctl(filp, request, arg);
+
+        if (retval != -ERESTARTSYS)
+            break;
+
+        schedule();
+    }
+
+    return retval;
+
+err:
+    preempt_enable();
+    return retval;
+}
+
+static int sys_io_uring_enter(struct io_uring *ring)
+{
+    unsigned int mask = ring->entries - 1;
+    bool cancel = false;
+    int cnt = 0;
+
+    /* The size of the queues must be power of 2 */
+    if (ring->entries == 0 || (ring->entries & mask))
+        return -EINVAL;
+
+    /* Execute the requests in the order of submission */
+    while (ring->sq_head != ring->sq_tail) {
+        /* Stop if the completion queue has no space */
+        if (ring->cq_tail - ring->cq_head >= ring->entries)
+            return cnt ? cnt : -EBUSY;
+
+        struct io_uring_sqe *sqe = &ring->sqes[ring->sq_head & mask];
+        int res;
+
+        if (cancel) {
+            /* The previous linked request failed */
+            res = -ECANCELED;
+        } else {
+            switch (sqe->opcode) {
+            case IORING_OP_NOP:
+                res = 0;
+                break;
+            case IORING_OP_READ:
+                res = sys_read(sqe->fd, (void *) sqe->addr, sqe->len);
+                break;
+            case IORING_OP_WRITE:
+                res = sys_write(sqe->fd, (void *) sqe->addr, sqe->len);
+                break;
+            case IORING_OP_IOCTL:
+                res = sys_ioctl(sqe->fd, sqe->len, sqe->addr);
+                break;
+            default:
+                res = -EINVAL;
+            }
+        }
+
+        /* Cancel the rest of the link if the request failed */
+        cancel = (sqe->flags & IOSQE_IO_LINK) && (cancel || res < 0);
+
+        /* Post the result to the completion queue */
+        struct io_uring_cqe *cqe = &ring->cqes[ring->cq_tail & mask];
+        cqe->user_data = sqe->user_data;
+        cqe->res = res;
+
+        ring->sq_head++;
+        ring->cq_tail++;
+        cnt++;
+    }
+
+    /* Return the number of the executed requests */
+    return cnt;
+}
+
+static off_t sys_lseek(int fd, long offset, int whence)
+{
+    off_t retval;
+
+    preempt_disable();
+
+    /* Acquire the running task */
+    struct task_struct *task = current_task_info();
+
+    /* Get the file pointer */
+    struct file *filp;
+    if (fd < FILE_RESERVED_NUM) {
+        /* lseek target is the anonymous pipe of a thread */
+        filp = files[fd];
+    } else {
+        /* Look up the file descriptor table of the task */
+        struct fdtable *fdesc = fdesc_get(task, fd);
+        if (!fdesc) {
+            retval = -EBADF;
+            goto err;
+        }
+
+        filp = fdesc->file;
+    }
+
+    /* Check if the file operation is undefined */
+    if (!filp->f_op->lseek) {
+        /* Return error */
+        retval = -ENXIO;
+        goto err;
+    }
+
+    preempt_enable();
+
+    /* Call lseek operation */
+    while (1) {
+        retval = filp->f_op->lseek(filp, offset, whence);
+
+        if (retval != -ERESTARTSYS)
+            break;
+
+        schedule();
+    }
+
+    return retval;
+
+err:
+    preempt_enable();
+    return retval;
+}
+
+static int sys_fcntl(int fd, int cmd, unsigned long arg)
+{
+    preempt_disable();
+
+    int retval;
+
+    /* Acquire the running task */
+    struct task_struct *task = current_task_info();
+
+    /* Get the file pointer */
+    struct file *filp;
+    if (fd < FILE_RESERVED_NUM) {
+        /* fcntl target is the anonymous pipe of a thread */
+        filp = files[fd];
+    } else {
+        /* Look up the file descriptor table of the task */
+        struct fdtable *fdesc = fdesc_get(task, fd);
+        if (!fdesc) {
+            retval = -EBADF;
+            goto leave;
+        }
+
+        filp = fdesc->file;
+    }
+
+    switch (cmd) {
+    case F_GETPIPE_SZ:
+    case F_SETPIPE_SZ:
+        retval = fifo_fcntl(filp, cmd, arg);
+        break;
+    default:
+        retval = -EINVAL;
+    }
+
+leave:
+    preempt_enable();
+    return retval;
+}
+
+static int sys_ftruncate(int fd, off_t length)
+{
+    preempt_disable();
+
+    int retval;
+
+    /* Acquire the running task */
+    struct task_struct *task = current_task_info();
+
+    if (fd < FILE_RESERVED_NUM) {
+        retval = -EBADF;
+        goto leave;
+    }
+
+    /* Look up the file descriptor table of the task */
+    struct fdtable *fdesc = fdesc_get(task, fd);
+    if (!fdesc) {
+        retval = -EBADF;
+        goto leave;
+    }
+
+    /* Check if the file is opened with writing flag */
+    int flags = fdesc->flags;
+    if ((flags & (0x1)) != O_WRONLY && !(flags & O_RDWR)) {
+        retval = -EBADF;
+        goto leave;
+    }
+
+    /* Check if the file operation is undefined */
+    struct file *filp = fdesc->file;
+    if (!filp->f_op->truncate) {
+        retval = -EINVAL;
+        goto leave;
+    }
+
+    /* Call truncate operation */
+    retval = filp->f_op->truncate(filp, length);
 
-err:
+leave:
     preempt_enable();
     return retval;
 }
 
+static void sys_sync(void)
+{
+    /* Write the dirty blocks of all devices */
+    bcache_sync(NULL);
+}
+
 static int sys_fstat(int fd, struct stat *statbuf)
 {
     preempt_disable();
@@ -1378,19 +2137,15 @@ static int sys_fstat(int fd, struct stat *statbuf)
         goto leave;
     }
 
-    /* Calculate the index number of the file descriptor
-     * on the table */
-    int fdesc_idx = fd - FILE_RESERVED_NUM;
-
-    /* Check if the file descriptor is invalid */
-    if (!bitmap_get_bit(bitmap_fds, fdesc_idx) ||
-        !bitmap_get_bit(task->bitmap_fds, fdesc_idx)) {
+    /* Look up the file descriptor table of the task */
+    struct fdtable *fdesc = fdesc_get(task, fd);
+    if (!fdesc) {
         retval = -EBADF;
         goto leave;
     }
 
     /* Get file inode */
-    struct inode *inode = fdtable[fdesc_idx].file->f_inode;
+    struct inode *inode = fdesc->file->f_inode;
 
     /* Check if the inode exists */
     if (inode != NULL) { /* XXX */
@@ -1415,30 +2170,16 @@ static int sys_opendir(const char *pathname, DIR *dirp /* FIXME */)
     if (strlen(pathname) >= PATH_MAX)
         return -ENAMETOOLONG;
 
-    int tid = running_thread->tid;
-
-    /* Send directory open request to the file system daemon */
-    request_open_directory(tid, pathname);
-
-    /* Read the directory inode from the file system daemon */
-    struct inode *inode_dir;
-    int fifo_retval;
-    while (1) {
-        fifo_retval = fifo_read(files[THREAD_PIPE_FD(tid)], (char *) &inode_dir,
-                                sizeof(inode_dir), 0);
-
-        if (fifo_retval != -ERESTARTSYS)
-            break;
-
-        schedule();
-    }
+    /* Look up the directory inode */
+    struct inode *inode_dir = vfs_opendir(pathname);
+    if (!inode_dir)
+        return -ENOENT;
 
     /* Return directory information */
     dirp->inode_dir = inode_dir;
     dirp->dentry_list = inode_dir->i_dentry.next;
 
-    /* Check if the information is retrieved successfully */
-    return dirp->inode_dir ? 0 : -ENOENT;
+    return 0;
 }
 
 static int sys_readdir(DIR *dirp, struct dirent *dirent)
@@ -1452,49 +2193,12 @@ static int sys_readdir(DIR *dirp, struct dirent *dirent)
 
 static char *sys_getcwd(char *buf, size_t size)
 {
-    int tid = running_thread->tid;
-
-    /* Send getcwd request to the file system daemon */
-    request_getcwd(tid, buf, size);
-
-    /* Read getcwd result from the file system daemon */
-    char *path;
-    int fifo_retval;
-    while (1) {
-        fifo_retval = fifo_read(files[THREAD_PIPE_FD(tid)], (char *) &path,
-                                sizeof(path), 0);
-
-        if (fifo_retval != -ERESTARTSYS)
-            break;
-
-        schedule();
-    }
-
-    return path;
+    return vfs_getcwd(buf, size);
 }
 
 static int sys_chdir(const char *path)
 {
-    int tid = running_thread->tid;
-
-    /* Send chdir request to the file system daemon */
-    request_chdir(tid, path);
-
-    /* Read chdir result from the file system daemon */
-    int chdir_result;
-    int fifo_retval;
-    while (1) {
-        fifo_retval =
-            fifo_read(files[THREAD_PIPE_FD(tid)], (char *) &chdir_result,
-                      sizeof(chdir_result), 0);
-
-        if (fifo_retval != -ERESTARTSYS)
-            break;
-
-        schedule();
-    }
-
-    return chdir_result;
+    return vfs_chdir(path);
 }
 
 static int sys_getpid(void)
@@ -1508,23 +2212,8 @@ static int sys_mknod(const char *pathname, mode_t mode, dev_t dev)
     if (strlen(pathname) >= PATH_MAX)
         return -ENAMETOOLONG;
 
-    int tid = running_thread->tid;
-
-    /* Send file create request to the file system daemon */
-    request_create_file(tid, pathname, dev);
-
-    /* Read file index from the file system daemon  */
-    int file_idx;
-    int fifo_retval;
-    while (1) {
-        fifo_retval = fifo_read(files[THREAD_PIPE_FD(tid)], (char *) &file_idx,
-                                sizeof(file_idx), 0);
-
-        if (fifo_retval != -ERESTARTSYS)
-            break;
-
-        schedule();
-    }
+    /* Create the file */
+    int file_idx = vfs_create(pathname, dev);
 
     if (file_idx == -1) {
         /* Failed to create file */
@@ -1541,124 +2230,425 @@ static int sys_mkfifo(const char *pathname, mode_t mode)
     if (strlen(pathname) >= PATH_MAX)
         return -ENAMETOOLONG;
 
-    int tid = running_thread->tid;
+    /* Create the FIFO */
+    int file_idx = vfs_create(pathname, S_IFIFO);
 
-    /* Send file create request to the file system daemon */
-    request_create_file(tid, pathname, S_IFIFO);
+    if (file_idx == -1) {
+        /* Failed to create FIFO */
+        return -1; /* TODO: Specify the failed reason */
+    } else {
+        /* Return success */
+        return 0;
+    }
+}
 
-    /* Read the file index from the file system daemon */
-    int file_idx = 0;
-    int fifo_retval;
-    while (1) {
-        fifo_retval = fifo_read(files[THREAD_PIPE_FD(tid)], (char *) &tid,
-                                sizeof(file_idx), 0);
+void poll_notify_match(bool (*match)(struct file *filp, void *arg), void *arg)
+{
+    /* Iterate through all threads suspended by the poll() syscall */
+    struct list_head *curr_thread_l, *next_thread_l;
+    list_for_each_safe (curr_thread_l, next_thread_l, &poll_list) {
+        struct thread_info *thread =
+            list_entry(curr_thread_l, struct thread_info, list);
 
-        if (fifo_retval != -ERESTARTSYS)
-            break;
+        /* Wake up the thread if any of its polling files matches */
+        struct file *file;
+        list_for_each_entry (file, &thread->poll_files_list, list) {
+            if (match(file, arg)) {
+                finish_wait(thread);
+                break;
+            }
+        }
+    }
+}
+
+static bool poll_file_match(struct file *filp, void *notify_file)
+{
+    return filp == notify_file;
+}
+
+void poll_notify(struct file *notify_file)
+{
+    poll_notify_match(poll_file_match, notify_file);
+}
+
+static int sys_poll(struct pollfd *fds, nfds_t nfds, int timeout)
+{
+    preempt_disable();
+
+    int retval;
+
+    /* Acquire the running task */
+    struct task_struct *task = current_task_info();
+
+    /* Set polling deadline */
+    if (timeout > 0) {
+        struct timespec tp;
+        get_sys_time(&tp);
+        time_add(&tp, 0, timeout * 1000000);
+        running_thread->syscall_timeout = tp;
+    }
+
+    /* Initialize the polling file list */
+    INIT_LIST_HEAD(&running_thread->poll_files_list);
+
+    /* Check file events */
+    struct file *filp;
+    bool no_event = true;
+
+    for (int i = 0; i < nfds; i++) {
+        struct fdtable *fdesc = fdesc_get(task, fds[i].fd);
+
+        /* Report the invalid file descriptor as an event */
+        if (!fdesc) {
+            fds[i].revents = POLLNVAL;
+            no_event = false;
+            continue;
+        }
+
+        filp = fdesc->file;
+
+        /* Files with the poll operation report their own events */
+        uint32_t events =
+            filp->f_op->poll ? filp->f_op->poll(filp) : filp->f_events;
+        if (fds[i].events & events) {
+            no_event = false;
+        }
+
+        /* Return file events */
+        fds[i].revents = fds[i].events & events;
+    }
+
+    if (!no_event) {
+        /* Return success */
+        retval = 0;
+        goto leave;
+    }
+
+    /* No events is observed and no timeout is set, return immediately */
+    if (timeout == 0) {
+        /* return error */
+        retval = -1; /* TODO: Specify the failed reason */
+        goto leave;
+    }
+
+    /* Suspend current thread */
+    prepare_to_wait(&poll_list, running_thread, THREAD_WAIT);
+
+    /* Add current thread into the timeout monitoring list */
+    if (timeout > 0)
+        list_add(&running_thread->timeout_list, &timeout_list);
+
+    /* Record all files for polling */
+    for (int i = 0; i < nfds; i++) {
+        filp = fdesc_get(task, fds[i].fd)->file;
+        list_add(&filp->list, &running_thread->poll_files_list);
+    }
+
+    /* Wait until the file event happens */
+    schedule();
+
+    /* clear list of poll files */
+    INIT_LIST_HEAD(&running_thread->poll_files_list);
+
+    /* Remove the thread from the polling list */
+    if (timeout > 0)
+        list_del(&running_thread->timeout_list);
+
+    /* TODO: Specify the failed reason */
+    retval = (running_thread->syscall_is_timeout) ? -1 : 0;
+
+leave:
+    preempt_enable();
+    return retval;
+}
+
+static int aio_submit_request(struct aiocb *aiocbp, int opcode)
+{
+    preempt_disable();
+
+    int retval;
+
+    /* Acquire the running task */
+    struct task_struct *task = current_task_info();
+
+    /* Check the notification method */
+    int notify = aiocbp->aio_sigevent.sigev_notify;
+    if ((notify != SIGEV_NONE && notify != SIGEV_SIGNAL) ||
+        (notify == SIGEV_SIGNAL &&
+         !is_signal_defined(aiocbp->aio_sigevent.sigev_signo))) {
+        retval = -EINVAL;
+        goto leave;
+    }
+
+    /* Get the file to operate on */
+    struct file *filp;
+    int flags = 0;
+    int fd = aiocbp->aio_fildes;
+    if (fd < 0) {
+        retval = -EBADF;
+        goto leave;
+    } else if (fd < FILE_RESERVED_NUM) {
+        /* Anonymous pipe of a thread */
+        filp = files[fd];
+    } else {
+        /* Look up the file descriptor table of the task */
+        struct fdtable *fdesc = fdesc_get(task, fd);
+        if (!fdesc) {
+            retval = -EBADF;
+            goto leave;
+        }
+
+        filp = fdesc->file;
+        flags = fdesc->flags;
+    }
+
+    /* Check if the file operation is undefined */
+    if ((opcode == LIO_READ && !filp->f_op->read) ||
+        (opcode == LIO_WRITE && !filp->f_op->write)) {
+        retval = -ENXIO;
+        goto leave;
+    }
+
+    /* Allocate the request, which is freed by the AIO daemon */
+    struct aio_request *req = kmalloc(sizeof(struct aio_request));
+    if (!req) {
+        retval = -EAGAIN;
+        goto leave;
+    }
+
+    aiocbp->aio_lio_opcode = opcode;
+
+    req->aiocbp = aiocbp;
+    req->filp = filp;
+    req->flags = flags;
+    req->tid = running_thread->tid;
+
+    /* Queue the request to the AIO daemon */
+    aio_submit(req);
+
+    /* Return success */
+    retval = 0;
+
+leave:
+    preempt_enable();
+    return retval;
+}
+
+static int sys_aio_read(struct aiocb *aiocbp)
+{
+    return aio_submit_request(aiocbp, LIO_READ);
+}
+
+static int sys_aio_write(struct aiocb *aiocbp)
+{
+    return aio_submit_request(aiocbp, LIO_WRITE);
+}
+
+static int sys_aio_suspend(const struct aiocb *const list[],
+                           int nent,
+                           const struct timespec *timeout)
+{
+    preempt_disable();
+
+    int retval;
+
+    /* Set the waiting deadline */
+    if (timeout) {
+        struct timespec tp;
+        get_sys_time(&tp);
+        time_add(&tp, timeout->tv_sec, timeout->tv_nsec);
+        running_thread->syscall_timeout = tp;
+        running_thread->syscall_is_timeout = false;
+        list_add(&running_thread->timeout_list, &timeout_list);
+    }
+
+    /* Wake up by every completion until one of the requests is done */
+    while (!aio_any_done(list, nent)) {
+        if (timeout && running_thread->syscall_is_timeout) {
+            retval = -EAGAIN;
+            goto leave;
+        }
+
+        aio_prepare_to_wait();
+        schedule();
+    }
+
+    /* Return success */
+    retval = 0;
+
+leave:
+    /* Remove the thread from the timeout monitoring list */
+    if (timeout)
+        list_del(&running_thread->timeout_list);
+
+    preempt_enable();
+    return retval;
+}
+
+static int sys_topic_open(const struct topic_metadata *meta, int flags)
+{
+    preempt_disable();
+
+    int retval;
+
+    /* Acquire the running task */
+    struct task_struct *task = current_task_info();
+
+    /* Check if the task can open more files */
+    if (fd_alloc(task) < 0) {
+        retval = -EMFILE;
+        goto leave;
+    }
+
+    /* Open the topic with a new file for the caller */
+    struct file *filp;
+    retval = __topic_open(meta, flags, &filp);
+    if (retval)
+        goto leave;
+
+    /* Register new file descriptor on the table and return the number */
+    retval = fd_install(task, filp, flags);
+
+leave:
+    preempt_enable();
+    return retval;
+}
+
+static int sys_shm_open(const char *name, int oflag, mode_t mode)
+{
+    preempt_disable();
+
+    int retval;
+
+    /* Acquire the running task */
+    struct task_struct *task = current_task_info();
 
-        schedule();
+    /* Check if the task can open more files */
+    if (fd_alloc(task) < 0) {
+        retval = -EMFILE;
+        goto leave;
     }
 
-    if (file_idx == -1) {
-        /* Failed to create FIFO */
-        return -1; /* TODO: Specify the failed reason */
-    } else {
-        /* Return success */
-        return 0;
-    }
+    /* Open or create the shared memory object */
+    struct file *filp;
+    retval = __shm_open(name, oflag, &filp);
+    if (retval)
+        goto leave;
+
+    /* Register new file descriptor on the table and return the number */
+    retval = fd_install(task, filp, oflag);
+
+leave:
+    preempt_enable();
+    return retval;
 }
 
-void poll_notify(struct file *notify_file)
+static int sys_shm_unlink(const char *name)
 {
-    /* Iterate through all threads suspended by the poll() syscall */
-    struct list_head *curr_thread_l, *next_thread_l;
-    list_for_each_safe (curr_thread_l, next_thread_l, &poll_list) {
-        struct thread_info *thread =
-            list_entry(curr_thread_l, struct thread_info, list);
+    preempt_disable();
+    int retval = __shm_unlink(name);
+    preempt_enable();
 
-        struct file *file;
-        list_for_each_entry (file, &thread->poll_files_list, list) {
-            if (file == notify_file)
-                finish_wait(thread);
-        }
-    }
+    return retval;
 }
 
-static int sys_poll(struct pollfd *fds, nfds_t nfds, int timeout)
+static void *sys_mmap(const struct mmap_args *args)
 {
     preempt_disable();
 
-    int retval;
+    void *retval = MAP_FAILED;
 
-    /* Set polling deadline */
-    if (timeout > 0) {
-        struct timespec tp;
-        get_sys_time(&tp);
-        time_add(&tp, 0, timeout * 1000000);
-        running_thread->syscall_timeout = tp;
-    }
+    /* Acquire the running task */
+    struct task_struct *task = current_task_info();
 
-    /* Initialize the polling file list */
-    INIT_LIST_HEAD(&running_thread->poll_files_list);
+    /* Only shared mapping is supported */
+    if (args->flags != MAP_SHARED || args->length == 0 ||
+        (args->prot & ~(PROT_READ | PROT_WRITE)))
+        goto leave;
 
-    /* Check file events */
-    struct file *filp;
-    bool no_event = true;
+    if (args->fd < FILE_RESERVED_NUM)
+        goto leave;
 
-    for (int i = 0; i < nfds; i++) {
-        int fd = fds[i].fd - FILE_RESERVED_NUM;
-        filp = fdtable[fd].file;
+    /* Look up the file descriptor table of the task */
+    struct fdtable *fdesc = fdesc_get(task, args->fd);
+    if (!fdesc)
+        goto leave;
 
-        uint32_t events = filp->f_events;
-        if (~fds[i].events & events) {
-            no_event = false;
-        }
+    /* Writable mapping requires the file to be opened with O_RDWR */
+    if ((args->prot & PROT_WRITE) && !(fdesc->flags & O_RDWR))
+        goto leave;
 
-        /* Return file events */
-        fds[i].revents |= events;
+    /* Check if the file can be mapped */
+    struct file *filp = fdesc->file;
+    if (!filp->f_op->mmap)
+        goto leave;
+
+    /* Find a free memory mapping entry of the task */
+    struct vm_area *vma = NULL;
+    for (int i = 0; i < MMAP_MAX; i++) {
+        if (!task->mmaps[i].start) {
+            vma = &task->mmaps[i];
+            break;
+        }
     }
 
-    if (!no_event) {
-        /* Return success */
-        retval = 0;
+    if (!vma)
         goto leave;
-    }
 
-    /* No events is observed and no timeout is set, return immediately */
-    if (timeout == 0) {
-        /* return error */
-        retval = -1; /* TODO: Specify the failed reason */
+    /* Call mmap operation */
+    void *addr;
+    if (filp->f_op->mmap(filp, args->offset, args->length, args->prot,
+                         &addr))
+        goto leave;
+
+#if (USE_MMAP_MPU != 0)
+    /* The permissions are only enforced if the mapping forms a valid MPU
+     * region, i.e., a power-of-two size of at least 32 bytes with the base
+     * address aligned to it. Rounding the region up would change the
+     * permissions of the memory next to the mapping */
+    if (args->length < 32 || (args->length & (args->length - 1)) ||
+        ((uintptr_t) addr & (args->length - 1))) {
+        if (filp->f_op->munmap)
+            filp->f_op->munmap(filp, addr, args->length);
         goto leave;
     }
+#endif
 
-    /* Suspend current thread */
-    prepare_to_wait(&poll_list, running_thread, THREAD_WAIT);
+    /* Record the new memory mapping */
+    vma->start = addr;
+    vma->size = args->length;
+    vma->prot = args->prot;
+    vma->filp = filp;
 
-    /* Add current thread into the timeout monitoring list */
-    if (timeout > 0)
-        list_add(&running_thread->timeout_list, &timeout_list);
+    /* Return the address of the mapping */
+    retval = addr;
 
-    /* Record all files for polling */
-    for (int i = 0; i < nfds; i++) {
-        int fd = fds[i].fd - FILE_RESERVED_NUM;
-        filp = fdtable[fd].file;
-        list_add(&filp->list, &running_thread->poll_files_list);
-    }
+leave:
+    preempt_enable();
+    return retval;
+}
 
-    /* Wait until the file event happens */
-    schedule();
+static int sys_munmap(void *addr, size_t length)
+{
+    preempt_disable();
 
-    /* clear list of poll files */
-    INIT_LIST_HEAD(&running_thread->poll_files_list);
+    int retval = -EINVAL;
 
-    /* Remove the thread from the polling list */
-    if (timeout > 0)
-        list_del(&running_thread->timeout_list);
+    /* Acquire the running task */
+    struct task_struct *task = current_task_info();
 
-    /* TODO: Specify the failed reason */
-    retval = (running_thread->syscall_is_timeout) ? -1 : 0;
+    /* Find the memory mapping starts from the given address */
+    for (int i = 0; i < MMAP_MAX; i++) {
+        struct vm_area *vma = &task->mmaps[i];
+        if (vma->start && vma->start == addr) {
+            /* Delete the memory mapping */
+            vma->filp->f_op->munmap(vma->filp, vma->start, vma->size);
+            vma->start = NULL;
+            retval = 0;
+            break;
+        }
+    }
 
-leave:
     preempt_enable();
     return retval;
 }
@@ -1748,7 +2738,10 @@ struct mqueue *acquire_mqueue(const char *name)
     return NULL;
 }
 
-static mqd_t sys_mq_open(const char *name, int oflag, struct mq_attr *attr)
+static mqd_t _mq_open(const char *name,
+                      int oflag,
+                      struct mq_attr *attr,
+                      void *mem)
 {
     preempt_disable();
 
@@ -1804,8 +2797,9 @@ static mqd_t sys_mq_open(const char *name, int oflag, struct mq_attr *attr)
         goto leave;
     }
 
-    /* Allocate new message queue */
-    struct mqueue *new_mq = __mq_allocate(attr);
+    /* Allocate new message queue or use the memory provided by the user */
+    struct mqueue *new_mq =
+        mem ? __mq_init_static(attr, mem) : __mq_allocate(attr);
 
     /* Memory allocation failure */
     if (!new_mq) {
@@ -1834,6 +2828,23 @@ leave:
     return retval;
 }
 
+static mqd_t sys_mq_open(const char *name, int oflag, struct mq_attr *attr)
+{
+    return _mq_open(name, oflag, attr, NULL);
+}
+
+static mqd_t sys_mq_open_static(const char *name,
+                                int oflag,
+                                struct mq_attr *attr,
+                                void *mem)
+{
+    /* The attributes are required to determine the memory layout */
+    if (!attr || !mem)
+        return -EINVAL;
+
+    return _mq_open(name, oflag, attr, mem);
+}
+
 static int sys_mq_close(mqd_t mqdes)
 {
     preempt_disable();
@@ -1849,7 +2860,7 @@ static int sys_mq_close(mqd_t mqdes)
     }
 
     /* Free the message queue descriptor */
-    bitmap_clear_bit(bitmap_mqds, mqdes);
+    mqd_release(mqdes);
     bitmap_clear_bit(task->bitmap_mqds, mqdes);
 
     /* Return success */
@@ -1881,7 +2892,15 @@ static int sys_mq_unlink(const char *name)
         goto leave;
     }
 
+    /* Detach the descriptors still referring to the message queue, the
+     * message buffers on loan are released together with the queue */
+    for (int i = 0; i < MQUEUE_MAX; i++) {
+        if (mqd_table[i].mq == mq)
+            mqd_table[i].mq = NULL;
+    }
+
     /* Remove the message queue from the system */
+    list_del(&mq->list);
     __mq_free(mq);
 
     /* Return success */
@@ -1982,6 +3001,128 @@ leave:
     return retval;
 }
 
+static int sys_mq_reserve(mqd_t mqdes, void **msg_ptr)
+{
+    preempt_disable();
+
+    int retval;
+
+    /* Check if the message queue descriptor is invalid */
+    struct task_struct *task = current_task_info();
+    if (!bitmap_get_bit(bitmap_mqds, mqdes) ||
+        !bitmap_get_bit(task->bitmap_mqds, mqdes)) {
+        retval = -EBADF;
+        goto leave;
+    }
+
+    /* Acquire the message queue */
+    struct mqueue *mq = mqd_table[mqdes].mq;
+
+    /* Reserve a message buffer */
+    while (1) {
+        retval = __mq_reserve(mq, &mqd_table[mqdes].attr, mqdes, msg_ptr);
+
+        if (retval != -ERESTARTSYS)
+            break;
+
+        schedule();
+    }
+
+leave:
+    preempt_enable();
+    return retval;
+}
+
+static int sys_mq_commit(mqd_t mqdes,
+                         void *msg_ptr,
+                         size_t msg_len,
+                         unsigned int msg_prio)
+{
+    preempt_disable();
+
+    int retval;
+
+    /* Check if the message priority exceeds the max value */
+    if (msg_prio > MQ_PRIO_MAX) {
+        retval = -EINVAL;
+        goto leave;
+    }
+
+    /* Check if the message queue descriptor is invalid */
+    struct task_struct *task = current_task_info();
+    if (!bitmap_get_bit(bitmap_mqds, mqdes) ||
+        !bitmap_get_bit(task->bitmap_mqds, mqdes)) {
+        retval = -EBADF;
+        goto leave;
+    }
+
+    /* Send the message in the reserved buffer */
+    retval = __mq_commit(mqd_table[mqdes].mq, &mqd_table[mqdes].attr, mqdes,
+                         msg_ptr, msg_len, msg_prio);
+
+leave:
+    preempt_enable();
+    return retval;
+}
+
+static ssize_t sys_mq_borrow(mqd_t mqdes,
+                             void **msg_ptr,
+                             unsigned int *msg_prio)
+{
+    preempt_disable();
+
+    ssize_t retval;
+
+    /* Check if the message queue descriptor is invalid */
+    struct task_struct *task = current_task_info();
+    if (!bitmap_get_bit(bitmap_mqds, mqdes) ||
+        !bitmap_get_bit(task->bitmap_mqds, mqdes)) {
+        retval = -EBADF;
+        goto leave;
+    }
+
+    /* Acquire the message queue */
+    struct mqueue *mq = mqd_table[mqdes].mq;
+
+    /* Borrow message */
+    while (1) {
+        retval = __mq_borrow(mq, &mqd_table[mqdes].attr, mqdes, msg_ptr,
+                             msg_prio);
+
+        if (retval != -ERESTARTSYS)
+            break;
+
+        schedule();
+    }
+
+leave:
+    preempt_enable();
+    return retval;
+}
+
+static int sys_mq_release(mqd_t mqdes, void *msg_ptr)
+{
+    preempt_disable();
+
+    int retval;
+
+    /* Check if the message queue descriptor is invalid */
+    struct task_struct *task = current_task_info();
+    if (!bitmap_get_bit(bitmap_mqds, mqdes) ||
+        !bitmap_get_bit(task->bitmap_mqds, mqdes)) {
+        retval = -EBADF;
+        goto leave;
+    }
+
+    /* Return the borrowed message buffer */
+    retval = __mq_release(mqd_table[mqdes].mq, &mqd_table[mqdes].attr, mqdes,
+                          msg_ptr);
+
+leave:
+    preempt_enable();
+    return retval;
+}
+
 static int sys_pthread_create(pthread_t *pthread,
                               const pthread_attr_t *_attr,
                               void *(*start_routine)(void *),
@@ -2279,6 +3420,13 @@ static void handle_signal(struct thread_info *thread, int signum)
     }
 }
 
+void thread_signal(struct thread_info *thread, int signum)
+{
+    /* kthread does not receive signals */
+    if (thread->privilege != KERNEL_THREAD)
+        handle_signal(thread, signum);
+}
+
 static int sys_pthread_kill(pthread_t tid, int sig)
 {
     preempt_disable();
@@ -2885,6 +4033,13 @@ static void *sys_malloc(size_t size)
 
     ptr = __malloc(size);
 
+    /* Record the allocation with the call site of the malloc() */
+    if (ptr) {
+        alloc_trace_add(
+            ALLOC_HEAP, ptr, heap_get_block_size(ptr),
+            (void *) get_syscall_caller(running_thread->syscall_stack_top));
+    }
+
 leave:
     preempt_enable();
     return ptr;
@@ -2892,8 +4047,15 @@ leave:
 
 static void sys_free(void *ptr)
 {
+    /* Freeing a null pointer does nothing */
+    if (!ptr)
+        return;
+
     preempt_disable();
 
+    /* Remove the record of the allocation */
+    alloc_trace_del(ALLOC_HEAP, ptr, heap_get_block_size(ptr));
+
     /* Free the memory */
     __free(ptr);
 
@@ -3197,29 +4359,6 @@ static void slab_init(void)
     }
 }
 
-static void check_thread_stack(void)
-{
-    /* Calculate stack range of the thread */
-    uintptr_t lower_bound = (uintptr_t) running_thread->stack;
-    uintptr_t upper_bound =
-        (uintptr_t) running_thread->stack + running_thread->stack_size;
-
-    /* Check thread stack pointer is valid or not */
-    if ((uintptr_t) running_thread->stack_top < lower_bound ||
-        (uintptr_t) running_thread->stack_top > upper_bound) {
-        panic(
-            "\r=============== STACK OVERFLOW ===============\n\r"
-            "Current thread: %p (%s)\n\r"
-            "Stack range: [0x%08x-0x%08x]\n\r"
-            "Stack size: %d\n\r"
-            "Faulting stack pointer = %p\n\r"
-            "Halting system\n\r"
-            "==============================================",
-            running_thread, running_thread->name, lower_bound, upper_bound,
-            running_thread->stack_size, running_thread->stack_top);
-    }
-}
-
 static void *init(void *arg)
 {
     /* Bring up drivers */
@@ -3227,6 +4366,12 @@ static void *init(void *arg)
     __board_init();
     rom_dev_init();
     null_dev_init();
+#if (RAMDISK_BLK_CNT != 0)
+    ram_dev_init();
+#endif
+#if (MEMDISK_SIZE != 0)
+    mem_disk_init();
+#endif
     link_stdin_dev(STDIN_PATH);
     link_stdout_dev(STDOUT_PATH);
     link_stderr_dev(STDERR_PATH);
@@ -3235,6 +4380,12 @@ static void *init(void *arg)
     /* Mount rom file system */
     mount("/dev/rom", "/");
 
+#if (USE_LOGFS != 0)
+    /* Mount log-structured file system */
+    mknod(LOGFS_MOUNT_PATH, 0, S_IFDIR);
+    mount(LOGFS_DEV_PATH, LOGFS_MOUNT_PATH);
+#endif
+
     /* Wait until the boot message is printed */
     while (!printk_all_flushed())
         sched_yield();
@@ -3246,8 +4397,15 @@ static void *init(void *arg)
                       sizeof(struct task_hook);
 
     /* Launched all hooked user tasks */
-    for (size_t i = 0; i < task_cnt; i++)
-        task_create(tasks[i].task_func, tasks[i].priority, tasks[i].stacksize);
+    for (size_t i = 0; i < task_cnt; i++) {
+        if (tasks[i].stackaddr) {
+            task_create_static(tasks[i].task_func, tasks[i].priority,
+                               tasks[i].stackaddr, tasks[i].stacksize);
+        } else {
+            task_create(tasks[i].task_func, tasks[i].priority,
+                        tasks[i].stacksize);
+        }
+    }
 
     return 0;
 }
@@ -3285,12 +4443,40 @@ static void idle(void)
     }
 }
 
+#if (USE_MMAP_MPU != 0)
+#if (MMAP_MAX > MPU_USER_REGION_CNT)
+#error "MMAP_MAX exceeds the number of the MPU regions reserved for the user"
+#endif
+
+static void mmap_mpu_update(struct task_struct *task)
+{
+    for (int i = 0; i < MMAP_MAX; i++) {
+        struct vm_area *vma = &task->mmaps[i];
+
+        if (!vma->start) {
+            __mpu_user_region_disable(i);
+            continue;
+        }
+
+        /* sys_mmap() only accepts the mappings forming a valid region */
+        __mpu_user_region_enable(i, vma->start, vma->size,
+                                 vma->prot & PROT_READ, vma->prot & PROT_WRITE);
+    }
+}
+
+static void mmap_mpu_disable(void)
+{
+    for (int i = 0; i < MMAP_MAX; i++) {
+        __mpu_user_region_disable(i);
+    }
+}
+#endif
+
 void sched_start(void)
 {
     __platform_init();
     slab_init();
     heap_init();
-    printkd_init();
     rootfs_init();
 
     /* Initialize ready lists */
@@ -3301,8 +4487,9 @@ void sched_start(void)
     /* Create kernel threads for basic services */
     kthread_create(idle, 0, IDLE_STACK_SIZE);
     kthread_create(softirqd, KTHREAD_PRI_MAX, SOFTIRQD_STACK_SIZE);
-    kthread_create(filesysd, KTHREAD_PRI_MAX - 1, FILESYSD_STACK_SIZE);
     kthread_create(printkd, KTHREAD_PRI_MAX - 1, PRINTKD_STACK_SIZE);
+    for (int i = 0; i < AIOD_CNT; i++)
+        kthread_create(aiod, KTHREAD_PRI_MAX - 1, AIOD_STACK_SIZE);
 
     /* Dequeue and execute the init thread */
     running_thread = &threads[0];
@@ -3322,11 +4509,24 @@ void sched_start(void)
             __schedule();
         }
 
-        /* Check thread stack pointer to detect stack overflow */
-        check_thread_stack();
+#if (USE_MMAP_MPU != 0)
+        /* Apply the memory protection of the mappings with the MPU */
+        mmap_mpu_update(running_thread->task);
+#endif
+
+        /* Trap stack overflow of the thread with the MPU */
+        __stack_guard_enable(running_thread->stack);
 
         /* Jump to the selected thread */
         running_thread->stack_top = jump_to_thread(running_thread->stack_top,
                                                    running_thread->privilege);
+
+        /* Kernel is allowed to access the whole thread stack */
+        __stack_guard_disable();
+
+#if (USE_MMAP_MPU != 0)
+        /* The permissions also apply to the kernel, hence remove them */
+        mmap_mpu_disable();
+#endif
     }
 }
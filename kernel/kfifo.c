@@ -186,6 +186,40 @@ void kfifo_dma_out_finish(struct kfifo *fifo)
     fifo->count--;
 }
 
+size_t kfifo_in_linear(struct kfifo *fifo, char **data_ptr)
+{
+    *data_ptr = (char *) ((uintptr_t) fifo->data + fifo->end);
+
+    /* The free space ends at the start position or the end of the buffer */
+    size_t avail = fifo->size - fifo->count;
+    size_t linear = fifo->size - fifo->end;
+
+    return avail < linear ? avail : linear;
+}
+
+void kfifo_in_linear_finish(struct kfifo *fifo, size_t n)
+{
+    fifo->end = (fifo->end + n) % fifo->size;
+    fifo->count += n;
+}
+
+size_t kfifo_out_linear(struct kfifo *fifo, char **data_ptr)
+{
+    *data_ptr = (char *) ((uintptr_t) fifo->data + fifo->start);
+
+    /* The data ends at the end position or the end of the buffer */
+    size_t len = fifo->count;
+    size_t linear = fifo->size - fifo->start;
+
+    return len < linear ? len : linear;
+}
+
+void kfifo_out_linear_finish(struct kfifo *fifo, size_t n)
+{
+    fifo->start = (fifo->start + n) % fifo->size;
+    fifo->count -= n;
+}
+
 size_t kfifo_peek_len(struct kfifo *fifo)
 {
     /* kfifo_peek_len() is not supported under the
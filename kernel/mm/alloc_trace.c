@@ -0,0 +1,133 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <kernel/kernel.h>
+#include <kernel/preempt.h>
+#include <mm/alloc_trace.h>
+
+#include "kconfig.h"
+
+struct alloc_record {
+    void *ptr;
+    void *caller;
+    size_t size;
+    int16_t tid;
+    uint8_t type;
+    bool used;
+};
+
+static size_t alloc_used[ALLOC_TYPE_CNT];
+static size_t alloc_peak[ALLOC_TYPE_CNT];
+
+#if (USE_ALLOC_TRACE != 0)
+static struct alloc_record alloc_records[ALLOC_TRACE_MAX];
+static size_t alloc_records_dropped;
+#endif
+
+void alloc_trace_add(int type, void *ptr, size_t size, void *caller)
+{
+    preempt_disable();
+
+    /* Update the usage counters */
+    alloc_used[type] += size;
+    if (alloc_used[type] > alloc_peak[type])
+        alloc_peak[type] = alloc_used[type];
+
+#if (USE_ALLOC_TRACE != 0)
+    /* Find an empty slot to record the allocation */
+    int i;
+    for (i = 0; i < ALLOC_TRACE_MAX; i++) {
+        if (!alloc_records[i].used)
+            break;
+    }
+
+    /* The record table is full */
+    if (i == ALLOC_TRACE_MAX) {
+        alloc_records_dropped++;
+        goto leave;
+    }
+
+    /* Thread is not available during the early boot stage */
+    struct thread_info *thread = current_thread_info();
+
+    alloc_records[i].ptr = ptr;
+    alloc_records[i].caller = caller;
+    alloc_records[i].size = size;
+    alloc_records[i].tid = thread ? thread->tid : -1;
+    alloc_records[i].type = type;
+    alloc_records[i].used = true;
+
+leave:
+#endif
+    preempt_enable();
+}
+
+void alloc_trace_del(int type, void *ptr, size_t size)
+{
+    preempt_disable();
+
+    /* Update the usage counter */
+    alloc_used[type] -= size;
+
+#if (USE_ALLOC_TRACE != 0)
+    /* Remove the record of the allocation */
+    for (int i = 0; i < ALLOC_TRACE_MAX; i++) {
+        if (alloc_records[i].used && alloc_records[i].ptr == ptr &&
+            alloc_records[i].type == type) {
+            alloc_records[i].used = false;
+            break;
+        }
+    }
+#endif
+
+    preempt_enable();
+}
+
+size_t alloc_trace_used(int type)
+{
+    return alloc_used[type];
+}
+
+size_t alloc_trace_peak(int type)
+{
+    return alloc_peak[type];
+}
+
+size_t alloc_trace_dropped(void)
+{
+#if (USE_ALLOC_TRACE != 0)
+    return alloc_records_dropped;
+#else
+    return 0;
+#endif
+}
+
+void *alloc_trace_iterate(struct alloc_stat *info, void *next)
+{
+#if (USE_ALLOC_TRACE != 0)
+    /* Start from the first record or the given one */
+    int i = next ? (struct alloc_record *) next - alloc_records : 0;
+
+    /* Find the next live record */
+    for (; i < ALLOC_TRACE_MAX; i++) {
+        if (alloc_records[i].used)
+            break;
+    }
+
+    /* No more record */
+    if (i >= ALLOC_TRACE_MAX)
+        return NULL;
+
+    /* Return the allocation record */
+    info->type = alloc_records[i].type;
+    info->tid = alloc_records[i].tid;
+    info->caller = alloc_records[i].caller;
+    info->size = alloc_records[i].size;
+
+    /* Return the pointer of the next record to read */
+    return &alloc_records[i + 1];
+#else
+    return NULL;
+#endif
+}
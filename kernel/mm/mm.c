@@ -59,6 +59,12 @@ unsigned long heap_get_total_size(void)
                             (uintptr_t) &_user_stack_start);
 }
 
+size_t heap_get_block_size(void *ptr)
+{
+    struct malloc_info *blk = container_of(ptr, struct malloc_info, data);
+    return malloc_get_block_length(blk);
+}
+
 unsigned long heap_get_free_size(void)
 {
     unsigned long total_size = 0;
@@ -133,7 +139,7 @@ void *__malloc(size_t size)
     }
 
     /* Failed to allocate memory */
-    printk("malloc(): not enough heap space (name: %s, pid: %d)",
+    pr_err("malloc(): not enough heap space (name: %s, pid: %d)",
            curr_thread->name, curr_thread->task->pid);
 
     return NULL;
@@ -207,6 +213,11 @@ NACKED int minfo(int name)
     SYSCALL(MINFO);
 }
 
+NACKED void *alloc_trace_info(struct alloc_stat *info, void *next)
+{
+    SYSCALL(ALLOC_TRACE_INFO);
+}
+
 /* Not implemented. The function is defined only
  * to supress the newlib warning.
  */
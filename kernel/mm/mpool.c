@@ -2,9 +2,52 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <arch/port.h>
+
 void mpool_init(struct mpool *mpool, uint8_t *mem, size_t size)
 {
     mpool->offset = 0;
     mpool->size = size;
     mpool->mem = mem;
 }
+
+void mpool_fixed_init(struct mpool_fixed *mpool,
+                      void *mem,
+                      size_t blk_size,
+                      size_t blk_cnt)
+{
+    /* Blocks are carved lazily from the memory space on allocation, hence
+     * the initialization is O(1) and identical to MPOOL_FIXED_INIT() */
+    mpool->free_list = NULL;
+    mpool->unused = 0;
+    mpool->blk_size = MPOOL_FIXED_BLK_SIZE(blk_size);
+    mpool->blk_cnt = blk_cnt;
+    mpool->mem = mem;
+}
+
+void *mpool_fixed_alloc(struct mpool_fixed *mpool)
+{
+    /* Reuse the block returned to the pool first */
+    void *blk = atomic_list_pop((void **) &mpool->free_list);
+    if (blk)
+        return blk;
+
+    /* Carve a new block from the untouched part of the memory space */
+    uint32_t idx = __atomic_load_n(&mpool->unused, __ATOMIC_RELAXED);
+    while (idx < mpool->blk_cnt) {
+        if (__atomic_compare_exchange_n(&mpool->unused, &idx, idx + 1, true,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+            return (void *) ((uintptr_t) mpool->mem + idx * mpool->blk_size);
+    }
+
+    /* The memory pool is exhausted */
+    return NULL;
+}
+
+void mpool_fixed_free(struct mpool_fixed *mpool, void *ptr)
+{
+    if (!ptr)
+        return;
+
+    atomic_list_push((void **) &mpool->free_list, ptr);
+}
@@ -2,6 +2,7 @@
 
 #include <common/bitops.h>
 #include <common/log2.h>
+#include <mm/alloc_trace.h>
 #include <mm/page.h>
 
 #include "kconfig.h"
@@ -180,14 +181,22 @@ void *alloc_pages(unsigned long order)
     /* Clear the bit to indicate that the page is used */
     bitmap_clear_bit(page_bitmap[order], page_idx);
 
+    /* Record the allocation */
+    void *addr = page_idx_to_addr(page_idx, order);
+    alloc_trace_add(ALLOC_PAGE, addr, page_order_sz[order],
+                    __builtin_return_address(0));
+
     /* Return page address */
-    return page_idx_to_addr(page_idx, order);
+    return addr;
 }
 
 void free_pages(unsigned long addr, unsigned long order)
 {
     unsigned long page_idx, buddy_idx, mask;
 
+    /* Remove the record of the allocation */
+    alloc_trace_del(ALLOC_PAGE, (void *) addr, page_order_sz[order]);
+
     /* Attempt to coalesce pages from current order to the maximal order */
     for (; order < PAGE_ORDER_MAX; order++) {
         /* Get indices of current page and buddy page */
@@ -7,7 +7,9 @@
 #include <unistd.h>
 
 #include <arch/port.h>
+#include <common/bitops.h>
 #include <common/list.h>
+#include <common/util.h>
 #include <kernel/errno.h>
 #include <kernel/kernel.h>
 #include <kernel/mqueue.h>
@@ -16,50 +18,89 @@
 #include <kernel/wait.h>
 #include <mm/mm.h>
 
-struct mqueue *__mq_allocate(struct mq_attr *attr)
-{
-    /* allocate new message queue */
-    struct mqueue *new_mq = kmalloc(sizeof(struct mqueue));
-    memset(new_mq, 0, sizeof(*new_mq));
+#if (MQ_PRIO_MAX >= 32)
+#error "MQ_PRIO_MAX must be less than 32 to fit in the priority bitmap"
+#endif
 
-    /* allocate message buffers */
-    size_t element_size =
-        ALIGN(sizeof(struct mqueue_data) + attr->mq_msgsize, sizeof(long));
-    size_t buf_size = element_size * attr->mq_maxmsg;
-    char *buf = kmalloc(buf_size);
+/* MQ_STATIC_SIZE() reserves the memory with the sizes in <mqueue.h> */
+_Static_assert(sizeof(struct mqueue) <= __SIZEOF_MQUEUE,
+               "__SIZEOF_MQUEUE is smaller than struct mqueue");
+_Static_assert(sizeof(struct mqueue_data) <= __SIZEOF_MQUEUE_DATA,
+               "__SIZEOF_MQUEUE_DATA is smaller than struct mqueue_data");
 
-    /* Failed to allocate message queue */
-    if (!new_mq) {
-        return NULL;
-    } else if (!buf) {
-        kfree(new_mq);
-        return NULL;
-    }
+static size_t __mq_element_size(size_t msgsize)
+{
+    /* Round up the message buffer to keep the elements aligned */
+    return CEILING(sizeof(struct mqueue_data) + msgsize, sizeof(long)) *
+           sizeof(long);
+}
+
+static void __mq_init(struct mqueue *mq, struct mq_attr *attr, char *buf)
+{
+    memset(mq, 0, sizeof(*mq));
 
     /* Initialize message queue size and buffer */
-    new_mq->size = attr->mq_maxmsg;
-    new_mq->buf = buf;
+    mq->size = attr->mq_maxmsg;
+    mq->buf = buf;
 
     /* Initialize message queue list heads */
-    INIT_LIST_HEAD(&new_mq->free_list);
-    INIT_LIST_HEAD(&new_mq->r_wait_list);
-    INIT_LIST_HEAD(&new_mq->w_wait_list);
+    INIT_LIST_HEAD(&mq->free_list);
+    INIT_LIST_HEAD(&mq->r_wait_list);
+    INIT_LIST_HEAD(&mq->w_wait_list);
     for (int i = 0; i <= MQ_PRIO_MAX; i++)
-        INIT_LIST_HEAD(&new_mq->used_list[i]);
+        INIT_LIST_HEAD(&mq->used_list[i]);
 
     /* Link all message buffers to the free list */
-    for (int i = 0; i < new_mq->size; i++) {
+    size_t element_size = __mq_element_size(attr->mq_msgsize);
+    for (int i = 0; i < mq->size; i++) {
         struct mqueue_data *entry =
             (struct mqueue_data *) ((uintptr_t) buf + (i * element_size));
-        list_add(&entry->list, &new_mq->free_list);
+        list_add(&entry->list, &mq->free_list);
+    }
+}
+
+struct mqueue *__mq_allocate(struct mq_attr *attr)
+{
+    /* allocate new message queue */
+    struct mqueue *new_mq = kmalloc(sizeof(struct mqueue));
+    if (!new_mq)
+        return NULL;
+
+    /* allocate message buffers */
+    size_t buf_size = __mq_element_size(attr->mq_msgsize) * attr->mq_maxmsg;
+    char *buf = kmalloc(buf_size);
+    if (!buf) {
+        kfree(new_mq);
+        return NULL;
     }
 
+    /* Initialize the message queue */
+    __mq_init(new_mq, attr, buf);
+
     /* Return the allocated message queue */
     return new_mq;
 }
 
+struct mqueue *__mq_init_static(struct mq_attr *attr, void *mem)
+{
+    /* The memory is laid out as the message queue followed by the message
+     * buffers, see MQ_STATIC_SIZE() */
+    struct mqueue *new_mq = (struct mqueue *) mem;
+    char *buf = (char *) ((uintptr_t) mem + sizeof(struct mqueue));
+
+    /* Initialize the message queue */
+    __mq_init(new_mq, attr, buf);
+    new_mq->static_alloc = true;
+
+    return new_mq;
+}
+
 void __mq_free(struct mqueue *mq)
 {
+    /* Statically allocated message queue is owned by the user */
+    if (mq->static_alloc)
+        return;
+
     kfree(mq->buf);
     kfree(mq);
 }
@@ -73,28 +114,48 @@ size_t __mq_len(struct mqueue *mq)
 static size_t __mq_avail(struct mqueue *mq)
 {
     /* Return the free space number of the queue */
-    return mq->size - mq->cnt;
+    return mq->size - mq->cnt - mq->loaned;
 }
 
-static size_t __mq_out(struct mqueue *mq, char *msg_ptr, unsigned int *msg_prio)
+static struct mqueue_data *__mq_pop(struct mqueue *mq, unsigned int *msg_prio)
 {
     /* Find the message list with highest prioity that contains message */
-    int prio = MQ_PRIO_MAX;
-    for (; prio >= 0; prio--) {
-        if (!list_empty(&mq->used_list[prio]))
-            break;
-    }
+    unsigned int prio = _flsl(mq->prio_bitmap) - 1;
 
-    /* Read message from the selected list */
+    /* Remove the oldest message from the selected list */
     struct mqueue_data *element =
         list_first_entry(&mq->used_list[prio], struct mqueue_data, list);
-    memcpy(msg_ptr, element->data, element->size);
+    list_del_init(&element->list);
     mq->cnt--;
+
+    /* Clear the priority bit if the list becomes empty */
+    if (list_empty(&mq->used_list[prio]))
+        clear_bit(prio, &mq->prio_bitmap);
+
     if (msg_prio)
         *msg_prio = prio;
 
-    /* Move the message from used list to the free list */
-    list_move(&element->list, &mq->free_list);
+    return element;
+}
+
+static void __mq_push(struct mqueue *mq,
+                      struct mqueue_data *element,
+                      unsigned int msg_prio)
+{
+    /* Append the message to the used list of its priority */
+    list_add(&element->list, &mq->used_list[msg_prio]);
+    set_bit(msg_prio, &mq->prio_bitmap);
+    mq->cnt++;
+}
+
+static size_t __mq_out(struct mqueue *mq, char *msg_ptr, unsigned int *msg_prio)
+{
+    /* Read message from the list with highest priority */
+    struct mqueue_data *element = __mq_pop(mq, msg_prio);
+    memcpy(msg_ptr, element->data, element->size);
+
+    /* Return the message buffer to the free list */
+    list_add(&element->list, &mq->free_list);
 
     /* Return the read size */
     return element->size;
@@ -110,10 +171,34 @@ static void __mq_in(struct mqueue *mq,
         list_first_entry(&mq->free_list, struct mqueue_data, list);
     memcpy(element->data, msg_ptr, msg_len);
     element->size = msg_len;
-    mq->cnt++;
 
     /* Move the message from free list to the used list */
-    list_move(&element->list, &mq->used_list[msg_prio]);
+    list_del(&element->list);
+    __mq_push(mq, element, msg_prio);
+}
+
+static struct mqueue_data *__mq_loaned_element(struct mqueue *mq,
+                                               const struct mq_attr *attr,
+                                               mqd_t mqdes,
+                                               void *msg_ptr)
+{
+    size_t element_size = __mq_element_size(attr->mq_msgsize);
+    uintptr_t offset = (uintptr_t) msg_ptr - (uintptr_t) mq->buf -
+                       offsetof(struct mqueue_data, data);
+
+    /* The address must point to the data of one of the message buffers */
+    if ((uintptr_t) msg_ptr < (uintptr_t) mq->buf ||
+        offset >= element_size * mq->size || offset % element_size)
+        return NULL;
+
+    /* Message buffer on loan is detached from all lists, and must be lent
+     * through the same descriptor */
+    struct mqueue_data *element =
+        (struct mqueue_data *) ((uintptr_t) mq->buf + offset);
+    if (!list_empty(&element->list) || element->owner != mqdes)
+        return NULL;
+
+    return element;
 }
 
 ssize_t __mq_receive(struct mqueue *mq,
@@ -190,6 +275,147 @@ ssize_t __mq_send(struct mqueue *mq,
     return 0;
 }
 
+int __mq_reserve(struct mqueue *mq,
+                 const struct mq_attr *attr,
+                 mqd_t mqdes,
+                 void **msg_ptr)
+{
+    /* The message queue descriptor is not open with writing flag */
+    if ((attr->mq_flags & (0x1)) != O_WRONLY && !(attr->mq_flags & O_RDWR))
+        return -EBADF;
+
+    /* Check if the queue has space to write */
+    if (__mq_avail(mq) <= 0) {
+        if (attr->mq_flags & O_NONBLOCK) { /* Non-block mode */
+            /* Return immediately */
+            return -EAGAIN;
+        } else { /* Block mode */
+            /* Enqueue the thread into the waiting list */
+            prepare_to_wait(&mq->w_wait_list, current_thread_info(),
+                            THREAD_WAIT);
+            return -ERESTARTSYS;
+        }
+    }
+
+    /* Detach a message buffer from the free list and lend it to the caller */
+    struct mqueue_data *element =
+        list_first_entry(&mq->free_list, struct mqueue_data, list);
+    list_del_init(&element->list);
+    element->owner = mqdes;
+    mq->loaned++;
+
+    *msg_ptr = element->data;
+
+    /* Return success */
+    return 0;
+}
+
+int __mq_commit(struct mqueue *mq,
+                const struct mq_attr *attr,
+                mqd_t mqdes,
+                void *msg_ptr,
+                size_t msg_len,
+                unsigned int msg_prio)
+{
+    /* The write size must be smaller or equal to the max message size */
+    if (msg_len > attr->mq_msgsize)
+        return -EMSGSIZE;
+
+    /* Check if the message buffer is reserved from the queue */
+    struct mqueue_data *element =
+        __mq_loaned_element(mq, attr, mqdes, msg_ptr);
+    if (!element)
+        return -EINVAL;
+
+    /* Put the message into the queue */
+    element->size = msg_len;
+    mq->loaned--;
+    __mq_push(mq, element, msg_prio);
+
+    /* Wake up the highest-priority thread from the waiting list */
+    wake_up(&mq->r_wait_list);
+
+    /* Return success */
+    return 0;
+}
+
+ssize_t __mq_borrow(struct mqueue *mq,
+                    const struct mq_attr *attr,
+                    mqd_t mqdes,
+                    void **msg_ptr,
+                    unsigned int *msg_prio)
+{
+    /* The message queue descriptor is not open with reading flag */
+    if ((attr->mq_flags & (0x1)) != O_RDONLY && !(attr->mq_flags & O_RDWR))
+        return -EBADF;
+
+    /* Check if the queue has message to read */
+    if (__mq_len(mq) <= 0) {
+        if (attr->mq_flags & O_NONBLOCK) { /* Non-block mode */
+            /* Return immediately */
+            return -EAGAIN;
+        } else { /* Block mode */
+            /* Enqueue the thread into the waiting list */
+            prepare_to_wait(&mq->r_wait_list, current_thread_info(),
+                            THREAD_WAIT);
+            return -ERESTARTSYS;
+        }
+    }
+
+    /* Detach the message from the queue and lend it to the caller. The
+     * writers are woken up only after the message buffer is released */
+    struct mqueue_data *element = __mq_pop(mq, msg_prio);
+    element->owner = mqdes;
+    mq->loaned++;
+
+    *msg_ptr = element->data;
+
+    /* Return read size */
+    return element->size;
+}
+
+int __mq_release(struct mqueue *mq,
+                 const struct mq_attr *attr,
+                 mqd_t mqdes,
+                 void *msg_ptr)
+{
+    /* Check if the message buffer is borrowed from the queue */
+    struct mqueue_data *element =
+        __mq_loaned_element(mq, attr, mqdes, msg_ptr);
+    if (!element)
+        return -EINVAL;
+
+    /* Return the message buffer to the free list */
+    list_add(&element->list, &mq->free_list);
+    mq->loaned--;
+
+    /* Wake up the highest-priority thread from the waiting list */
+    wake_up(&mq->w_wait_list);
+
+    /* Return success */
+    return 0;
+}
+
+void __mq_reclaim(struct mqueue *mq, const struct mq_attr *attr, mqd_t mqdes)
+{
+    size_t element_size = __mq_element_size(attr->mq_msgsize);
+
+    /* Return the message buffers still lent through the descriptor to the
+     * free list, their content is dropped */
+    for (int i = 0; i < mq->size; i++) {
+        struct mqueue_data *element =
+            (struct mqueue_data *) ((uintptr_t) mq->buf + (i * element_size));
+        if (!list_empty(&element->list) || element->owner != mqdes)
+            continue;
+
+        list_add(&element->list, &mq->free_list);
+        mq->loaned--;
+
+        /* Wake up the highest-priority thread from the waiting list */
+        wake_up(&mq->w_wait_list);
+    }
+}
+
 NACKED int mq_getattr(mqd_t mqdes, struct mq_attr *attr)
 {
     SYSCALL(MQ_GETATTR);
@@ -207,6 +433,14 @@ NACKED mqd_t mq_open(const char *name, int oflag, struct mq_attr *attr)
     SYSCALL(MQ_OPEN);
 }
 
+NACKED mqd_t mq_open_static(const char *name,
+                            int oflag,
+                            struct mq_attr *attr,
+                            void *mem)
+{
+    SYSCALL(MQ_OPEN_STATIC);
+}
+
 NACKED int mq_close(mqd_t mqdes)
 {
     SYSCALL(MQ_CLOSE);
@@ -232,3 +466,26 @@ NACKED int mq_send(mqd_t mqdes,
 {
     SYSCALL(MQ_SEND);
 }
+
+NACKED int mq_reserve(mqd_t mqdes, void **msg_ptr)
+{
+    SYSCALL(MQ_RESERVE);
+}
+
+NACKED int mq_commit(mqd_t mqdes,
+                     void *msg_ptr,
+                     size_t msg_len,
+                     unsigned int msg_prio)
+{
+    SYSCALL(MQ_COMMIT);
+}
+
+NACKED ssize_t mq_borrow(mqd_t mqdes, void **msg_ptr, unsigned int *msg_prio)
+{
+    SYSCALL(MQ_BORROW);
+}
+
+NACKED int mq_release(mqd_t mqdes, void *msg_ptr)
+{
+    SYSCALL(MQ_RELEASE);
+}
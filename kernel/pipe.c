@@ -1,10 +1,12 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <poll.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <string.h>
 #include <sys/types.h>
 
+#include <arch/port.h>
 #include <common/list.h>
 #include <fs/fs.h>
 #include <kernel/errno.h>
@@ -13,8 +15,10 @@
 #include <kernel/pipe.h>
 #include <kernel/poll.h>
 #include <kernel/preempt.h>
+#include <kernel/syscall.h>
 #include <kernel/thread.h>
 #include <kernel/wait.h>
+#include <mm/page.h>
 
 int fifo_open(struct inode *inode, struct file *file)
 {
@@ -40,7 +44,44 @@ static void fifo_wake_up(struct list_head *wait_list, size_t avail_size)
         finish_wait(highest_pri_thread);
 }
 
-static ssize_t __fifo_read(struct file *filp, char *buf, size_t size)
+static void fifo_copy_out(struct kfifo *fifo, char *buf, size_t size)
+{
+    /* Copy the data with at most two pieces as it may wrap around */
+    while (size) {
+        char *data;
+        size_t n = kfifo_out_linear(fifo, &data);
+        if (n > size)
+            n = size;
+
+        memcpy(buf, data, n);
+        kfifo_out_linear_finish(fifo, n);
+
+        buf += n;
+        size -= n;
+    }
+}
+
+static void fifo_copy_in(struct kfifo *fifo, const char *buf, size_t size)
+{
+    /* Copy the data with at most two pieces as it may wrap around */
+    while (size) {
+        char *space;
+        size_t n = kfifo_in_linear(fifo, &space);
+        if (n > size)
+            n = size;
+
+        memcpy(space, buf, n);
+        kfifo_in_linear_finish(fifo, n);
+
+        buf += n;
+        size -= n;
+    }
+}
+
+static ssize_t __fifo_read(struct file *filp,
+                           char *buf,
+                           size_t size,
+                           bool partial)
 {
     CURRENT_THREAD_INFO(curr_thread);
 
@@ -50,16 +91,19 @@ static ssize_t __fifo_read(struct file *filp, char *buf, size_t size)
 
     /* Check if the request size is larger than the FIFO can serve */
     if (size > fifo_len) {
-        if (filp->f_flags & O_NONBLOCK) { /* Non-block mode */
+        if (curr_thread->file_flags & O_NONBLOCK) { /* Non-block mode */
             if (fifo_len > 0) {
                 /* Set the read size to the largest amount of available size */
                 size = fifo_len;
             } else {
                 return -EAGAIN;
             }
+        } else if (partial && fifo_len > 0) {
+            /* Splice takes whatever is in the pipe */
+            size = fifo_len;
         } else { /* Block mode */
-            /* Save the read request size */
-            curr_thread->file_request_size = size;
+            /* Save the read request size. Splice only waits for any data */
+            curr_thread->file_request_size = partial ? 1 : size;
 
             /* Enqueue the thread into the waiting list */
             prepare_to_wait(&pipe->r_wait_list, curr_thread, THREAD_WAIT);
@@ -68,8 +112,7 @@ static ssize_t __fifo_read(struct file *filp, char *buf, size_t size)
     }
 
     /* Pop data from the pipe */
-    for (int i = 0; i < size; i++)
-        kfifo_out(fifo, &buf[i], sizeof(char));
+    fifo_copy_out(fifo, buf, size);
 
     /* Wake up the highest-priority thread */
     fifo_wake_up(&pipe->w_wait_list, kfifo_avail(fifo));
@@ -77,7 +120,10 @@ static ssize_t __fifo_read(struct file *filp, char *buf, size_t size)
     return size;
 }
 
-static ssize_t __fifo_write(struct file *filp, const char *buf, size_t size)
+static ssize_t __fifo_write(struct file *filp,
+                            const char *buf,
+                            size_t size,
+                            bool partial)
 {
     CURRENT_THREAD_INFO(curr_thread);
 
@@ -87,16 +133,19 @@ static ssize_t __fifo_write(struct file *filp, const char *buf, size_t size)
 
     /* Check if the FIFO has enough space to write or not */
     if (size > fifo_avail) {
-        if (filp->f_flags & O_NONBLOCK) { /* Non-block mode */
+        if (curr_thread->file_flags & O_NONBLOCK) { /* Non-block mode */
             if (fifo_avail > 0) {
                 /* Set the write size to the largest amount of available size */
                 size = fifo_avail;
             } else {
                 return -EAGAIN;
             }
+        } else if (partial && fifo_avail > 0) {
+            /* Splice fills whatever space is in the pipe */
+            size = fifo_avail;
         } else { /* Block mode */
-            /* Save the write request size */
-            curr_thread->file_request_size = size;
+            /* Save the write request size. Splice only waits for any space */
+            curr_thread->file_request_size = partial ? 1 : size;
 
             /* Enqueue the thread into the waiting list */
             prepare_to_wait(&pipe->w_wait_list, curr_thread, THREAD_WAIT);
@@ -105,8 +154,7 @@ static ssize_t __fifo_write(struct file *filp, const char *buf, size_t size)
     }
 
     /* Push data into the pipe */
-    for (int i = 0; i < size; i++)
-        kfifo_in(fifo, &buf[i], sizeof(char));
+    fifo_copy_in(fifo, buf, size);
 
     /* Wake up the highest-priority thread */
     fifo_wake_up(&pipe->r_wait_list, kfifo_len(fifo));
@@ -114,19 +162,22 @@ static ssize_t __fifo_write(struct file *filp, const char *buf, size_t size)
     return size;
 }
 
-ssize_t fifo_read(struct file *filp, char *buf, size_t size, off_t offset)
+static ssize_t fifo_do_read(struct file *filp,
+                            char *buf,
+                            size_t size,
+                            bool partial)
 {
     preempt_disable();
 
-    ssize_t retval = __fifo_read(filp, buf, size);
+    ssize_t retval = __fifo_read(filp, buf, size, partial);
 
     /* Update file events */
     struct pipe *pipe = container_of(filp, struct pipe, file);
-    if (kfifo_len(pipe->fifo) > 0) {
+    if (kfifo_len(pipe->fifo) == 0)
+        filp->f_events &= ~POLLIN;
+    if (kfifo_avail(pipe->fifo) > 0) {
         filp->f_events |= POLLOUT;
         poll_notify(filp);
-    } else {
-        filp->f_events &= ~POLLOUT;
     }
 
     preempt_enable();
@@ -134,22 +185,22 @@ ssize_t fifo_read(struct file *filp, char *buf, size_t size, off_t offset)
     return retval;
 }
 
-ssize_t fifo_write(struct file *filp,
-                   const char *buf,
-                   size_t size,
-                   off_t offset)
+static ssize_t fifo_do_write(struct file *filp,
+                             const char *buf,
+                             size_t size,
+                             bool partial)
 {
     preempt_disable();
 
-    ssize_t retval = __fifo_write(filp, buf, size);
+    ssize_t retval = __fifo_write(filp, buf, size, partial);
 
     /* Update file events */
     struct pipe *pipe = container_of(filp, struct pipe, file);
-    if (kfifo_avail(pipe->fifo) > 0) {
+    if (kfifo_avail(pipe->fifo) == 0)
+        filp->f_events &= ~POLLOUT;
+    if (kfifo_len(pipe->fifo) > 0) {
         filp->f_events |= POLLIN;
         poll_notify(filp);
-    } else {
-        filp->f_events &= ~POLLIN;
     }
 
     preempt_enable();
@@ -157,12 +208,113 @@ ssize_t fifo_write(struct file *filp,
     return retval;
 }
 
+ssize_t fifo_read(struct file *filp, char *buf, size_t size, off_t offset)
+{
+    return fifo_do_read(filp, buf, size, false);
+}
+
+ssize_t fifo_write(struct file *filp,
+                   const char *buf,
+                   size_t size,
+                   off_t offset)
+{
+    return fifo_do_write(filp, buf, size, false);
+}
+
+ssize_t fifo_splice_read(struct file *filp, char *buf, size_t size)
+{
+    return fifo_do_read(filp, buf, size, true);
+}
+
+ssize_t fifo_splice_write(struct file *filp, const char *buf, size_t size)
+{
+    return fifo_do_write(filp, buf, size, true);
+}
+
 static struct file_operations fifo_ops = {
     .read = fifo_read,
     .write = fifo_write,
     .open = fifo_open,
 };
 
+int fifo_resize(struct pipe *pipe, size_t size)
+{
+    struct kfifo *fifo = pipe->fifo;
+    size_t len = kfifo_len(fifo);
+
+    /* Round up the size to the page size */
+    long order = size_to_page_order(size);
+    if (size == 0 || order < 0)
+        return -EINVAL;
+    size = page_order_to_size(order);
+
+    /* The new buffer must be able to hold the unread data */
+    if (size < len)
+        return -EBUSY;
+
+    /* Allocate new buffer from the page allocator */
+    char *buf = alloc_pages(order);
+    if (!buf)
+        return -ENOMEM;
+
+    /* Move the unread data to the front of the new buffer */
+    fifo_copy_out(fifo, buf, len);
+
+    /* Free the old buffer if it is allocated from the page allocator */
+    if (pipe->buf_order >= 0)
+        free_pages((unsigned long) fifo->data, pipe->buf_order);
+
+    /* Switch to the new buffer */
+    kfifo_init(fifo, buf, sizeof(char), size);
+    fifo->count = len;
+    fifo->end = (len < size) ? len : 0;
+    pipe->buf_order = order;
+
+    /* Wake up the highest-priority writer as the free space is changed */
+    fifo_wake_up(&pipe->w_wait_list, kfifo_avail(fifo));
+
+    /* Update file events */
+    if (kfifo_avail(fifo) > 0) {
+        pipe->file.f_events |= POLLOUT;
+        poll_notify(&pipe->file);
+    }
+
+    /* Return the new size */
+    return size;
+}
+
+void fifo_release(struct pipe *pipe)
+{
+    /* Free the buffer allocated by fifo_resize() */
+    if (pipe->buf_order >= 0) {
+        free_pages((unsigned long) pipe->fifo->data, pipe->buf_order);
+        pipe->buf_order = -1;
+    }
+}
+
+bool file_is_fifo(struct file *filp)
+{
+    return filp->f_op == &fifo_ops;
+}
+
+int fifo_fcntl(struct file *filp, int cmd, unsigned long arg)
+{
+    /* The file is not a pipe */
+    if (!file_is_fifo(filp))
+        return -EBADF;
+
+    struct pipe *pipe = container_of(filp, struct pipe, file);
+
+    switch (cmd) {
+    case F_GETPIPE_SZ:
+        return kfifo_size(pipe->fifo);
+    case F_SETPIPE_SZ:
+        return fifo_resize(pipe, arg);
+    default:
+        return -EINVAL;
+    }
+}
+
 int fifo_init(int fd,
               struct file **files,
               struct inode *file_inode,
@@ -171,6 +323,7 @@ int fifo_init(int fd,
     /* Initialize the pipe */
     INIT_LIST_HEAD(&pipe->r_wait_list);
     INIT_LIST_HEAD(&pipe->w_wait_list);
+    pipe->buf_order = -1;
 
     /* Register the pipe on the file table */
     memset(&pipe->file, 0, sizeof(pipe->file));
@@ -180,3 +333,27 @@ int fifo_init(int fd,
 
     return 0;
 }
+
+NACKED ssize_t _splice(const struct splice_args *args)
+{
+    SYSCALL(SPLICE);
+}
+
+ssize_t splice(int fd_in,
+               off_t *off_in,
+               int fd_out,
+               off_t *off_out,
+               size_t len,
+               unsigned int flags)
+{
+    struct splice_args args = {
+        .fd_in = fd_in,
+        .off_in = off_in,
+        .fd_out = fd_out,
+        .off_out = off_out,
+        .len = len,
+        .flags = flags,
+    };
+
+    return _splice(&args);
+}
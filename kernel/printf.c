@@ -1,8 +1,12 @@
 #include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/reent.h>
+#include <sys/types.h>
 #include <unistd.h>
 
 #include "kconfig.h"
@@ -68,179 +72,727 @@ char *ultoa(unsigned long value, char *buffer, int radix)
 
 #if (USE_TENOK_PRINTF != 0)
 
-static void format_write(char *str,
-                         char *format_str,
-                         char *padding_str,
-                         int *padding_end,
-                         bool *pad_with_zeros)
+/* Flags of the conversion specification */
+#define FMT_LEFT 0x01  /* '-': Left-justify within the field */
+#define FMT_PLUS 0x02  /* '+': Always write the sign */
+#define FMT_SPACE 0x04 /* ' ': Write a space in place of the plus sign */
+#define FMT_ALT 0x08   /* '#': Alternative form */
+#define FMT_ZERO 0x10  /* '0': Pad the field with zeros */
+
+/* Length modifiers */
+#define FMT_LEN_NONE 0
+#define FMT_LEN_HH 1
+#define FMT_LEN_H 2
+#define FMT_LEN_L 3
+#define FMT_LEN_LL 4
+#define FMT_LEN_J 5
+#define FMT_LEN_Z 6
+#define FMT_LEN_T 7
+#define FMT_LEN_LD 8
+
+/* Digits of the integer, or the digits of the floating-point number without
+ * the sign and the exponent */
+#define FMT_BUF_SIZE 40
+
+/* Max digits generated after the decimal point, more are written as zeros */
+#define FMT_FLOAT_PREC_MAX 17
+
+/* Values at or above this are written by %f in the exponent form */
+#define FMT_FIXED_MAX 1e19
+
+struct fmt_spec {
+    int flags;
+    int width;
+    int prec; /* -1 if not given */
+    int length;
+    char conv;
+};
+
+struct fmt_out {
+    char *str;
+    size_t size;
+    size_t len; /* Length of the whole output, including the truncated part */
+};
+
+/* Up to 10^18 for the integer part of %e below FMT_FIXED_MAX */
+static const uint64_t fmt_pow10[FMT_FLOAT_PREC_MAX + 2] = {
+    1ULL,
+    10ULL,
+    100ULL,
+    1000ULL,
+    10000ULL,
+    100000ULL,
+    1000000ULL,
+    10000000ULL,
+    100000000ULL,
+    1000000000ULL,
+    10000000000ULL,
+    100000000000ULL,
+    1000000000000ULL,
+    10000000000000ULL,
+    100000000000000ULL,
+    1000000000000000ULL,
+    10000000000000000ULL,
+    100000000000000000ULL,
+    1000000000000000000ULL,
+};
+
+static inline void fmt_putc(struct fmt_out *out, char c)
 {
-    /* Read length setting */
-    padding_str[*padding_end] = '\0';
-    *padding_end = 0;
-    int desired_len = atoi(padding_str);
-
-    /* Deterimine the padding symbol */
-    char symbol = *pad_with_zeros ? '0' : ' ';
-    *pad_with_zeros = false;
-
-    /* Check if the format string requires paddings */
-    size_t format_str_len = strlen(format_str);
-    if (format_str_len >= desired_len) {
-        /* no, output without padding */
-        strcat(str, format_str);
-        return;
+    /* Keep counting after the buffer is full for the return value */
+    if (out->len + 1 < out->size)
+        out->str[out->len] = c;
+    out->len++;
+}
+
+static void fmt_write(struct fmt_out *out, const char *s, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+        fmt_putc(out, s[i]);
+}
+
+static void fmt_fill(struct fmt_out *out, char c, int cnt)
+{
+    for (int i = 0; i < cnt; i++)
+        fmt_putc(out, c);
+}
+
+static void fmt_field(struct fmt_out *out,
+                      const struct fmt_spec *spec,
+                      const char *prefix,
+                      int zeros,
+                      const char *body,
+                      int len,
+                      int trail,
+                      const char *suffix)
+{
+    /* The field is laid out as: prefix (sign or radix), leading zeros,
+     * body, trailing zeros and suffix (exponent), padded to the width */
+    int prefix_len = strlen(prefix);
+    int suffix_len = strlen(suffix);
+    int total = prefix_len + zeros + len + trail + suffix_len;
+    int pad = spec->width > total ? spec->width - total : 0;
+
+    if (!(spec->flags & (FMT_LEFT | FMT_ZERO)))
+        fmt_fill(out, ' ', pad);
+
+    fmt_write(out, prefix, prefix_len);
+
+    if ((spec->flags & (FMT_LEFT | FMT_ZERO)) == FMT_ZERO)
+        fmt_fill(out, '0', pad);
+
+    fmt_fill(out, '0', zeros);
+    fmt_write(out, body, len);
+    fmt_fill(out, '0', trail);
+    fmt_write(out, suffix, suffix_len);
+
+    if (spec->flags & FMT_LEFT)
+        fmt_fill(out, ' ', pad);
+}
+
+static char *fmt_utoa(char *end, uint64_t value, int base, bool upper)
+{
+    const char *digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    char *p = end;
+
+    /* Avoid the 64-bit division if possible, which is done by software on
+     * 32-bit processors */
+    uint32_t value32;
+    while (value > UINT32_MAX) {
+        *--p = digits[value % base];
+        value /= base;
     }
 
-    /* Generate paddings */
-    size_t padding_size = desired_len - format_str_len;
-    for (int i = 0; i < padding_size; i++) {
-        padding_str[i] = symbol;
+    value32 = value;
+    do {
+        *--p = digits[value32 % base];
+        value32 /= base;
+    } while (value32);
+
+    return p;
+}
+
+static int64_t fmt_arg_signed(va_list *ap, int length)
+{
+    switch (length) {
+    case FMT_LEN_HH:
+        return (signed char) va_arg(*ap, int);
+    case FMT_LEN_H:
+        return (short) va_arg(*ap, int);
+    case FMT_LEN_L:
+        return va_arg(*ap, long);
+    case FMT_LEN_LL:
+        return va_arg(*ap, long long);
+    case FMT_LEN_J:
+        return va_arg(*ap, intmax_t);
+    case FMT_LEN_Z:
+        return va_arg(*ap, ssize_t);
+    case FMT_LEN_T:
+        return va_arg(*ap, ptrdiff_t);
+    default:
+        return va_arg(*ap, int);
     }
-    padding_str[padding_size] = '\0';
+}
 
-    /* Write output */
-    strcat(str, padding_str);
-    strcat(str, format_str);
+static uint64_t fmt_arg_unsigned(va_list *ap, int length)
+{
+    switch (length) {
+    case FMT_LEN_HH:
+        return (unsigned char) va_arg(*ap, unsigned int);
+    case FMT_LEN_H:
+        return (unsigned short) va_arg(*ap, unsigned int);
+    case FMT_LEN_L:
+        return va_arg(*ap, unsigned long);
+    case FMT_LEN_LL:
+        return va_arg(*ap, unsigned long long);
+    case FMT_LEN_J:
+        return va_arg(*ap, uintmax_t);
+    case FMT_LEN_Z:
+        return va_arg(*ap, size_t);
+    case FMT_LEN_T:
+        return (uintptr_t) va_arg(*ap, ptrdiff_t);
+    default:
+        return va_arg(*ap, unsigned int);
+    }
 }
 
-static int __vsnprintf(char *str,
-                       size_t size,
-                       bool check_size,
-                       const char *format,
-                       va_list ap)
+static void fmt_int(struct fmt_out *out,
+                    struct fmt_spec *spec,
+                    uint64_t value,
+                    bool negative)
 {
-    str[0] = 0;
-    char c_str[2] = {0};
+    char buf[FMT_BUF_SIZE];
+    char prefix[3] = {0};
+    char conv = spec->conv;
+    bool is_signed = conv == 'd' || conv == 'i';
+    int base = 10;
+
+    if (conv == 'o')
+        base = 8;
+    else if (conv == 'x' || conv == 'X' || conv == 'p')
+        base = 16;
+
+    /* Sign */
+    if (negative)
+        prefix[0] = '-';
+    else if (is_signed && (spec->flags & FMT_PLUS))
+        prefix[0] = '+';
+    else if (is_signed && (spec->flags & FMT_SPACE))
+        prefix[0] = ' ';
+
+    /* Zero with zero precision has no digit */
+    char *end = &buf[FMT_BUF_SIZE];
+    char *start = end;
+    if (value || spec->prec != 0)
+        start = fmt_utoa(end, value, base, conv == 'X');
+
+    int len = end - start;
+    int zeros = spec->prec > len ? spec->prec - len : 0;
+
+    /* Alternative forms: 0 for octal and 0x for hexadecimal */
+    if ((spec->flags & FMT_ALT) && base == 8 && !zeros &&
+        (len == 0 || *start != '0'))
+        zeros = 1;
+
+    if (((spec->flags & FMT_ALT) && base == 16 && value) || conv == 'p') {
+        prefix[0] = '0';
+        prefix[1] = conv == 'X' ? 'X' : 'x';
+    }
 
-    bool pad_with_zeros = false;
+    /* The zero flag is ignored if the precision is given */
+    if (spec->prec >= 0)
+        spec->flags &= ~FMT_ZERO;
 
-    char buf[100];  // XXX
-    int buf_pos = 0;
+    fmt_field(out, spec, prefix, zeros, start, len, 0, "");
+}
 
-    int pos = 0;
-    while (format[pos]) {
-        /* Boundary check */
-        if (check_size && pos >= size)
-            return strlen(str);
+/* The exact error terms below break if the compiler fuses a multiply with
+ * the following add, which may happen on targets with double precision FMA */
+#define FMT_NO_FP_CONTRACT __attribute__((optimize("fp-contract=off")))
 
-        if (format[pos] != '%') {
-            /* Copy */
-            c_str[0] = format[pos];
-            pos++;
-            strcat(str, c_str);
+static FMT_NO_FP_CONTRACT void fmt_split(double a, double *hi, double *lo)
+{
+    /* Split the 53-bit significand into two halves of 26 bits at most
+     * (Veltkamp), so the product of any two halves is exact */
+    double c = 134217729.0 * a; /* 2^27 + 1 */
+    *hi = c - (c - a);
+    *lo = a - *hi;
+}
 
-            /* Reset flags */
-            pad_with_zeros = false;
-            buf_pos = 0;
+static FMT_NO_FP_CONTRACT double fmt_fma(double a, double b, double c)
+{
+    /* Keep the split of the operand far from overflow and underflow. Only
+     * powers of two are applied so the result stays exact */
+    double abs_a = a < 0 ? -a : a;
+    if (abs_a > 0x1p900)
+        return fmt_fma(a * 0x1p-200, b, c * 0x1p-200) * 0x1p200;
+    if (abs_a != 0 && abs_a < 0x1p-900)
+        return fmt_fma(a * 0x1p200, b, c * 0x1p200) * 0x1p-200;
+
+    /* Compute a * b + c for c close to -a * b. The rounding error of the
+     * product is taken exactly with Dekker's product since the target
+     * has no fused multiply-add for doubles */
+    double a_hi, a_lo, b_hi, b_lo;
+    fmt_split(a, &a_hi, &a_lo);
+    fmt_split(b, &b_hi, &b_lo);
+
+    double p = a * b;
+    double err =
+        ((a_hi * b_hi - p) + a_hi * b_lo + a_lo * b_hi) + a_lo * b_lo;
+
+    return (p + c) + err;
+}
+
+static void fmt_scale(double value, int exp, double *hi, double *lo)
+{
+    /* Scale the value by 10^-exp in steps of exact powers of ten. The
+     * rounding error of every step is computed exactly and kept in the low
+     * part */
+    *hi = value;
+    *lo = 0;
+    while (exp) {
+        int n = exp < 0 ? -exp : exp;
+        if (n > FMT_FLOAT_PREC_MAX)
+            n = FMT_FLOAT_PREC_MAX;
+
+        double pow10 = fmt_pow10[n];
+        double scaled;
+        if (exp < 0) {
+            scaled = *hi * pow10;
+            *lo = fmt_fma(*hi, pow10, -scaled) + *lo * pow10;
+            exp += n;
         } else {
-            pos++;
-
-            bool leave = false;
-            while (!leave && format[pos] != '\0') {
-                /* Boundary check */
-                if (check_size && pos >= size)
-                    return strlen(str);
-
-                /* Handle specifiers */
-                switch (format[pos]) {
-                case '0': {
-                    if (buf_pos == 0) {
-                        pad_with_zeros = true;
-                    } else {
-                        buf[buf_pos] = format[pos];
-                        buf_pos++;
-                    }
-                    break;
-                }
-                case '1':
-                case '2':
-                case '3':
-                case '4':
-                case '5':
-                case '6':
-                case '7':
-                case '8':
-                case '9': {
-                    buf[buf_pos] = format[pos];
-                    buf_pos++;
-                    break;
-                }
-                case '.': {
-                    break;
-                }
-                case 's': {
-                    char *s = va_arg(ap, char *);
-                    format_write(str, s, buf, &buf_pos, &pad_with_zeros);
-                    leave = true;
-                    break;
-                }
-                case 'c': {
-                    c_str[0] = (char) va_arg(ap, int);
-                    format_write(str, c_str, buf, &buf_pos, &pad_with_zeros);
-                    leave = true;
-                    break;
-                }
-                case 'o': {
-                    int o = va_arg(ap, int);
-                    char o_str[sizeof(int) * 8 + 1];
-                    itoa(o, o_str, 8);
-                    format_write(str, o_str, buf, &buf_pos, &pad_with_zeros);
-                    leave = true;
-                    break;
-                }
-                case 'x': {
-                    int x = va_arg(ap, int);
-                    char x_str[sizeof(int) * 8 + 1];
-                    itoa(x, x_str, 16);
-                    format_write(str, x_str, buf, &buf_pos, &pad_with_zeros);
-                    leave = true;
-                    break;
-                }
-                case 'p': {
-                    unsigned long p = (long) va_arg(ap, void *);
-                    char p_str[sizeof(unsigned long) * 8 + 1];
-                    ultoa(p, p_str, 16);
-                    strcat(str, "0x");
-                    format_write(str, p_str, buf, &buf_pos, &pad_with_zeros);
-                    leave = true;
-                    break;
-                }
-                case 'd': {
-                    int d = va_arg(ap, int);
-                    char d_str[sizeof(int) * 8 + 1];
-                    itoa(d, d_str, 10);
-                    format_write(str, d_str, buf, &buf_pos, &pad_with_zeros);
-                    leave = true;
-                    break;
-                }
-                case 'u': {
-                    unsigned int u = va_arg(ap, unsigned int);
-                    char u_str[sizeof(unsigned int) * 8 + 1];
-                    utoa(u, u_str, 10);
-                    format_write(str, u_str, buf, &buf_pos, &pad_with_zeros);
-                    leave = true;
-                    break;
-                }
-                default:
-                    break;
-                }
-
-                pos++;
-            }
+            scaled = *hi / pow10;
+            *lo = (fmt_fma(-scaled, pow10, *hi) + *lo) / pow10;
+            exp -= n;
         }
+
+        /* Keep the low part below a unit of the high part */
+        *hi = scaled + *lo;
+        *lo -= *hi - scaled;
+    }
+}
+
+static int fmt_normalize(double *value, double *lo)
+{
+    *lo = 0;
+
+    if (*value == 0)
+        return 0;
+
+    /* Take the binary exponent from the bits, as frexp() would return it */
+    uint64_t bits;
+    memcpy(&bits, value, sizeof(bits));
+    int exp2 = (bits >> 52) & 0x7ff;
+    if (exp2)
+        exp2 -= 1022;
+    else
+        exp2 = -1010 - __builtin_clzll(bits << 1 >> 1); /* Subnormal */
+
+    /* Estimate the decimal exponent from the binary one, 78913 / 2^18 is
+     * close to log10(2) so the estimate is off by one at most */
+    int exp = ((exp2 - 1) * 78913) >> 18;
+
+    /* Scale the value into [1, 10) and fix the estimated exponent */
+    double hi;
+    fmt_scale(*value, exp, &hi, lo);
+    if (hi < 1 || (hi == 1 && *lo < 0))
+        fmt_scale(*value, --exp, &hi, lo);
+    else if (hi > 10 || (hi == 10 && *lo >= 0))
+        fmt_scale(*value, ++exp, &hi, lo);
+
+    *value = hi;
+    return exp;
+}
+
+static uint64_t fmt_round(double value, double lo, int prec, uint64_t *frac)
+{
+    /* Split the value into the integer part and the fraction scaled by
+     * 10^prec. The exact error of the product is taken with fmt_fma() along
+     * with the low part of the value */
+    uint64_t integer = (uint64_t) value;
+    double fraction = value - integer;
+    double pow10 = fmt_pow10[prec];
+    double scaled = fraction * pow10;
+    double err = fmt_fma(fraction, pow10, -scaled) + lo * pow10;
+
+    /* Distance of the exact value from the halfway point above the digits
+     * taken from the product. The error may add whole units to the digits,
+     * and only an exact tie is rounded half to even */
+    int64_t digits = (uint64_t) scaled;
+    double diff = (scaled - digits - 0.5) + err;
+    double units = (int64_t) diff;
+    if (units > diff)
+        units--;
+    digits += (int64_t) units;
+    uint64_t last = prec ? digits : integer + digits;
+    if (diff != units || (last & 1))
+        digits++;
+
+    /* Carry or borrow between the fraction and the integer part */
+    if (digits >= (int64_t) fmt_pow10[prec]) {
+        digits -= fmt_pow10[prec];
+        integer++;
+    } else if (digits < 0) {
+        digits += fmt_pow10[prec];
+        integer--;
     }
 
-    return strlen(str);
+    *frac = digits;
+    return integer;
 }
 
-int vsprintf(char *str, const char *format, va_list ap)
+static uint64_t fmt_round_exp(double value, int prec, int *exp, uint64_t *frac)
 {
-    return __vsnprintf(str, 0, false, format, ap);
+    double mantissa = value, lo;
+    uint64_t integer;
+
+    *exp = fmt_normalize(&mantissa, &lo);
+
+    int shift = *exp - prec;
+    if (value < 1 || value >= FMT_FIXED_MAX) {
+        integer = fmt_round(mantissa, lo, prec, frac);
+    } else {
+        /* The integer part of the value is exact, so are the ties when the
+         * digits are taken from it directly */
+        uint64_t digits;
+        if (shift <= 0) {
+            integer = fmt_round(value, 0, -shift, frac);
+            digits = integer * fmt_pow10[-shift] + *frac;
+        } else {
+            uint64_t whole = (uint64_t) value;
+            uint64_t half = fmt_pow10[shift] / 2;
+            uint64_t rem = whole % fmt_pow10[shift];
+            digits = whole / fmt_pow10[shift];
+            if (rem > half || (rem == half && (value > whole || (digits & 1))))
+                digits++;
+        }
+
+        integer = digits / fmt_pow10[prec];
+        *frac = digits % fmt_pow10[prec];
+    }
+
+    /* Rounded up to 10, e.g., 9.9999 to 10.000 */
+    if (integer >= 10) {
+        integer = 1;
+        (*exp)++;
+    }
+
+    return integer;
+}
+
+static void fmt_float(struct fmt_out *out, struct fmt_spec *spec, double value)
+{
+    char buf[FMT_BUF_SIZE];
+    char prefix[2] = {0};
+    char suffix[8] = {0};
+    bool upper = spec->conv >= 'A' && spec->conv <= 'Z';
+    char conv = spec->conv | 0x20;
+    int prec = spec->prec < 0 ? 6 : spec->prec;
+    bool strip = false;
+    int exp = 0;
+
+    /* Sign */
+    if (__builtin_signbit(value)) {
+        prefix[0] = '-';
+        value = -value;
+    } else if (spec->flags & FMT_PLUS) {
+        prefix[0] = '+';
+    } else if (spec->flags & FMT_SPACE) {
+        prefix[0] = ' ';
+    }
+
+    /* Infinity and NaN */
+    if (__builtin_isnan(value) || __builtin_isinf(value)) {
+        const char *s = __builtin_isnan(value) ? (upper ? "NAN" : "nan")
+                                               : (upper ? "INF" : "inf");
+        spec->flags &= ~FMT_ZERO;
+        fmt_field(out, spec, prefix, 0, s, 3, 0, "");
+        return;
+    }
+
+    /* %g uses %f or %e depending on the exponent after rounding to the
+     * precision, and removes the trailing zeros */
+    if (conv == 'g') {
+        int digits = prec ? prec : 1;
+        int round_prec = digits - 1 < FMT_FLOAT_PREC_MAX ? digits - 1
+                                                         : FMT_FLOAT_PREC_MAX;
+        uint64_t frac;
+        fmt_round_exp(value, round_prec, &exp, &frac);
+
+        if (digits > exp && exp >= -4) {
+            conv = 'f';
+            prec = digits - 1 - exp;
+        } else {
+            conv = 'e';
+            prec = digits - 1;
+        }
+
+        strip = !(spec->flags & FMT_ALT);
+    }
+
+    /* The integer part of %f must fit in 64 bits */
+    if (conv == 'f' && value >= FMT_FIXED_MAX)
+        conv = 'e';
+
+    /* Digits beyond the precision of double are written as zeros */
+    int gen_prec = prec < FMT_FLOAT_PREC_MAX ? prec : FMT_FLOAT_PREC_MAX;
+    int trail = prec - gen_prec;
+    int zeros = 0;
+    uint64_t integer, frac;
+
+    if (conv == 'e') {
+        integer = fmt_round_exp(value, gen_prec, &exp, &frac);
+
+        /* Exponent with at least 2 digits */
+        char *end = &suffix[sizeof(suffix) - 1];
+        char *start = fmt_utoa(end, exp < 0 ? -exp : exp, 10, false);
+        if (end - start < 2)
+            *--start = '0';
+        *--start = exp < 0 ? '-' : '+';
+        *--start = upper ? 'E' : 'e';
+        memmove(suffix, start, end - start + 1);
+    } else {
+        /* Skip the leading zeros of a small fraction, so the digits after
+         * them are generated up to the precision of double as well */
+        double lo = 0;
+        if (trail && value > 0 && value < 0.1) {
+            double mantissa = value;
+            zeros = -fmt_normalize(&mantissa, &lo) - 1;
+            if (zeros > trail)
+                zeros = trail;
+            if (zeros > FMT_FLOAT_PREC_MAX)
+                zeros = FMT_FLOAT_PREC_MAX;
+            fmt_scale(value, -zeros, &value, &lo);
+        }
+
+        integer = fmt_round(value, zeros ? lo : 0, gen_prec, &frac);
+
+        /* Rounded up to 10^-zeros, e.g., 0.0099 to 0.0100 */
+        if (zeros && integer) {
+            integer = 0;
+            frac = fmt_pow10[gen_prec - 1];
+            zeros--;
+        }
+
+        trail -= zeros;
+    }
+
+    /* Integer part */
+    char *end = &buf[FMT_BUF_SIZE];
+    char *start = fmt_utoa(end, integer, 10, false);
+    int len = end - start;
+    memmove(buf, start, len);
+
+    /* Fraction part */
+    if (gen_prec) {
+        buf[len++] = '.';
+        end = &buf[len + zeros + gen_prec];
+        start = fmt_utoa(end, frac, 10, false);
+        while (start > &buf[len])
+            *--start = '0';
+        len += zeros + gen_prec;
+    } else if (trail || (spec->flags & FMT_ALT)) {
+        buf[len++] = '.';
+    }
+
+    if (strip) {
+        trail = 0;
+        if (memchr(buf, '.', len)) {
+            while (buf[len - 1] == '0')
+                len--;
+            if (buf[len - 1] == '.')
+                len--;
+        }
+    }
+
+    fmt_field(out, spec, prefix, 0, buf, len, trail, suffix);
+}
+
+static const char *fmt_parse(const char *format,
+                             struct fmt_spec *spec,
+                             va_list *ap)
+{
+    /* Flags */
+    spec->flags = 0;
+    while (1) {
+        if (*format == '-')
+            spec->flags |= FMT_LEFT;
+        else if (*format == '+')
+            spec->flags |= FMT_PLUS;
+        else if (*format == ' ')
+            spec->flags |= FMT_SPACE;
+        else if (*format == '#')
+            spec->flags |= FMT_ALT;
+        else if (*format == '0')
+            spec->flags |= FMT_ZERO;
+        else
+            break;
+        format++;
+    }
+
+    /* Width, a negative width from the argument means left-justified */
+    spec->width = 0;
+    if (*format == '*') {
+        spec->width = va_arg(*ap, int);
+        if (spec->width < 0) {
+            spec->flags |= FMT_LEFT;
+            spec->width = -spec->width;
+        }
+        format++;
+    } else {
+        while (*format >= '0' && *format <= '9')
+            spec->width = spec->width * 10 + (*format++ - '0');
+    }
+
+    /* Precision, a negative precision from the argument is ignored */
+    spec->prec = -1;
+    if (*format == '.') {
+        format++;
+        spec->prec = 0;
+        if (*format == '*') {
+            spec->prec = va_arg(*ap, int);
+            if (spec->prec < 0)
+                spec->prec = -1;
+            format++;
+        } else {
+            while (*format >= '0' && *format <= '9')
+                spec->prec = spec->prec * 10 + (*format++ - '0');
+        }
+    }
+
+    /* Length modifier */
+    spec->length = FMT_LEN_NONE;
+    switch (*format) {
+    case 'h':
+        format++;
+        spec->length = FMT_LEN_H;
+        if (*format == 'h') {
+            format++;
+            spec->length = FMT_LEN_HH;
+        }
+        break;
+    case 'l':
+        format++;
+        spec->length = FMT_LEN_L;
+        if (*format == 'l') {
+            format++;
+            spec->length = FMT_LEN_LL;
+        }
+        break;
+    case 'j':
+        format++;
+        spec->length = FMT_LEN_J;
+        break;
+    case 'z':
+        format++;
+        spec->length = FMT_LEN_Z;
+        break;
+    case 't':
+        format++;
+        spec->length = FMT_LEN_T;
+        break;
+    case 'L':
+        format++;
+        spec->length = FMT_LEN_LD;
+        break;
+    }
+
+    spec->conv = *format;
+
+    return *format ? format + 1 : format;
 }
 
 int vsnprintf(char *str, size_t size, const char *format, va_list ap)
 {
-    return __vsnprintf(str, size, true, format, ap);
+    struct fmt_out out = {.str = str, .size = size, .len = 0};
+    struct fmt_spec spec;
+    va_list args;
+
+    /* The formatting is done in one pass with the output written directly
+     * to the buffer, without any allocation */
+    va_copy(args, ap);
+
+    while (*format) {
+        if (*format != '%') {
+            fmt_putc(&out, *format++);
+            continue;
+        }
+
+        const char *spec_start = format;
+        format = fmt_parse(format + 1, &spec, &args);
+
+        switch (spec.conv) {
+        case 'd':
+        case 'i': {
+            int64_t value = fmt_arg_signed(&args, spec.length);
+            uint64_t abs = value < 0 ? -(uint64_t) value : (uint64_t) value;
+            fmt_int(&out, &spec, abs, value < 0);
+            break;
+        }
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            fmt_int(&out, &spec, fmt_arg_unsigned(&args, spec.length), false);
+            break;
+        case 'p':
+            fmt_int(&out, &spec, (uintptr_t) va_arg(args, void *), false);
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G': {
+            double value = spec.length == FMT_LEN_LD
+                               ? (double) va_arg(args, long double)
+                               : va_arg(args, double);
+            fmt_float(&out, &spec, value);
+            break;
+        }
+        case 'c': {
+            char c = va_arg(args, int);
+            spec.flags &= ~FMT_ZERO;
+            fmt_field(&out, &spec, "", 0, &c, 1, 0, "");
+            break;
+        }
+        case 's': {
+            const char *s = va_arg(args, const char *);
+            if (!s)
+                s = "(null)";
+
+            /* The precision limits the characters to write */
+            int len = 0;
+            while (s[len] && (spec.prec < 0 || len < spec.prec))
+                len++;
+
+            spec.flags &= ~FMT_ZERO;
+            fmt_field(&out, &spec, "", 0, s, len, 0, "");
+            break;
+        }
+        case '%':
+            fmt_putc(&out, '%');
+            break;
+        default:
+            /* Write the unsupported specification as it is */
+            fmt_write(&out, spec_start, format - spec_start);
+            break;
+        }
+    }
+
+    va_end(args);
+
+    /* Terminate the output, which may be truncated */
+    if (size)
+        str[out.len < size ? out.len : size - 1] = '\0';
+
+    return out.len;
+}
+
+int vsprintf(char *str, const char *format, va_list ap)
+{
+    return vsnprintf(str, SIZE_MAX, format, ap);
 }
 
 int sprintf(char *str, const char *format, ...)
@@ -291,7 +843,7 @@ int dprintf(int fd, const char *format, ...)
 
 int vprintf(const char *format, va_list ap)
 {
-    return vdprintf(STDOUT_FILENO, format, ap);
+    return vfprintf(stdout, format, ap);
 }
 
 int printf(const char *format, ...)
@@ -310,11 +862,9 @@ int vfprintf(FILE *stream, const char *format, va_list ap)
     char buf[PRINT_SIZE_MAX];
     vsnprintf(buf, PRINT_SIZE_MAX, format, ap);
 
-    __FILE *_stream = (__FILE *) stream;
+    /* Write through the stream buffer */
     size_t len = strlen(buf);
-    int retval = write(_stream->fd, buf, len);
-
-    return retval;
+    return fwrite(buf, 1, len, stream);
 }
 
 int fprintf(FILE *stream, const char *format, ...)
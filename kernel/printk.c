@@ -1,5 +1,7 @@
+#include <errno.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -9,10 +11,12 @@
 
 #include <arch/port.h>
 #include <common/list.h>
+#include <common/util.h>
 #include <kernel/kernel.h>
 #include <kernel/preempt.h>
 #include <kernel/printk.h>
 #include <kernel/sched.h>
+#include <kernel/syscall.h>
 #include <kernel/thread.h>
 #include <kernel/time.h>
 #include <kernel/tty.h>
@@ -20,85 +24,275 @@
 
 #include "kconfig.h"
 
-#define PRINTK_QUEUE_SIZE 20
-
-struct printk_data {
-    struct list_head list;
-    size_t size;
-    char data[PRINT_SIZE_MAX];
+#if (PRINTK_LOG_SIZE & (PRINTK_LOG_SIZE - 1))
+#error "PRINTK_LOG_SIZE must be power of 2"
+#endif
+
+#if (PRINTK_LOG_SIZE < 4 * PRINT_SIZE_MAX)
+#error "PRINTK_LOG_SIZE must be at least 4 times of PRINT_SIZE_MAX"
+#endif
+
+#define PRINTK_REC_ALIGN 8
+
+/* Size of the record carrying len bytes of data */
+#define PRINTK_REC_SIZE(len)                                          \
+    (CEILING(sizeof(struct printk_rec) + (len), PRINTK_REC_ALIGN) * \
+     PRINTK_REC_ALIGN)
+
+/* Types of the log records */
+#define PRINTK_REC_PAD 0  /* Unused space till the end of the ring */
+#define PRINTK_REC_TEXT 1 /* Message of printk() */
+#define PRINTK_REC_RAW 2  /* Console output written without the timestamp */
+#define PRINTK_REC_BIN 3  /* Format ID and arguments of printk_bin() */
+
+#define PRINTK_BIN_WORDS_MAX (1 + PRINTK_BIN_ARGS_MAX)
+
+/* Header of the log record. The header of a padding record only has the
+ * first 8 bytes, which always fit before the end of the ring */
+struct printk_rec {
+    uint32_t pos;   /* Position of the record, written last to commit it */
+    uint16_t size;  /* Size of the record including the header */
+    uint8_t type;   /* PRINTK_REC_* */
+    uint8_t level;  /* Log level of the message */
+    uint32_t seq;   /* Sequence number of the record */
+    uint32_t tv_sec;
+    uint32_t tv_nsec;
+    uint16_t len; /* Size of the data following the header */
+    uint16_t reserved;
+    char data[];
 };
 
-static struct printk_data printk_buf[PRINTK_QUEUE_SIZE];
-
 static LIST_HEAD(printkd_wait);
-static LIST_HEAD(printk_free_list);
-static LIST_HEAD(printk_wait_list);
 
 static bool stdout_initialized;
-static bool printk_is_writing;
+static bool printkd_waiting;
+
+/* Records of variable length, reserved by the callers of printk() with
+ * compare-and-swap on the head position. When the ring is full the oldest
+ * record is reclaimed by advancing the tail, so the ring always keeps the
+ * latest messages for dmesg. The positions keep increasing and wrap around
+ * the ring with the mask. They start from a nonzero value so the zeroed ring
+ * holds no committed record */
+static uint8_t printk_ring[PRINTK_LOG_SIZE] __attribute__((aligned(8)));
+static uint32_t printk_head = PRINTK_LOG_SIZE;        /* Next to reserve */
+static uint32_t printk_tail = PRINTK_LOG_SIZE;        /* Oldest record */
+static uint32_t printk_console_pos = PRINTK_LOG_SIZE; /* Next to print */
+static uint32_t printk_seq;  /* Sequence number of the next record */
+static uint32_t printk_lost; /* Messages dropped or never printed */
+
+static inline struct printk_rec *printk_rec_at(uint32_t pos)
+{
+    return (struct printk_rec *) &printk_ring[pos & (PRINTK_LOG_SIZE - 1)];
+}
 
-ssize_t console_write(const char *buf, size_t size)
+static bool printk_rec_valid(uint32_t pos)
+{
+    struct printk_rec *rec = printk_rec_at(pos);
+    uint32_t offset = pos & (PRINTK_LOG_SIZE - 1);
+
+    /* The record is committed only if it holds its own position. A stale word
+     * of an older record may hold the same value, so the header is also
+     * checked before the size is trusted to move to the next record */
+    if (__atomic_load_n(&rec->pos, __ATOMIC_ACQUIRE) != pos)
+        return false;
+
+    /* A padding record fills the ring till the end */
+    if (rec->type == PRINTK_REC_PAD)
+        return rec->size == PRINTK_LOG_SIZE - offset;
+
+    /* Other records are sized by their data and never wrap around */
+    return rec->type <= PRINTK_REC_BIN &&
+           offset + sizeof(struct printk_rec) <= PRINTK_LOG_SIZE &&
+           rec->size == PRINTK_REC_SIZE(rec->len) &&
+           offset + rec->size <= PRINTK_LOG_SIZE;
+}
+
+static void printk_get_time(struct timespec *tp)
+{
+    struct timespec check;
+
+    /* Read the time again if the tick interrupt updated it in between */
+    do {
+        get_sys_time(tp);
+        get_sys_time(&check);
+    } while (tp->tv_sec != check.tv_sec || tp->tv_nsec != check.tv_nsec);
+}
+
+static bool printk_reclaim(uint32_t tail)
 {
-    preempt_disable();
-
-    struct printk_data *entry;
-
-    /* Check if the free list still has space */
-    if (list_empty(&printk_free_list)) {
-        /* No, overwrite the oldest buffer */
-        entry = list_first_entry(&printk_wait_list, struct printk_data, list);
-        /* Move the buffer to the end of the wait queue */
-        list_del(&entry->list);
-        list_add(&entry->list, &printk_wait_list);
-    } else {
-        /* Yes, take one buffer from the free queue */
-        entry = list_first_entry(&printk_free_list, struct printk_data, list);
-        /* Move the buffer to the wait queue */
-        list_move(&entry->list, &printk_wait_list);
+    struct printk_rec *rec = printk_rec_at(tail);
+
+    /* The oldest record can not be reclaimed until it is committed */
+    if (!printk_rec_valid(tail))
+        return false;
+
+    uint32_t size = rec->size;
+    uint32_t console_pos =
+        __atomic_load_n(&printk_console_pos, __ATOMIC_RELAXED);
+    bool unprinted =
+        rec->type != PRINTK_REC_PAD && (int32_t) (tail - console_pos) >= 0;
+
+    /* The record may have been reclaimed by another caller already, which
+     * is also fine for the caller to retry the reservation */
+    if (__atomic_compare_exchange_n(&printk_tail, &tail, tail + size, false,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_RELAXED) &&
+        unprinted) {
+        __atomic_fetch_add(&printk_lost, 1, __ATOMIC_RELAXED);
     }
 
-    /* Copy write message to the prink buffer */
-    memcpy(entry->data, buf, sizeof(char) * size);
-    entry->size = size;
+    return true;
+}
 
-    /* Wake up the printk daemon */
-    if (!printk_is_writing)
-        wake_up_all(&printkd_wait);
+static bool printk_reserve(uint32_t size, uint32_t *pos)
+{
+    uint32_t head, tail, pad;
 
-    preempt_enable();
+    while (1) {
+        /* Load the tail first so it never runs ahead of the head */
+        tail = __atomic_load_n(&printk_tail, __ATOMIC_ACQUIRE);
+        head = __atomic_load_n(&printk_head, __ATOMIC_RELAXED);
+
+        /* The record does not wrap around the ring, the space till the end
+         * of the ring is skipped with a padding record instead */
+        uint32_t offset = head & (PRINTK_LOG_SIZE - 1);
+        pad = (offset + size > PRINTK_LOG_SIZE) ? PRINTK_LOG_SIZE - offset : 0;
+
+        /* Reclaim the oldest record if the ring is full */
+        if (head + pad + size - tail > PRINTK_LOG_SIZE) {
+            if (!printk_reclaim(tail))
+                return false;
+            continue;
+        }
 
-    return 0;
+        if (__atomic_compare_exchange_n(&printk_head, &head, head + pad + size,
+                                        true, __ATOMIC_ACQUIRE,
+                                        __ATOMIC_RELAXED))
+            break;
+    }
+
+    /* Commit the padding record right away */
+    if (pad) {
+        struct printk_rec *rec = printk_rec_at(head);
+        rec->size = pad;
+        rec->type = PRINTK_REC_PAD;
+        __atomic_store_n(&rec->pos, head, __ATOMIC_RELEASE);
+    }
+
+    *pos = head + pad;
+
+    return true;
 }
 
-void printk(char *format, ...)
+static void printk_log(int type, int level, const void *data, size_t len)
 {
-    va_list args;
-    va_start(args, format);
+    uint32_t size = PRINTK_REC_SIZE(len);
+    uint32_t pos;
+
+    /* Reserve the record without locking so that the threads and interrupt
+     * handlers can log concurrently. The message is dropped only if the
+     * oldest record is still being written */
+    if (!printk_reserve(size, &pos)) {
+        __atomic_fetch_add(&printk_lost, 1, __ATOMIC_RELAXED);
+        return;
+    }
 
     struct timespec tp;
-    preempt_disable();
-    get_sys_time(&tp);
-    preempt_enable();
+    printk_get_time(&tp);
+
+    /* Fill the record */
+    struct printk_rec *rec = printk_rec_at(pos);
+    rec->size = size;
+    rec->type = type;
+    rec->level = level;
+    rec->seq = __atomic_fetch_add(&printk_seq, 1, __ATOMIC_RELAXED);
+    rec->tv_sec = tp.tv_sec;
+    rec->tv_nsec = tp.tv_nsec;
+    rec->len = len;
+    memcpy(rec->data, data, len);
+
+    /* Publish the record by writing its position at last */
+    __atomic_store_n(&rec->pos, pos, __ATOMIC_RELEASE);
+
+    /* Wake up the printk daemon only if it is waiting for the records */
+    if (__atomic_load_n(&printkd_waiting, __ATOMIC_RELAXED)) {
+        preempt_disable();
+        printkd_waiting = false;
+        wake_up_all(&printkd_wait);
+        preempt_enable();
+    }
+}
 
-    char sec[sizeof(long) * 8 + 1] = {0};
-    ltoa(tp.tv_sec, sec, 10);
+static int printk_read(uint32_t *pos, struct printk_rec *hdr, char *data)
+{
+    while (1) {
+        /* Skip the records already reclaimed */
+        uint32_t tail = __atomic_load_n(&printk_tail, __ATOMIC_ACQUIRE);
+        if ((int32_t) (*pos - tail) < 0)
+            *pos = tail;
+
+        /* Check if the record is committed */
+        struct printk_rec *rec = printk_rec_at(*pos);
+        if (!printk_rec_valid(*pos))
+            return -EAGAIN;
+
+        /* Copy the record out of the ring. Only the first 8 bytes of the
+         * padding record are inside the ring */
+        memcpy(hdr, rec, offsetof(struct printk_rec, seq));
+        if (hdr->type != PRINTK_REC_PAD) {
+            memcpy(hdr, rec, sizeof(struct printk_rec));
+            if (data)
+                memcpy(data, rec->data,
+                       hdr->len < PRINT_SIZE_MAX ? hdr->len : PRINT_SIZE_MAX);
+        }
 
-    char rem[sizeof(long) * 8 + 1] = {0};
-    ltoa(tp.tv_nsec, rem, 10);
+        /* Start over if the record was reclaimed while copying */
+        tail = __atomic_load_n(&printk_tail, __ATOMIC_ACQUIRE);
+        if ((int32_t) (*pos - tail) < 0)
+            continue;
 
-    char zeros[15] = {0};
-    for (int i = 0; i < (9 - strlen(rem)); i++) {
-        zeros[i] = '0';
+        *pos += hdr->size;
+
+        if (hdr->type != PRINTK_REC_PAD)
+            return 0;
     }
+}
+
+ssize_t console_write(const char *buf, size_t size)
+{
+    if (size > PRINT_SIZE_MAX)
+        size = PRINT_SIZE_MAX;
+
+    printk_log(PRINTK_REC_RAW, KERN_INFO, buf, size);
+
+    return 0;
+}
+
+void __printk(int level, const char *format, ...)
+{
+    char buf[PRINT_SIZE_MAX];
+
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buf, PRINT_SIZE_MAX, format, args);
+    va_end(args);
 
-    char buf[PRINT_SIZE_MAX] = {'\r', 0};
-    int pos = snprintf(&buf[1], PRINT_SIZE_MAX, "[%5s.%s%s] ", sec, zeros, rem);
-    vsnprintf(&buf[pos + 1], PRINT_SIZE_MAX, format, args);
-    strcat(buf, "\n\r");
+    printk_log(PRINTK_REC_TEXT, level, buf, strlen(buf));
+}
+
+void __printk_bin(uint32_t fmt_id, int nargs, ...)
+{
+    uint32_t words[PRINTK_BIN_WORDS_MAX];
 
-    console_write(buf, strlen(buf));
+    words[0] = fmt_id;
 
+    va_list args;
+    va_start(args, nargs);
+    for (int i = 0; i < nargs; i++)
+        words[1 + i] = va_arg(args, uint32_t);
     va_end(args);
+
+    printk_log(PRINTK_REC_BIN, KERN_INFO, words,
+               (1 + nargs) * sizeof(uint32_t));
 }
 
 void panic(char *format, ...)
@@ -117,11 +311,59 @@ void panic(char *format, ...)
         ;
 }
 
-void printkd_init(void)
+uint32_t printk_lost_cnt(void)
 {
-    /* Place all prink buffers to the free queue */
-    for (int i = 0; i < PRINTK_QUEUE_SIZE; i++)
-        list_add(&printk_buf[i].list, &printk_free_list);
+    return __atomic_load_n(&printk_lost, __ATOMIC_RELAXED);
+}
+
+int printk_kmsg_info(struct kmsg_stat *msg, uint32_t seq)
+{
+    struct printk_rec hdr;
+    uint32_t pos, found_pos, found_seq;
+    bool found;
+
+    while (1) {
+        /* Find the message with the smallest sequence number not less than
+         * the given one. Only the headers are copied while searching */
+        pos = __atomic_load_n(&printk_tail, __ATOMIC_ACQUIRE);
+        found = false;
+
+        while (printk_read(&pos, &hdr, NULL) == 0) {
+            if (hdr.type != PRINTK_REC_TEXT || (int32_t) (hdr.seq - seq) < 0)
+                continue;
+
+            if (!found || (int32_t) (hdr.seq - found_seq) < 0) {
+                found_pos = pos - hdr.size;
+                found_seq = hdr.seq;
+                found = true;
+            }
+
+            /* No smaller sequence number exists */
+            if (hdr.seq == seq)
+                break;
+        }
+
+        if (!found)
+            return -ENOENT;
+
+        /* Copy the message, or search again if it was reclaimed meanwhile */
+        pos = found_pos;
+        if (printk_read(&pos, &hdr, msg->text) == 0 && hdr.seq == found_seq)
+            break;
+    }
+
+    msg->seq = hdr.seq;
+    msg->tv_sec = hdr.tv_sec;
+    msg->tv_nsec = hdr.tv_nsec;
+    msg->level = hdr.level;
+    msg->text[hdr.len < PRINT_SIZE_MAX ? hdr.len : PRINT_SIZE_MAX - 1] = '\0';
+
+    return 0;
+}
+
+NACKED int kmsg_info(struct kmsg_stat *msg, uint32_t seq)
+{
+    SYSCALL(KMSG_INFO);
 }
 
 void printkd_start(void)
@@ -139,41 +381,137 @@ static void printkd_sleep(void)
 
 bool printk_all_flushed(void)
 {
-    return list_empty(&printk_wait_list);
+    return printk_console_pos ==
+           __atomic_load_n(&printk_head, __ATOMIC_RELAXED);
+}
+
+static size_t printk_bin_encode(const uint32_t *words, int cnt, uint8_t *frame)
+{
+    const uint8_t *data = (const uint8_t *) words;
+    size_t size = cnt * sizeof(uint32_t);
+    size_t pos = 1, code_pos = 0;
+    uint8_t code = 1;
+
+    /* Frame the record with consistent overhead byte stuffing (COBS), so it
+     * contains no zero bytes and is delimited by a zero byte at both ends.
+     * The host decoder can then pick the records out of the text output of
+     * the console */
+    frame[0] = 0;
+    code_pos = pos++;
+
+    for (size_t i = 0; i < size; i++) {
+        if (data[i] == 0) {
+            frame[code_pos] = code;
+            code_pos = pos++;
+            code = 1;
+        } else {
+            frame[pos++] = data[i];
+            code++;
+        }
+    }
+
+    frame[code_pos] = code;
+    frame[pos++] = 0;
+
+    return pos;
+}
+
+static size_t printk_format_time(char *buf, uint32_t tv_sec, uint32_t tv_nsec)
+{
+    char sec[sizeof(long) * 8 + 1] = {0};
+    ltoa(tv_sec, sec, 10);
+
+    char rem[sizeof(long) * 8 + 1] = {0};
+    ltoa(tv_nsec, rem, 10);
+
+    char zeros[15] = {0};
+    for (int i = 0; i < (9 - strlen(rem)); i++) {
+        zeros[i] = '0';
+    }
+
+    return snprintf(buf, PRINT_SIZE_MAX, "\r[%5s.%s%s] ", sec, zeros, rem);
+}
+
+static void printk_console_write(struct printk_rec *rec, char *data)
+{
+    char buf[2 * PRINT_SIZE_MAX];
+    size_t size;
+
+    switch (rec->type) {
+    case PRINTK_REC_TEXT: {
+        /* The messages above the console level are only kept for dmesg */
+        if (rec->level > PRINTK_CONSOLE_LEVEL)
+            break;
+
+        size = printk_format_time(buf, rec->tv_sec, rec->tv_nsec);
+        memcpy(&buf[size], data, rec->len);
+        size += rec->len;
+        buf[size++] = '\n';
+        buf[size++] = '\r';
+        write(STDOUT_FILENO, buf, size);
+        break;
+    }
+    case PRINTK_REC_RAW:
+        write(STDOUT_FILENO, data, rec->len);
+        break;
+    case PRINTK_REC_BIN: {
+        /* Format ID, seconds, nanoseconds and the arguments */
+        uint32_t words[PRINTK_BIN_WORDS_MAX + 2];
+        int nargs = rec->len / sizeof(uint32_t) - 1;
+        memcpy(words, data, sizeof(uint32_t));
+        words[1] = rec->tv_sec;
+        words[2] = rec->tv_nsec;
+        memcpy(&words[3], &data[sizeof(uint32_t)], nargs * sizeof(uint32_t));
+
+        uint8_t frame[sizeof(words) + 3];
+        size = printk_bin_encode(words, nargs + 3, frame);
+        write(STDOUT_FILENO, frame, size);
+        break;
+    }
+    }
 }
 
 void printkd(void)
 {
     setprogname("printk");
 
-    struct printk_data *entry;
+    struct printk_rec rec;
+    char data[PRINT_SIZE_MAX];
+    uint32_t lost_reported = 0;
 
     /* Wait until stdout is ready */
     while (!stdout_initialized)
         printkd_sleep();
 
     while (1) {
-        /* Check if there is any printk message to write */
-        if (list_empty(&printk_wait_list)) {
+        /* Check if there is any record to print. The check is done with the
+         * preemption disabled so the wake up from printk() can not be
+         * missed */
+        preempt_disable();
+        int retval = printk_read(&printk_console_pos, &rec, data);
+        if (retval < 0) {
+            printkd_waiting = true;
+            prepare_to_wait(&printkd_wait, current_thread_info(), THREAD_WAIT);
+        }
+        preempt_enable();
+
+        if (retval < 0) {
             /* No, suspend the daemon */
-            printkd_sleep();
-        } else {
-            /* Pop one prink data from the wait queue */
-            preempt_disable();
-            entry =
-                list_first_entry(&printk_wait_list, struct printk_data, list);
-            list_del(&entry->list);
-            preempt_enable();
-
-            /* Write printk message to the serial */
-            printk_is_writing = true;
-            write(STDOUT_FILENO, entry->data, entry->size);
-            printk_is_writing = false;
-
-            /* Place the used buffer back to the free queue */
-            preempt_disable();
-            list_add(&entry->list, &printk_free_list);
-            preempt_enable();
+            schedule();
+            continue;
+        }
+
+        /* Write the record to the serial */
+        printk_console_write(&rec, data);
+
+        /* Report the messages lost since the last report */
+        uint32_t lost = printk_lost_cnt();
+        if (lost != lost_reported) {
+            char buf[PRINT_SIZE_MAX];
+            snprintf(buf, PRINT_SIZE_MAX, "\rprintk: %u messages lost\n\r",
+                     (unsigned int) (lost - lost_reported));
+            write(STDOUT_FILENO, buf, strlen(buf));
+            lost_reported = lost;
         }
     }
 }
@@ -9,6 +9,8 @@
 #include <kernel/syscall.h>
 #include <kernel/thread.h>
 
+#include "kconfig.h"
+
 int pthread_attr_init(pthread_attr_t *attr)
 {
     if (!attr)
@@ -186,6 +188,39 @@ NACKED int pthread_create(pthread_t *thread,
     SYSCALL(PTHREAD_CREATE);
 }
 
+int pthread_create_static(pthread_t *thread,
+                          const pthread_attr_t *attr,
+                          void *stack,
+                          size_t stack_size,
+                          void *(*start_routine)(void *),
+                          void *arg)
+{
+    /* The stack must be 8-byte aligned and large enough to hold the stack
+     * guard as well since it is used without being resized */
+    if (!stack || (uintptr_t) stack % 8 || stack_size % 8 ||
+        stack_size < STACK_SIZE_MIN + STACK_GUARD_SIZE)
+        return EINVAL;
+
+    /* Copy the attributes or inherit the priority of the calling thread */
+    pthread_attr_t static_attr;
+    if (attr) {
+        static_attr = *attr;
+    } else {
+        struct sched_param param;
+        int policy;
+        pthread_getschedparam(pthread_self(), &policy, &param);
+        pthread_attr_init(&static_attr);
+        pthread_attr_setschedparam(&static_attr, &param);
+    }
+
+    /* Replace the stack settings with the user provided memory */
+    struct thread_attr *_attr = (struct thread_attr *) &static_attr;
+    _attr->stackaddr = stack;
+    _attr->stacksize = stack_size;
+
+    return pthread_create(thread, &static_attr, start_routine, arg);
+}
+
 NACKED pthread_t pthread_self(void)
 {
     SYSCALL(PTHREAD_SELF);
@@ -0,0 +1,236 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/limits.h>
+#include <sys/mman.h>
+
+#include <arch/port.h>
+#include <common/list.h>
+#include <kernel/kernel.h>
+#include <kernel/shm.h>
+#include <kernel/syscall.h>
+#include <mm/mm.h>
+#include <mm/page.h>
+
+static LIST_HEAD(shm_list); /* List of all shared memory objects */
+
+static struct file_operations shm_file_ops;
+
+static struct shm *shm_acquire(const char *name)
+{
+    /* Find the shared memory object with the given name */
+    struct shm *shm;
+    list_for_each_entry (shm, &shm_list, list) {
+        if (!shm->unlinked && strcmp(shm->name, name) == 0)
+            return shm;
+    }
+
+    return NULL;
+}
+
+static struct shm *shm_create(const char *name, int oflag)
+{
+    /* Allocate new shared memory object */
+    struct shm *shm = kmalloc(sizeof(struct shm));
+    if (!shm)
+        return NULL;
+
+    strncpy(shm->name, name, NAME_MAX);
+    memset(&shm->file, 0, sizeof(shm->file));
+    shm->file.f_op = &shm_file_ops;
+    shm->file.f_flags = oflag;
+    shm->mem = NULL;
+    shm->size = 0;
+    shm->order = -1;
+    shm->map_cnt = 0;
+    shm->opened = false;
+    shm->unlinked = false;
+
+    /* Register the object into the system */
+    list_add(&shm->list, &shm_list);
+
+    return shm;
+}
+
+static void shm_try_free(struct shm *shm)
+{
+    /* Keep the object until it is unlinked and no longer referred */
+    if (!shm->unlinked || shm->opened || shm->map_cnt > 0)
+        return;
+
+    if (shm->mem)
+        free_pages((unsigned long) shm->mem, shm->order);
+
+    list_del(&shm->list);
+    kfree(shm);
+}
+
+int __shm_open(const char *name, int oflag, struct file **filp)
+{
+    /* Check the length of the object name */
+    if (strlen(name) >= NAME_MAX)
+        return -ENAMETOOLONG;
+
+    /* Acquire the object with the given name */
+    struct shm *shm = shm_acquire(name);
+
+    if (shm) {
+        /* The object exists but the caller requires a new one */
+        if ((oflag & O_CREAT) && (oflag & O_EXCL))
+            return -EEXIST;
+    } else {
+        /* The object does not exist and should not be created */
+        if (!(oflag & O_CREAT))
+            return -ENOENT;
+
+        /* Create new shared memory object */
+        shm = shm_create(name, oflag);
+        if (!shm)
+            return -ENOMEM;
+    }
+
+    shm->opened = true;
+    *filp = &shm->file;
+
+    return 0;
+}
+
+int __shm_unlink(const char *name)
+{
+    /* Check the length of the object name */
+    if (strlen(name) >= NAME_MAX)
+        return -ENAMETOOLONG;
+
+    /* Acquire the object with the given name */
+    struct shm *shm = shm_acquire(name);
+    if (!shm)
+        return -ENOENT;
+
+    /* Remove the name and free the object if possible */
+    shm->unlinked = true;
+    shm_try_free(shm);
+
+    return 0;
+}
+
+static int shm_truncate(struct file *filp, off_t length)
+{
+    struct shm *shm = container_of(filp, struct shm, file);
+
+    if (length < 0)
+        return -EINVAL;
+
+    /* The memory can not be reallocated while being mapped */
+    if (shm->map_cnt > 0)
+        return -EBUSY;
+
+    /* Allocate new memory pages for the object */
+    void *mem = NULL;
+    long order = -1;
+    if (length > 0) {
+        /* The object size is limited by the largest page order */
+        order = size_to_page_order(length);
+        if (order < 0)
+            return -EFBIG;
+
+        mem = alloc_pages(order);
+        if (!mem)
+            return -ENOMEM;
+
+        /* Preserve the old content and zero-fill the extended part */
+        size_t copy_size = (shm->size < length) ? shm->size : length;
+        if (copy_size > 0)
+            memcpy(mem, shm->mem, copy_size);
+        memset((char *) mem + copy_size, 0, length - copy_size);
+    }
+
+    /* Free the old memory pages */
+    if (shm->mem)
+        free_pages((unsigned long) shm->mem, shm->order);
+
+    shm->mem = mem;
+    shm->order = order;
+    shm->size = length;
+
+    return 0;
+}
+
+static int shm_mmap(struct file *filp,
+                    off_t offset,
+                    size_t length,
+                    int prot,
+                    void **addr)
+{
+    struct shm *shm = container_of(filp, struct shm, file);
+
+    /* The mapping must be inside the object */
+    if (offset < 0 || offset + length > shm->size)
+        return -ENXIO;
+
+    shm->map_cnt++;
+    *addr = (char *) shm->mem + offset;
+
+    return 0;
+}
+
+static void shm_munmap(struct file *filp, void *addr, size_t length)
+{
+    struct shm *shm = container_of(filp, struct shm, file);
+
+    shm->map_cnt--;
+    shm_try_free(shm);
+}
+
+static int shm_release(struct inode *inode, struct file *filp)
+{
+    struct shm *shm = container_of(filp, struct shm, file);
+
+    /* No file descriptor refers to the object */
+    shm->opened = false;
+    shm_try_free(shm);
+
+    return 0;
+}
+
+static struct file_operations shm_file_ops = {
+    .release = shm_release,
+    .truncate = shm_truncate,
+    .mmap = shm_mmap,
+    .munmap = shm_munmap,
+};
+
+NACKED int shm_open(const char *name, int oflag, mode_t mode)
+{
+    SYSCALL(SHM_OPEN);
+}
+
+NACKED int shm_unlink(const char *name)
+{
+    SYSCALL(SHM_UNLINK);
+}
+
+NACKED void *_mmap(const struct mmap_args *args)
+{
+    SYSCALL(MMAP);
+}
+
+void *mmap(void *addr, size_t length, int prot, int flags, int fd, off_t offset)
+{
+    struct mmap_args args = {
+        .addr = addr,
+        .length = length,
+        .prot = prot,
+        .flags = flags,
+        .fd = fd,
+        .offset = offset,
+    };
+
+    return _mmap(&args);
+}
+
+NACKED int munmap(void *addr, size_t length)
+{
+    SYSCALL(MUNMAP);
+}
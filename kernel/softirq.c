@@ -19,6 +19,7 @@ void tasklet_init(struct tasklet_struct *t,
 {
     t->func = func;
     t->data = data;
+    INIT_LIST_HEAD(&t->list);
 }
 
 void tasklet_schedule(struct tasklet_struct *t)
@@ -53,7 +54,7 @@ void softirqd(void)
 
             /* Retrieve the next tasklet */
             t = list_first_entry(&tasklet_list, struct tasklet_struct, list);
-            list_del(&t->list);
+            list_del_init(&t->list);
 
             /* Execute the tasklet */
             t->func(t->data);
@@ -24,3 +24,11 @@ NACKED int task_create(task_func_t task_func, uint8_t priority, int stack_size)
 {
     SYSCALL(TASK_CREATE);
 }
+
+NACKED int task_create_static(task_func_t task_func,
+                              uint8_t priority,
+                              void *stack,
+                              int stack_size)
+{
+    SYSCALL(TASK_CREATE_STATIC);
+}
@@ -0,0 +1,274 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <topic.h>
+#include <unistd.h>
+
+#include <arch/port.h>
+#include <common/list.h>
+#include <kernel/kernel.h>
+#include <kernel/poll.h>
+#include <kernel/preempt.h>
+#include <kernel/syscall.h>
+#include <kernel/topic.h>
+#include <mm/mm.h>
+
+static LIST_HEAD(topic_list); /* List of all created topics */
+
+static struct file_operations topic_file_ops;
+
+static struct topic *topic_acquire(const struct topic_metadata *meta)
+{
+    /* Find the topic with the given name */
+    struct topic *topic;
+    list_for_each_entry (topic, &topic_list, list) {
+        if (strcmp(topic->meta->name, meta->name) == 0)
+            return topic;
+    }
+
+    return NULL;
+}
+
+static struct topic *topic_create(const struct topic_metadata *meta)
+{
+    /* Allocate new topic */
+    struct topic *topic = kmalloc(sizeof(struct topic));
+    if (!topic)
+        return NULL;
+
+    /* Allocate message buffers */
+    topic->buf = kmalloc(meta->size * meta->queue_depth);
+    if (!topic->buf) {
+        kfree(topic);
+        return NULL;
+    }
+
+    topic->meta = meta;
+    topic->generation = 0;
+    topic->seq = 0;
+
+    /* Register the topic into the system */
+    list_add(&topic->list, &topic_list);
+
+    return topic;
+}
+
+int __topic_open(const struct topic_metadata *meta,
+                 int flags,
+                 struct file **filp)
+{
+    /* Check the metadata */
+    if (!meta || !meta->name || meta->size == 0 || meta->queue_depth == 0)
+        return -EINVAL;
+
+    /* Acquire the topic or create a new one */
+    struct topic *topic = topic_acquire(meta);
+    if (!topic) {
+        topic = topic_create(meta);
+        if (!topic)
+            return -ENOMEM;
+    } else if (topic->meta->size != meta->size) {
+        /* Topic with the same name but different message type */
+        return -EINVAL;
+    }
+
+    /* Allocate a file for the caller to track its own read progress */
+    struct topic_file *tfile = kmalloc(sizeof(struct topic_file));
+    if (!tfile)
+        return -ENOMEM;
+
+    memset(&tfile->file, 0, sizeof(tfile->file));
+    tfile->file.f_op = &topic_file_ops;
+    tfile->file.f_flags = flags;
+    tfile->topic = topic;
+
+    /* The latest message is treated as unread for the new subscriber */
+    uint32_t generation = __atomic_load_n(&topic->generation, __ATOMIC_ACQUIRE);
+    tfile->generation = generation ? generation - 1 : 0;
+
+    *filp = &tfile->file;
+
+    return 0;
+}
+
+static ssize_t topic_read(struct file *filp,
+                          char *buf,
+                          size_t size,
+                          off_t offset)
+{
+    struct topic_file *tfile = container_of(filp, struct topic_file, file);
+    struct topic *topic = tfile->topic;
+    size_t msg_size = topic->meta->size;
+    uint32_t depth = topic->meta->queue_depth;
+
+    /* The file is not opened with reading flag */
+    if ((filp->f_flags & (0x1)) != O_RDONLY && !(filp->f_flags & O_RDWR))
+        return -EBADF;
+
+    /* The buffer size must be larger or equal to the message size */
+    if (size < msg_size)
+        return -EMSGSIZE;
+
+    uint32_t seq, generation, next;
+
+    /* Copy the message without locking the topic. Retry if the publisher
+     * has updated the buffer during the copy */
+    do {
+        /* Wait until the publisher finishes the update */
+        do {
+            seq = __atomic_load_n(&topic->seq, __ATOMIC_ACQUIRE);
+        } while (seq & 0x1);
+
+        generation = topic->generation;
+
+        /* The topic has never been published */
+        if (generation == 0)
+            return -ENODATA;
+
+        next = tfile->generation;
+
+        /* Skip the messages that have been overwritten */
+        if (generation - next > depth)
+            next = generation - depth;
+
+        /* Read the latest message again if no new message is published */
+        if (next == generation)
+            next = generation - 1;
+
+        memcpy(buf, &topic->buf[(next % depth) * msg_size], msg_size);
+    } while (__atomic_load_n(&topic->seq, __ATOMIC_ACQUIRE) != seq);
+
+    tfile->generation = next + 1;
+
+    /* Return the read size */
+    return msg_size;
+}
+
+static bool topic_poll_match(struct file *filp, void *topic)
+{
+    return filp->f_op == &topic_file_ops &&
+           container_of(filp, struct topic_file, file)->topic == topic;
+}
+
+static ssize_t topic_write(struct file *filp,
+                           const char *buf,
+                           size_t size,
+                           off_t offset)
+{
+    struct topic_file *tfile = container_of(filp, struct topic_file, file);
+    struct topic *topic = tfile->topic;
+    size_t msg_size = topic->meta->size;
+    uint32_t depth = topic->meta->queue_depth;
+
+    /* The file is not opened with writing flag */
+    if ((filp->f_flags & (0x1)) != O_WRONLY && !(filp->f_flags & O_RDWR))
+        return -EBADF;
+
+    /* The write size must be equal to the message size */
+    if (size != msg_size)
+        return -EMSGSIZE;
+
+    preempt_disable();
+
+    /* Mark the buffer as being updated */
+    __atomic_store_n(&topic->seq, topic->seq + 1, __ATOMIC_RELEASE);
+
+    /* Save the message into the next slot of the ring */
+    memcpy(&topic->buf[(topic->generation % depth) * msg_size], buf, size);
+    topic->generation++;
+
+    /* Finish the update */
+    __atomic_store_n(&topic->seq, topic->seq + 1, __ATOMIC_RELEASE);
+
+    /* Wake up all the threads polling for the topic */
+    poll_notify_match(topic_poll_match, topic);
+
+    preempt_enable();
+
+    /* Return the written size */
+    return size;
+}
+
+static int topic_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
+{
+    struct topic_file *tfile = container_of(filp, struct topic_file, file);
+
+    switch (cmd) {
+    case TOPIC_CHECK_UPDATE:
+        /* Check if any message is published since the last read */
+        *(bool *) arg = __atomic_load_n(&tfile->topic->generation,
+                                        __ATOMIC_ACQUIRE) != tfile->generation;
+        return 0;
+    default:
+        return -EINVAL;
+    }
+}
+
+static uint32_t topic_poll(struct file *filp)
+{
+    struct topic_file *tfile = container_of(filp, struct topic_file, file);
+    uint32_t events = 0;
+
+    /* Topic is always writable */
+    if ((filp->f_flags & (0x1)) == O_WRONLY || (filp->f_flags & O_RDWR))
+        events |= POLLOUT;
+
+    /* Unread message exists */
+    if (__atomic_load_n(&tfile->topic->generation, __ATOMIC_ACQUIRE) !=
+        tfile->generation)
+        events |= POLLIN;
+
+    return events;
+}
+
+static int topic_release(struct inode *inode, struct file *filp)
+{
+    /* Free the file of the subscriber or the publisher. The topic itself is
+     * kept for the later subscribers to read the latest message */
+    kfree(container_of(filp, struct topic_file, file));
+    return 0;
+}
+
+static struct file_operations topic_file_ops = {
+    .read = topic_read,
+    .write = topic_write,
+    .ioctl = topic_ioctl,
+    .release = topic_release,
+    .poll = topic_poll,
+};
+
+int topic_advertise(const struct topic_metadata *meta)
+{
+    return topic_open(meta, O_WRONLY);
+}
+
+int topic_subscribe(const struct topic_metadata *meta)
+{
+    return topic_open(meta, O_RDONLY);
+}
+
+int topic_publish(const struct topic_metadata *meta, int fd, const void *data)
+{
+    ssize_t retval = write(fd, data, meta->size);
+    return (retval < 0) ? retval : 0;
+}
+
+int topic_copy(const struct topic_metadata *meta, int fd, void *data)
+{
+    ssize_t retval = read(fd, data, meta->size);
+    return (retval < 0) ? retval : 0;
+}
+
+int topic_check(int fd, bool *updated)
+{
+    return ioctl(fd, TOPIC_CHECK_UPDATE, (unsigned long) updated);
+}
+
+NACKED int topic_open(const struct topic_metadata *meta, int flags)
+{
+    SYSCALL(TOPIC_OPEN);
+}
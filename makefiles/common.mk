@@ -102,17 +102,27 @@ SRC += ./kernel/arch/v7m_port.c \
        ./kernel/fs/wrapper.c \
        ./kernel/fs/reg_file.c \
        ./kernel/fs/rom_dev.c \
+       ./kernel/fs/ram_dev.c \
+       ./kernel/fs/logfs.c \
+       ./kernel/fs/blkdev.c \
+       ./kernel/fs/buffer.c \
+       ./kernel/fs/mem_disk.c \
        ./kernel/fs/null_dev.c \
        ./kernel/mm/mpool.c \
        ./kernel/mm/mm.c \
        ./kernel/mm/page.c \
        ./kernel/mm/slab.c \
+       ./kernel/mm/alloc_trace.c \
        ./kernel/kfifo.c \
        ./kernel/kernel.c \
        ./kernel/task.c \
        ./kernel/sched.c \
        ./kernel/file.c \
+       ./kernel/io_uring.c \
+       ./kernel/aio.c \
        ./kernel/pipe.c \
+       ./kernel/topic.c \
+       ./kernel/shm.c \
        ./kernel/mqueue.c \
        ./kernel/mutex.c \
        ./kernel/semaphore.c \
@@ -125,6 +135,7 @@ SRC += ./kernel/arch/v7m_port.c \
        ./main.c
 
 SRC += ./user/debug-link/debug_link.c 
+SRC += $(MSG_BUILD)/topics.c
 
 -include ./drivers/drivers.mk
 -include ./user/shell/shell.mk
@@ -204,6 +215,9 @@ format:
 size:
 	$(SIZE) $(ELF)
 
+ram_report: $(OBJS)
+	@./scripts/ram-report.py $(NM) $(OBJS)
+
 objdump:
 	$(OBJDUMP) -d $(ELF) > $(ELF).asm
 
@@ -213,4 +227,4 @@ doxygen:
 	@rm -rf main_page.md
 	@echo "doxygen docs/Doxyfile"
 
-.PHONY: all check clean gdbauto format size objdump msggen gen_syscalls doxygen
+.PHONY: all check clean gdbauto format size ram_report objdump msggen gen_syscalls doxygen
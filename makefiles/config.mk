@@ -7,5 +7,6 @@ OBJCOPY := arm-none-eabi-objcopy
 OBJDUMP := arm-none-eabi-objdump
 GDB := arm-none-eabi-gdb
 SIZE := arm-none-eabi-size
+NM := arm-none-eabi-nm
 QEMU := qemu-system-arm
 CPPCHECK := cppcheck
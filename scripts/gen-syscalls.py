@@ -7,8 +7,11 @@ syscalls = \
      'setprogname',
      'delay_ticks',
      'task_create',
+     'task_create_static',
      'mpool_alloc',
      'minfo',
+     'alloc_trace_info',
+     'kmsg_info',
      'sched_yield',
      'exit',
      'mount',
@@ -18,8 +21,16 @@ syscalls = \
      'dup2',
      'read',
      'write',
+     'readv',
+     'writev',
+     'sendfile',
+     'splice',
      'ioctl',
+     'fcntl',
+     'io_uring_enter',
      'lseek',
+     'ftruncate',
+     'sync',
      'fstat',
      'opendir',
      'readdir',
@@ -29,13 +40,26 @@ syscalls = \
      'mknod',
      'mkfifo',
      'poll',
+     'aio_read',
+     'aio_write',
+     'aio_suspend',
+     'topic_open',
+     'shm_open',
+     'shm_unlink',
+     'mmap',
+     'munmap',
      'mq_getattr',
      'mq_setattr',
      'mq_open',
+     'mq_open_static',
      'mq_close',
      'mq_unlink',
      'mq_receive',
      'mq_send',
+     'mq_reserve',
+     'mq_commit',
+     'mq_borrow',
+     'mq_release',
      'pthread_create',
      'pthread_self',
      'pthread_join',
@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+
+# Decode the binary records of printk_bin() mixed in the console output
+# Usage: printk-decode.py <elf> [capture file or serial device]
+#
+# The text output is passed through, and every record framed by zero bytes
+# is formatted with the format strings of the .printk_fmt section in the ELF
+# file. The records are read from stdin if no file is given, e.g.:
+#     cat /dev/ttyUSB0 | printk-decode.py build/tenok.elf
+
+import re
+import struct
+import sys
+
+SHT_NOBITS = 8
+SHF_ALLOC = 0x2
+
+SPEC = re.compile(r'%([-+ #0]*)(\d*|\*)(?:\.(\d*|\*))?'
+                  r'(hh|h|ll|l|j|z|t|L)?([diouxXcsp%])')
+
+
+def load_sections(path):
+    with open(path, 'rb') as f:
+        elf = f.read()
+
+    if elf[:4] != b'\x7fELF' or elf[4] != 1:
+        sys.exit('%s: not a 32-bit ELF file' % path)
+
+    # Read the section headers
+    shoff, = struct.unpack_from('<I', elf, 0x20)
+    shentsize, shnum, shstrndx = struct.unpack_from('<HHH', elf, 0x2e)
+    headers = [struct.unpack_from('<IIIIII', elf, shoff + i * shentsize)
+               for i in range(shnum)]
+
+    # Resolve the section names with the section name string table
+    strtab = headers[shstrndx][4]
+    sections = {}
+    for name, type, flags, addr, offset, size in headers:
+        start = strtab + name
+        name = elf[start:elf.index(b'\0', start)].decode()
+        data = b'' if type == SHT_NOBITS else elf[offset:offset + size]
+        sections[name] = (flags, addr, data)
+
+    return sections
+
+
+def read_string(data, offset):
+    end = data.find(b'\0', offset)
+    if offset < 0 or end < 0:
+        return None
+
+    return data[offset:end].decode(errors='replace')
+
+
+def read_image_string(sections, addr):
+    # Find the constant string in the sections loaded to the target
+    for flags, start, data in sections.values():
+        if flags & SHF_ALLOC and start <= addr < start + len(data):
+            return read_string(data, addr - start)
+
+    return '(%#x)' % addr
+
+
+def to_signed(value):
+    return value - (1 << 32) if value & (1 << 31) else value
+
+
+def format_message(fmt, args, sections):
+    args = list(args)
+
+    def next_arg():
+        return args.pop(0) if args else 0
+
+    def convert(m):
+        flags, width, prec, length, conv = m.groups()
+        if conv == '%':
+            return '%'
+
+        # Width and precision given by the arguments
+        if width == '*':
+            width = str(to_signed(next_arg()))
+        if prec == '*':
+            prec = str(to_signed(next_arg()))
+
+        spec = '%' + flags + width + ('.' + prec if prec is not None else '')
+        value = next_arg()
+
+        if conv in 'di':
+            return (spec + 'd') % to_signed(value)
+        elif conv == 'u':
+            return (spec + 'd') % value
+        elif conv in 'oxX':
+            return (spec + conv) % value
+        elif conv == 'c':
+            return (spec + 'c') % chr(value & 0xff)
+        elif conv == 'p':
+            return (spec.replace('0', '') + 's') % ('0x%x' % value)
+        else:
+            return (spec + 's') % read_image_string(sections, value)
+
+    return SPEC.sub(convert, fmt)
+
+
+def cobs_decode(frame):
+    data = bytearray()
+    pos = 0
+
+    while pos < len(frame):
+        code = frame[pos]
+        if code == 0 or pos + code > len(frame) + 1:
+            return None
+
+        data += frame[pos + 1:pos + code]
+        pos += code
+
+        # A zero byte follows every block except the last one
+        if code < 0xff and pos < len(frame):
+            data.append(0)
+
+    return bytes(data)
+
+
+def decode_record(frame, sections):
+    data = cobs_decode(frame)
+    if data is None or len(data) < 12 or len(data) % 4:
+        return None
+
+    words = struct.unpack('<%dI' % (len(data) // 4), data)
+    fmt_id, sec, nsec, args = words[0], words[1], words[2], words[3:]
+
+    _, addr, fmts = sections['.printk_fmt']
+    fmt = read_string(fmts, fmt_id - addr)
+    if fmt is None:
+        return None
+    msg = format_message(fmt, args, sections)
+
+    return '[%5d.%09d] %s' % (sec, nsec, msg.rstrip('\n\r'))
+
+
+def main():
+    if len(sys.argv) < 2:
+        print('Usage: %s <elf> [capture file or serial device]' %
+              sys.argv[0])
+        sys.exit(1)
+
+    sections = load_sections(sys.argv[1])
+    if '.printk_fmt' not in sections:
+        sys.exit('%s: no .printk_fmt section' % sys.argv[1])
+
+    stream = open(sys.argv[2], 'rb') if len(sys.argv) > 2 else \
+        sys.stdin.buffer
+    out = sys.stdout.buffer
+
+    in_frame = False
+    frame = bytearray()
+
+    while True:
+        byte = stream.read(1)
+        if not byte:
+            break
+
+        if byte != b'\0':
+            # Pass the text through and collect the framed record
+            if in_frame:
+                frame += byte
+            else:
+                out.write(byte)
+                if byte == b'\n':
+                    out.flush()
+            continue
+
+        if not in_frame:
+            # Start of a record
+            in_frame = True
+            frame.clear()
+            continue
+
+        record = decode_record(frame, sections) if frame else None
+        if record is None:
+            # Not a record, e.g., the capture started in the middle of one.
+            # Treat the collected bytes as text and this zero byte as the
+            # start of the next record
+            out.write(frame)
+            frame.clear()
+            continue
+
+        out.write(('\r' + record + '\n').encode())
+        out.flush()
+        in_frame = False
+
+    out.flush()
+
+
+if __name__ == '__main__':
+    main()
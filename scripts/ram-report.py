@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+
+# Report the statically allocated RAM (.data and .bss) of each subsystem
+# Usage: ram-report.py <nm> <object files...>
+
+import os
+import subprocess
+import sys
+
+if len(sys.argv) < 3:
+    print('Usage: %s <nm> <object files...>' % sys.argv[0])
+    sys.exit(1)
+
+nm = sys.argv[1]
+objs = sys.argv[2:]
+
+data = {}
+bss = {}
+common_syms = set()
+
+for obj in objs:
+    # Group the object files by their directories
+    subsystem = os.path.dirname(os.path.normpath(obj)) or '.'
+    data.setdefault(subsystem, 0)
+    bss.setdefault(subsystem, 0)
+
+    output = subprocess.run([nm, '-S', obj], capture_output=True,
+                            text=True).stdout
+
+    for line in output.splitlines():
+        fields = line.split()
+        if len(fields) != 4:
+            continue
+
+        size = int(fields[1], 16)
+        type = fields[2]
+        name = fields[3]
+
+        if type in 'dD':
+            data[subsystem] += size
+        elif type in 'bB':
+            bss[subsystem] += size
+        elif type in 'C' and name not in common_syms:
+            # Tentative definitions are merged by the linker
+            common_syms.add(name)
+            bss[subsystem] += size
+
+subsystems = sorted(data, key=lambda s: data[s] + bss[s], reverse=True)
+
+print('%-40s %8s %8s %8s' % ('SUBSYSTEM', 'DATA', 'BSS', 'TOTAL'))
+for subsystem in subsystems:
+    total = data[subsystem] + bss[subsystem]
+    if total == 0:
+        continue
+    print('%-40s %8d %8d %8d' % (subsystem, data[subsystem], bss[subsystem],
+                                 total))
+
+data_total = sum(data.values())
+bss_total = sum(bss.values())
+print('%-40s %8d %8d %8d' % ('TOTAL', data_total, bss_total,
+                             data_total + bss_total))
@@ -34,11 +34,6 @@ struct super_block {
     uint64_t s_blk_addr;  /* Start address of the blocks region */
 } __attribute__((aligned(4)));
 
-/* Block header will be placed to the top of every blocks of the regular file */
-struct block_header {
-    uint64_t b_next; /* Virtual address of the next block */
-} __attribute__((aligned(4)));
-
 /* index node */
 struct inode {
     uint8_t i_mode;    /* File type: e.g., S_IFIFO, S_IFCHR, etc. */
@@ -383,48 +378,14 @@ void romfs_address_conversion_file(struct inode *inode)
     uint32_t sb_size = sizeof(romfs_sb);
     uint32_t inodes_size = sizeof(inodes);
 
-    uint32_t blk_head_size = sizeof(struct block_header);
-    uint32_t blk_free_size = FS_BLK_SIZE - blk_head_size;
-
-    /* Calculate the blocks count */
-    int blocks = inode->i_size / blk_free_size;
-    if ((inode->i_size % blk_free_size) > 0)
-        blocks++;
-
-    struct block_header *blk_head;
-    uint64_t next_blk_addr;
-
-    /* Adjust the block headers of the file */
-    for (int i = 0; i < blocks; i++) {
-        if (i == 0) {
-            /* Get the address of the firt block from inode.i_data */
-            blk_head = (struct block_header *) inode->i_data;
-            next_blk_addr = blk_head->b_next;
-        } else {
-            /* Get the address of the rest from the block header */
-            blk_head = (struct block_header *) next_blk_addr;
-            next_blk_addr = blk_head->b_next;
-        }
-
-        /* The last block header requires no adjustment */
-        if (blk_head->b_next == (uintptr_t) NULL)
-            break;
-
-        /* Adjust block_head.b_next (the address in in the block region) */
-        blk_head->b_next =
-            (uint64_t) (blk_head->b_next - (uintptr_t) romfs_blk + sb_size +
-                        inodes_size);
-
-        verbose("[inode: #%d, block #%d, next:%d]\n", inode->i_ino, i + 1,
-                (uint64_t) blk_head->b_next);
-    }
-
     /* Adjust the address stored in the inode.i_data (which is in the block
-     * region) */
+     * region). The file content is contiguous, hence no other address needs
+     * to be adjusted */
     inode->i_data = (uint64_t) (inode->i_data - (uintptr_t) romfs_blk +
                                 sb_size + inodes_size);
 
-    verbose("[inode: #%d, block #0, next:%d]\n", inode->i_ino, inode->i_data);
+    verbose("[inode: #%d, extent: %d, size: %d]\n", inode->i_ino,
+            inode->i_data, inode->i_size);
 }
 
 void romfs_export(void)
@@ -508,10 +469,8 @@ void romfs_import_file(char *host_path, char *romfs_path)
     fclose(file);
 
     /* Calculate the required blocks number */
-    uint32_t blk_head_size = sizeof(struct block_header);
-    uint32_t blk_free_size = FS_BLK_SIZE - blk_head_size;
-    int blocks = file_size / blk_free_size;
-    if ((file_size % blk_free_size) > 0)
+    int blocks = file_size / FS_BLK_SIZE;
+    if ((file_size % FS_BLK_SIZE) > 0)
         blocks++;
 
     /* Update inode information */
@@ -521,57 +480,14 @@ void romfs_import_file(char *host_path, char *romfs_path)
     printf("import %s => %s (size=%ld, blocks=%d)\n", host_path, romfs_path,
            file_size, blocks);
 
-    uint8_t *last_blk_addr = NULL;
-    int file_size_remained = file_size;
-    int file_pos = 0;
+    /* Store the file content as a contiguous extent of blocks without the
+     * block headers, so the kernel can read or map it in place */
+    uint8_t *extent_addr = (uint8_t *) ((uintptr_t) romfs_blk +
+                                        (romfs_sb.s_blk_cnt * FS_BLK_SIZE));
+    romfs_sb.s_blk_cnt += blocks;
 
-    int i;
-    for (i = 0; i < blocks; i++) {
-        /* Allocate new blocl */
-        uint8_t *block_addr = (uint8_t *) ((uintptr_t) romfs_blk +
-                                           (romfs_sb.s_blk_cnt * FS_BLK_SIZE));
-        romfs_sb.s_blk_cnt++;
-
-        /* First block to write */
-        if (i == 0) {
-            inode->i_data = (uint64_t) block_addr;
-        }
-
-        /* Update the block header for the last block */
-        if (i > 0) {
-            struct block_header *blk_head_last =
-                (struct block_header *) last_blk_addr;
-            blk_head_last->b_next = (uint64_t) block_addr;
-        }
-
-        int blk_pos = 0;
-        int write_size = 0;
-
-        /* Calculate the write size for the current block */
-        if (file_size_remained > blk_free_size) {
-            /* Too large to fit all */
-            write_size = blk_free_size;
-            file_size_remained -= blk_free_size;
-        } else {
-            /* Enough to fit the left data */
-            write_size = file_size_remained;
-        }
-
-        /* Write the block header */
-        struct block_header blk_head = {.b_next = (uint64_t) NULL};
-        memcpy(&block_addr[blk_pos], &blk_head, blk_head_size);
-        blk_pos += blk_head_size;
-
-        /* Write the left file content */
-        memcpy(&block_addr[blk_pos], &file_content[file_pos], write_size);
-        blk_pos += write_size;
-
-        /* Update the position of the file content that is written */
-        file_pos += write_size;
-
-        /* Preserve the current block address */
-        last_blk_addr = block_addr;
-    }
+    inode->i_data = (uint64_t) extent_addr;
+    memcpy(extent_addr, file_content, file_size);
 
     free(file_content);
 }
@@ -32,8 +32,17 @@ struct msg_var_entry {
     struct list_head list;
 };
 
+struct msg_topic_entry {
+    char *msg_name;
+    int queue_depth;
+
+    struct list_head list;
+};
+
 int msg_cnt = 0;
 
+LIST_HEAD(msg_topic_list);
+
 int split_tokens(char *token[3],
                  char *line,
                  int size,
@@ -329,6 +338,18 @@ int codegen(char *file_name, char *msgs, char *output_dir)
         return -1;
     }
 
+    /* Create topic header file */
+    char *topic_header_name =
+        calloc(sizeof(char), strlen(msg_name) + strlen(output_dir) + 50);
+    sprintf(topic_header_name, "%s/%s_topic.h", output_dir, msg_name);
+
+    FILE *output_topic_header = fopen(topic_header_name, "wb");
+    if (output_topic_header == NULL) {
+        printf("[msggen] error, failed to write to %s\n", topic_header_name);
+        free(topic_header_name);
+        return -1;
+    }
+
     /* Create YAML file  */
     char *yaml_name =
         calloc(sizeof(char), strlen(msg_name) + strlen(output_dir) + 50);
@@ -356,6 +377,9 @@ int codegen(char *file_name, char *msgs, char *output_dir)
 
     int line_num = 0;
 
+    /* Number of the messages buffered by the topic */
+    int queue_depth = 1;
+
     while (1) {
         line_num++;
 
@@ -385,9 +409,23 @@ int codegen(char *file_name, char *msgs, char *output_dir)
         tokens[2] =
             calloc(sizeof(char), line_end - line_start + 1); /* Description */
 
-        /* Split tokens of current line */
-        int token_cnt = split_tokens(tokens, line_start, line_end - line_start,
+        int token_cnt;
+
+        if (line_start[0] == '@') {
+            /* Parse the directive, e.g., "@queue_depth 4" */
+            if (sscanf(line_start, "@queue_depth %d", &queue_depth) == 1 &&
+                queue_depth > 0) {
+                token_cnt = 0; /* Nothing to declare */
+            } else {
+                printf("[msggen] %s:%d: error, bad directive \"%s\"\n",
+                       file_name, line_num, line_start);
+                token_cnt = -1;
+            }
+        } else {
+            /* Split tokens of current line */
+            token_cnt = split_tokens(tokens, line_start, line_end - line_start,
                                      file_name, line_num);
+        }
 
         /* token[1] can be further decomposed into variable name and index
          * number */
@@ -431,6 +469,7 @@ int codegen(char *file_name, char *msgs, char *output_dir)
         /* Clean up then abort */
         if (error) {
             fclose(output_c_header);
+            fclose(output_topic_header);
             fclose(output_yaml);
 
             struct list_head *curr, *next;
@@ -452,6 +491,7 @@ int codegen(char *file_name, char *msgs, char *output_dir)
             free(array_size);
             free(msg_name);
             free(c_header_name);
+            free(topic_header_name);
             free(yaml_name);
 
             return -1;
@@ -585,6 +625,23 @@ int codegen(char *file_name, char *msgs, char *output_dir)
 
         fprintf(output_c_header, "    return payload.size;\n}\n");
 
+        /*=========================*
+         * Topic header generation *
+         *=========================*/
+        fprintf(output_topic_header,
+                "#pragma once\n\n"
+                "#include <topic.h>\n\n"
+                "#include \"debug_link_%s_msg.h\"\n\n"
+                "#define TOPIC_QUEUE_DEPTH_%s %d\n\n"
+                "TOPIC_DECLARE(%s);\n",
+                msg_name, msg_name, queue_depth, msg_name);
+
+        /* Record the topic for generating the registration code */
+        struct msg_topic_entry *topic = malloc(sizeof(struct msg_topic_entry));
+        topic->msg_name = strdup(msg_name);
+        topic->queue_depth = queue_depth;
+        list_add(&topic->list, &msg_topic_list);
+
         /*======================*
          * YAML file generation *
          *======================*/
@@ -613,12 +670,15 @@ int codegen(char *file_name, char *msgs, char *output_dir)
             }
         }
 
-        printf("[msggen] generate %s\n[msggen] generate %s\n", c_header_name,
-               yaml_name);
+        printf(
+            "[msggen] generate %s\n[msggen] generate %s\n"
+            "[msggen] generate %s\n",
+            c_header_name, topic_header_name, yaml_name);
     }
 
     /* Clean up */
     fclose(output_c_header);
+    fclose(output_topic_header);
     fclose(output_yaml);
 
     struct list_head *curr, *next;
@@ -636,11 +696,66 @@ int codegen(char *file_name, char *msgs, char *output_dir)
 
     free(msg_name);
     free(c_header_name);
+    free(topic_header_name);
     free(yaml_name);
 
     return (var_duplicated == false) ? 0 : -1;
 }
 
+int topic_codegen(char *output_dir)
+{
+    /* Create C source file for registering all topics */
+    char *c_source_name = calloc(sizeof(char), strlen(output_dir) + 50);
+    sprintf(c_source_name, "%s/topics.c", output_dir);
+
+    FILE *output_c_source = fopen(c_source_name, "wb");
+    if (output_c_source == NULL) {
+        printf("[msggen] error, failed to write to %s\n", c_source_name);
+        free(c_source_name);
+        return -1;
+    }
+
+    fprintf(output_c_source, "#include <topic.h>\n\n");
+
+    struct list_head *curr;
+    list_for_each (curr, &msg_topic_list) {
+        struct msg_topic_entry *topic =
+            list_entry(curr, struct msg_topic_entry, list);
+        fprintf(output_c_source, "#include \"%s_topic.h\"\n",
+                topic->msg_name);
+    }
+
+    fprintf(output_c_source, "\n");
+
+    /* Define the metadata of all topics */
+    list_for_each (curr, &msg_topic_list) {
+        struct msg_topic_entry *topic =
+            list_entry(curr, struct msg_topic_entry, list);
+        fprintf(output_c_source,
+                "TOPIC_DEFINE(%s, debug_link_msg_%s_t, "
+                "TOPIC_QUEUE_DEPTH_%s);\n",
+                topic->msg_name, topic->msg_name, topic->msg_name);
+    }
+
+    printf("[msggen] generate %s\n", c_source_name);
+
+    /* Clean up */
+    fclose(output_c_source);
+    free(c_source_name);
+
+    struct list_head *next;
+    list_for_each_safe (curr, next, &msg_topic_list) {
+        struct msg_topic_entry *topic =
+            list_entry(curr, struct msg_topic_entry, list);
+        list_del(curr);
+
+        free(topic->msg_name);
+        free(topic);
+    }
+
+    return 0;
+}
+
 char *load_msg_file(char *file_name)
 {
     /* Open msg file */
@@ -723,5 +838,9 @@ int main(int argc, char **argv)
     /* Close directory */
     closedir(dir);
 
+    /* Generate the registration code of the topics */
+    if (!failed && topic_codegen(output_dir) != 0)
+        failed = true;
+
     return failed == true ? -1 : 0;
 }
@@ -0,0 +1,67 @@
+#include <stdio.h>
+#include <time.h>
+
+#include "kconfig.h"
+#include "shell.h"
+
+#define PRINTF_BENCH_RUNS 2000
+
+/* Compare the result with USE_TENOK_PRINTF set to 1 and 0 (newlib). The
+ * code size can be compared with the symbols of the two builds, e.g.,
+ * arm-none-eabi-size and arm-none-eabi-nm --size-sort */
+
+static long printf_bench_elapsed(struct timespec *start, struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1000000L +
+           (end->tv_nsec - start->tv_nsec) / 1000L;
+}
+
+int printf_bench(int argc, char *argv[])
+{
+    char buf[PRINT_SIZE_MAX];
+    struct timespec start, end;
+    long elapsed[4];
+
+    printf("printf benchmark (USE_TENOK_PRINTF=%d, %d runs)\n\r",
+           USE_TENOK_PRINTF, PRINTF_BENCH_RUNS);
+
+    /* Integers */
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < PRINTF_BENCH_RUNS; i++)
+        snprintf(buf, PRINT_SIZE_MAX, "%d %5u %08x %-6d|", i, i * 7, i * 13,
+                 -i);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    elapsed[0] = printf_bench_elapsed(&start, &end);
+
+    /* Strings and characters */
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < PRINTF_BENCH_RUNS; i++)
+        snprintf(buf, PRINT_SIZE_MAX, "%s: %-10s %c%c", "sensor", "imu0",
+                 'o', 'k');
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    elapsed[1] = printf_bench_elapsed(&start, &end);
+
+    /* Fixed-point floats, e.g., the telemetry of attitude */
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < PRINTF_BENCH_RUNS; i++)
+        snprintf(buf, PRINT_SIZE_MAX, "%6.2f %6.2f %6.2f", i * 0.01f,
+                 -i * 0.02f, i * 1.5f);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    elapsed[2] = printf_bench_elapsed(&start, &end);
+
+    /* Exponent and shortest forms */
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < PRINTF_BENCH_RUNS; i++)
+        snprintf(buf, PRINT_SIZE_MAX, "%e %g", i * 1.25e-7, i * 3.3e5);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    elapsed[3] = printf_bench_elapsed(&start, &end);
+
+    printf("integers: %ld us\n\r", elapsed[0]);
+    printf("strings:  %ld us\n\r", elapsed[1]);
+    printf("%%f:       %ld us\n\r", elapsed[2]);
+    printf("%%e, %%g:   %ld us\n\r", elapsed[3]);
+
+    return 0;
+}
+
+HOOK_SHELL_CMD("printf_bench", printf_bench);
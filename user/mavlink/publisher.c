@@ -1,5 +1,6 @@
 #include <errno.h>
 #include <fcntl.h>
+#include <sys/uio.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -9,10 +10,49 @@ extern int mavlink_fd;
 
 void mavlink_send_msg(mavlink_message_t *msg, int fd)
 {
-    uint8_t buf[MAVLINK_MAX_PACKET_LEN];
-    uint16_t len = mavlink_msg_to_send_buffer(buf, msg);
+    uint8_t header[MAVLINK_NUM_HEADER_BYTES];
+    uint8_t ck[2];
+    size_t header_len;
 
-    write(fd, buf, len);
+    /* Serialize the header only, the payload is sent from the message
+     * directly without copying */
+    header[0] = msg->magic;
+    header[1] = msg->len;
+    if (msg->magic == MAVLINK_STX_MAVLINK1) {
+        header[2] = msg->seq;
+        header[3] = msg->sysid;
+        header[4] = msg->compid;
+        header[5] = msg->msgid & 0xFF;
+        header_len = MAVLINK_CORE_HEADER_MAVLINK1_LEN + 1;
+    } else {
+        header[2] = msg->incompat_flags;
+        header[3] = msg->compat_flags;
+        header[4] = msg->seq;
+        header[5] = msg->sysid;
+        header[6] = msg->compid;
+        header[7] = msg->msgid & 0xFF;
+        header[8] = (msg->msgid >> 8) & 0xFF;
+        header[9] = (msg->msgid >> 16) & 0xFF;
+        header_len = MAVLINK_NUM_HEADER_BYTES;
+    }
+
+    ck[0] = msg->checksum & 0xFF;
+    ck[1] = msg->checksum >> 8;
+
+    struct iovec iov[4] = {
+        {.iov_base = header, .iov_len = header_len},
+        {.iov_base = (void *) _MAV_PAYLOAD(msg), .iov_len = msg->len},
+        {.iov_base = ck, .iov_len = sizeof(ck)},
+        {.iov_base = msg->signature, .iov_len = MAVLINK_SIGNATURE_BLOCK_LEN},
+    };
+
+    /* The signature is only appended to the signed MAVLink 2 messages */
+    int iovcnt = 3;
+    if (msg->magic != MAVLINK_STX_MAVLINK1 &&
+        (msg->incompat_flags & MAVLINK_IFLAG_SIGNED))
+        iovcnt = 4;
+
+    writev(fd, iov, iovcnt);
 }
 
 void mavlink_send_heartbeat(int fd)
@@ -1,17 +1,21 @@
 #include <fcntl.h>
+#include <io_uring.h>
 #include <ioctl.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
 #include <task.h>
 #include <tenok.h>
+#include <topic.h>
 #include <unistd.h>
 
+#include "attitude_topic.h"
 #include "bsp_drv.h"
-#include "debug_link_attitude_msg.h"
-#include "debug_link_imu_msg.h"
-#include "debug_link_pid_msg.h"
+#include "imu_topic.h"
 #include "madgwick_filter.h"
+#include "pid_topic.h"
 #include "pwm.h"
 #include "sbus.h"
 
@@ -41,6 +45,9 @@
  */
 #define FLIGHT_CTRL_SLEEP_TIME (100000 / FLIGHT_CTRL_FREQ)
 
+/* Max number of the I/O requests batched by the control loop */
+#define FLIGHT_CTRL_RING_SIZE 16
+
 typedef struct {
     float kp;
     float ki;
@@ -85,9 +92,6 @@ static pid_control_t pid_yaw_rate = {
 
 static bool flight_ctrl_running;
 static bool run_esc_calib;
-static float rpy[3];
-static float motors[4];
-static madgwick_t madgwick_ahrs;
 
 float calc_elapsed_time(struct timespec *tp_now, struct timespec *tp_last)
 {
@@ -116,6 +120,39 @@ void bound_float(float *val, float max, float min)
         *val = min;
 }
 
+static void queue_motor_outputs(struct io_uring *ring,
+                                int pwm_fd,
+                                float motors[4])
+{
+    io_uring_prep_ioctl(io_uring_get_sqe(ring), pwm_fd, SET_PWM_CHANNEL1,
+                        (unsigned long) &motors[0]);
+    io_uring_prep_ioctl(io_uring_get_sqe(ring), pwm_fd, SET_PWM_CHANNEL2,
+                        (unsigned long) &motors[1]);
+    io_uring_prep_ioctl(io_uring_get_sqe(ring), pwm_fd, SET_PWM_CHANNEL3,
+                        (unsigned long) &motors[2]);
+    io_uring_prep_ioctl(io_uring_get_sqe(ring), pwm_fd, SET_PWM_CHANNEL4,
+                        (unsigned long) &motors[3]);
+}
+
+static void queue_led_outputs(struct io_uring *ring,
+                              int led_fd,
+                              unsigned long r,
+                              unsigned long g,
+                              unsigned long b)
+{
+    io_uring_prep_ioctl(io_uring_get_sqe(ring), led_fd, LED_R, r);
+    io_uring_prep_ioctl(io_uring_get_sqe(ring), led_fd, LED_G, g);
+    io_uring_prep_ioctl(io_uring_get_sqe(ring), led_fd, LED_B, b);
+}
+
+static void submit_ring(struct io_uring *ring)
+{
+    /* The results are ignored like the unbatched calls */
+    int cnt = io_uring_submit(ring);
+    if (cnt > 0)
+        io_uring_cq_advance(ring, cnt);
+}
+
 static void set_motor_outputs(int pwm_fd, float motors[4])
 {
     ioctl(pwm_fd, SET_PWM_CHANNEL1, (unsigned long) &motors[0]);
@@ -319,8 +356,23 @@ void flight_control_task(void)
     setprogname("flight control");
 
     /* Initialize Madgwick Filter for attitude estimation */
+    madgwick_t madgwick_ahrs;
     madgwick_init(&madgwick_ahrs, 400, 0.105);
 
+    /* Advertise topics of the sensor and estimator data */
+    int imu_fd = topic_advertise(TOPIC_ID(imu));
+    int att_fd = topic_advertise(TOPIC_ID(attitude));
+    int pid_fd = topic_advertise(TOPIC_ID(pid));
+
+    if (imu_fd < 0 || att_fd < 0 || pid_fd < 0) {
+        printf("failed to advertise the topics.\n\r");
+        exit(1);
+    }
+
+    debug_link_msg_imu_t imu_msg;
+    debug_link_msg_attitude_t att_msg;
+    debug_link_msg_pid_t pid_msg;
+
     /* Open RGB LED */
     int led_fd = open("/dev/led", 0);
     if (led_fd < 0) {
@@ -367,6 +419,8 @@ void flight_control_task(void)
 
     sbus_t rc;
     float throttle;
+    float rpy[3];
+    float motors[4];
 
     /* Wait until RC joystick positions are reset */
     rc_safety_protection(rc_fd, led_fd);
@@ -386,6 +440,15 @@ void flight_control_task(void)
     /* Forbid ESC calibration */
     flight_ctrl_running = true;
 
+    /* Ring for batching the I/O requests of the control loop */
+    struct io_uring_sqe sqes[FLIGHT_CTRL_RING_SIZE];
+    struct io_uring_cqe cqes[FLIGHT_CTRL_RING_SIZE];
+    struct io_uring ring;
+    io_uring_init(&ring, sqes, cqes, FLIGHT_CTRL_RING_SIZE);
+
+    float motors_min[4] = {THRUST_PWM_MIN, THRUST_PWM_MIN, THRUST_PWM_MIN,
+                           THRUST_PWM_MIN};
+
     while (1) {
         /* Loop frequency control */
         while (time_elapsed < FLIGHT_CTRL_PERIOD) {
@@ -397,18 +460,20 @@ void flight_control_task(void)
         time_last = time_now;
         time_elapsed = 0;
 
-        /* Read RC signal */
-        read(rc_fd, &rc, sizeof(sbus_t));
+        /* Read RC signal, accelerometer and gyroscope with one syscall */
+        io_uring_prep_read(io_uring_get_sqe(&ring), rc_fd, &rc, sizeof(sbus_t));
+        io_uring_prep_read(io_uring_get_sqe(&ring), accel_fd, accel,
+                           sizeof(float[3]));
+        io_uring_prep_read(io_uring_get_sqe(&ring), gyro_fd, gyro,
+                           sizeof(float[3]));
+        submit_ring(&ring);
+
         throttle = rc.throttle * 0.01f;  // Convert from [0, 100] to [0, 1]
 
-        /* Read accelerometer */
-        read(accel_fd, accel, sizeof(float[3]));
         gravity[0] = -accel[0];
         gravity[1] = -accel[1];
         gravity[2] = -accel[2];
 
-        /* Read gyroscope */
-        read(gyro_fd, gyro, sizeof(float[3]));
         gyro_rad[0] = deg_to_rad(gyro[0] - gyro_bias[0]);
         gyro_rad[1] = deg_to_rad(gyro[1] - gyro_bias[1]);
         gyro_rad[2] = deg_to_rad(gyro[2] - gyro_bias[2]);
@@ -417,6 +482,17 @@ void flight_control_task(void)
         madgwick_imu_ahrs(&madgwick_ahrs, gravity, gyro_rad);
         quat_to_euler(madgwick_ahrs.q, rpy);
 
+        /* Publish sensor and attitude data */
+        memcpy(imu_msg.accel, accel, sizeof(imu_msg.accel));
+        memcpy(imu_msg.gyro, gyro, sizeof(imu_msg.gyro));
+        io_uring_prep_write(io_uring_get_sqe(&ring), imu_fd, &imu_msg,
+                            sizeof(imu_msg));
+
+        memcpy(att_msg.q, madgwick_ahrs.q, sizeof(att_msg.q));
+        memcpy(att_msg.rpy, rpy, sizeof(att_msg.rpy));
+        io_uring_prep_write(io_uring_get_sqe(&ring), att_fd, &att_msg,
+                            sizeof(att_msg));
+
         /* Roll and pitch attitude control */
         attitude_pd_control(&pid_roll, rpy[0], -rc.roll, gyro[0]);
         attitude_pd_control(&pid_pitch, rpy[1], -rc.pitch, gyro[1]);
@@ -424,6 +500,13 @@ void flight_control_task(void)
         /* Yaw rate control */
         yaw_rate_p_control(&pid_yaw_rate, -rc.yaw, gyro[2]);
 
+        /* Publish controller outputs */
+        pid_msg.error_rpy[0] = pid_roll.output;
+        pid_msg.error_rpy[1] = pid_pitch.output;
+        pid_msg.error_rpy[2] = 0.0f;
+        io_uring_prep_write(io_uring_get_sqe(&ring), pid_fd, &pid_msg,
+                            sizeof(pid_msg));
+
         /* Thrust allocation */
         quadrotor_thrust_allocation(throttle, pid_roll.output, pid_pitch.output,
                                     pid_yaw_rate.output, motors);
@@ -432,29 +515,31 @@ void flight_control_task(void)
          * the throttle is greater than 5% */
         if (rc.dual_switch1) {
             /* Motor disarmed */
-            ioctl(led_fd, LED_R, LED_DISABLE);
-            ioctl(led_fd, LED_G, LED_DISABLE);
-            ioctl(led_fd, LED_B, LED_ENABLE);
+            queue_led_outputs(&ring, led_fd, LED_DISABLE, LED_DISABLE,
+                              LED_ENABLE);
 
             /* Disable all motors */
-            disable_all_motors(pwm_fd);
+            queue_motor_outputs(&ring, pwm_fd, motors_min);
         } else {
             /* Motor armed */
-            ioctl(led_fd, LED_R, LED_ENABLE);
-            ioctl(led_fd, LED_G, LED_DISABLE);
-            ioctl(led_fd, LED_B, LED_DISABLE);
+            queue_led_outputs(&ring, led_fd, LED_ENABLE, LED_DISABLE,
+                              LED_DISABLE);
 
             if (rc.throttle > 5) {
                 /* Set control output */
-                set_motor_outputs(pwm_fd, motors);
+                queue_motor_outputs(&ring, pwm_fd, motors);
             } else {
                 /* Disable all motors */
-                disable_all_motors(pwm_fd);
+                queue_motor_outputs(&ring, pwm_fd, motors_min);
             }
         }
 
         /* Frequency testing */
-        ioctl(freq_tester_fd, FREQ_TESTER, GPIO_TOGGLE);
+        io_uring_prep_ioctl(io_uring_get_sqe(&ring), freq_tester_fd,
+                            FREQ_TESTER, GPIO_TOGGLE);
+
+        /* Publish the topics and update the outputs with one syscall */
+        submit_ring(&ring);
     }
 }
 
@@ -465,56 +550,56 @@ void debug_link_task(void)
     /* Open debug-link serial port */
     int debug_link_fd = open("/dev/dbglink", O_RDWR);
 
-    /* Open Inertial Measurement Unit (IMU) */
-    int accel_fd = open("/dev/accel0", 0);
-    int gyro_fd = open("/dev/gyro0", 0);
+    /* Subscribe topics published by the flight controller */
+    int imu_fd = topic_subscribe(TOPIC_ID(imu));
+    int att_fd = topic_subscribe(TOPIC_ID(attitude));
+    int pid_fd = topic_subscribe(TOPIC_ID(pid));
 
-    if (accel_fd < 0 || gyro_fd < 0) {
-        printf("failed to open the IMU.\n\r");
+    if (imu_fd < 0 || att_fd < 0 || pid_fd < 0) {
+        printf("failed to subscribe the topics.\n\r");
         exit(1);
     }
 
-    float accel[3];  //[m/s^2]
-    float gyro[3];   //[deg/s]
-
     /* Debug-link messages */
     debug_link_msg_imu_t imu_msg;
     debug_link_msg_attitude_t att_msg;
     debug_link_msg_pid_t pid_msg;
-    uint8_t buf[100];
-    size_t size;
+    uint8_t buf[3][50];
+    struct iovec iov[3];
+    int iovcnt;
 
     /* 40Hz */
     while (1) {
-        read(accel_fd, accel, sizeof(float[3]));
-        read(gyro_fd, gyro, sizeof(float[3]));
-        imu_msg.accel[0] = accel[0];
-        imu_msg.accel[1] = accel[1];
-        imu_msg.accel[2] = accel[2];
-        imu_msg.gyro[0] = gyro[0];
-        imu_msg.gyro[1] = gyro[1];
-        imu_msg.gyro[2] = gyro[2];
-        size = pack_debug_link_imu_msg(&imu_msg, buf);
-        write(debug_link_fd, buf, size);
-
-        att_msg.q[0] = madgwick_ahrs.q[0];
-        att_msg.q[1] = madgwick_ahrs.q[1];
-        att_msg.q[2] = madgwick_ahrs.q[2];
-        att_msg.q[3] = madgwick_ahrs.q[3];
-        att_msg.rpy[0] = rpy[0];
-        att_msg.rpy[1] = rpy[1];
-        att_msg.rpy[2] = rpy[2];
-        size = pack_debug_link_attitude_msg(&att_msg, buf);
-        write(debug_link_fd, buf, size);
+        iovcnt = 0;
+
+        if (topic_copy(TOPIC_ID(imu), imu_fd, &imu_msg) == 0) {
+            iov[iovcnt].iov_base = buf[iovcnt];
+            iov[iovcnt].iov_len =
+                pack_debug_link_imu_msg(&imu_msg, buf[iovcnt]);
+            iovcnt++;
+        }
+
+        if (topic_copy(TOPIC_ID(attitude), att_fd, &att_msg) == 0) {
+            iov[iovcnt].iov_base = buf[iovcnt];
+            iov[iovcnt].iov_len =
+                pack_debug_link_attitude_msg(&att_msg, buf[iovcnt]);
+            iovcnt++;
+        }
+
+        if (topic_copy(TOPIC_ID(pid), pid_fd, &pid_msg) == 0) {
+            iov[iovcnt].iov_base = buf[iovcnt];
+            iov[iovcnt].iov_len =
+                pack_debug_link_pid_msg(&pid_msg, buf[iovcnt]);
+            iovcnt++;
+        }
+
+        /* Send all the packets with a single DMA transfer */
+        if (iovcnt > 0)
+            writev(debug_link_fd, iov, iovcnt);
 
-        pid_msg.error_rpy[0] = pid_roll.output;
-        pid_msg.error_rpy[1] = pid_pitch.output;
-        pid_msg.error_rpy[2] = 0.0f;
-        size = pack_debug_link_pid_msg(&pid_msg, buf);
-        write(debug_link_fd, buf, size);
         usleep(25000);
     }
 }
 
 HOOK_USER_TASK(flight_control_task, THREAD_PRIORITY_MAX, 2048);
-HOOK_USER_TASK(debug_link_task, 3, 1024);
+HOOK_USER_TASK(debug_link_task, 3, STACK_SIZE_MIN);
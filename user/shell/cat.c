@@ -1,3 +1,4 @@
+#include <fcntl.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/limits.h>
@@ -26,34 +27,27 @@ int cat(int argc, char *argv[])
     char str[PRINT_SIZE_MAX] = {0};
 
     /* Open the file */
-    FILE *file = fopen(path, "");
-    if (!file) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
         snprintf(str, PRINT_SIZE_MAX, "cat: cannot open `%s'\n\r", path);
         shell_puts(str);
         return 1;
     }
 
     struct stat stat;
-    fstat(fileno(file), &stat);
+    fstat(fd, &stat);
 
-    /* Reset read position of the file */
-    fseek(file, 0, SEEK_SET);
+    /* Let the kernel copy the whole file to the shell output */
+    ssize_t retval = shell_sendfile(fd, stat.st_size);
 
-    /* Calculate the iteration times to print the whole file */
-    int size = stat.st_size / PRINT_SIZE_MAX;
-    if ((stat.st_size % PRINT_SIZE_MAX) > 0)
-        size++;
-
-    /* Read and print the file */
-    for (int i = 0; i < size; i++) {
-        int recvd = fread(str, PRINT_SIZE_MAX - 1, 1, file);
-        str[recvd] = '\0';
+    close(fd);
 
+    if (retval < 0) {
+        snprintf(str, PRINT_SIZE_MAX, "cat: cannot read `%s'\n\r", path);
         shell_puts(str);
+        return 1;
     }
 
-    fclose(file);
-
     return 0;
 }
 
@@ -0,0 +1,34 @@
+#include <stdio.h>
+#include <tenok.h>
+
+#include "kconfig.h"
+#include "shell.h"
+
+int dmesg(int argc, char *argv[])
+{
+    char str[PRINT_SIZE_MAX];
+    struct kmsg_stat msg;
+    uint32_t seq = 0;
+
+    /* Print the messages kept in the kernel log ring, which are already
+     * formatted when logged */
+    while (kmsg_info(&msg, seq) == 0) {
+        snprintf(str, PRINT_SIZE_MAX, "[%5d.%09d] ", (int) msg.tv_sec,
+                 (int) msg.tv_nsec);
+        shell_puts(str);
+        shell_puts(msg.text);
+        shell_puts("\n\r");
+
+        seq = msg.seq + 1;
+    }
+
+    int lost = minfo(PRINTK_LOST);
+    if (lost) {
+        snprintf(str, PRINT_SIZE_MAX, "%d messages are lost\n\r", lost);
+        shell_puts(str);
+    }
+
+    return 0;
+}
+
+HOOK_SHELL_CMD("dmesg", dmesg);
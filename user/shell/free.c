@@ -26,6 +26,12 @@ int _free(int argc, char *argv[])
              heap_used, heap_free);
     shell_puts(str);
 
+    snprintf(str, PRINT_SIZE_MAX,
+             "Buffer cache: %d hits, %d misses, %d writebacks, %d dirty\n\r",
+             minfo(BCACHE_HITS), minfo(BCACHE_MISSES),
+             minfo(BCACHE_WRITEBACKS), minfo(BCACHE_DIRTY));
+    shell_puts(str);
+
     return 0;
 }
 
@@ -0,0 +1,145 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <tenok.h>
+
+#include "kconfig.h"
+#include "shell.h"
+
+#define MEMTRACE_GROUP_MAX 32
+
+struct alloc_group {
+    int type;
+    void *caller;
+    size_t size;
+    int cnt;
+};
+
+static const char *alloc_type_names[ALLOC_TYPE_CNT] = {
+    [ALLOC_KMALLOC] = "kmalloc",
+    [ALLOC_PAGE] = "page",
+    [ALLOC_HEAP] = "heap",
+};
+
+static void memtrace_print_usage(void)
+{
+    char str[PRINT_SIZE_MAX];
+
+    int kmalloc_used = minfo(KMALLOC_USED_SIZE);
+    int kmalloc_peak = minfo(KMALLOC_PEAK_SIZE);
+    int page_used = minfo(PAGE_TOTAL_SIZE) - minfo(PAGE_FREE_SIZE);
+    int page_peak = minfo(PAGE_PEAK_SIZE);
+    int heap_used = minfo(HEAP_TOTAL_SIZE) - minfo(HEAP_FREE_SIZE);
+    int heap_peak = minfo(HEAP_PEAK_SIZE);
+
+    shell_puts("           used    peak\n\r");
+
+    snprintf(str, PRINT_SIZE_MAX, "kmalloc: %7d %7d\n\r", kmalloc_used,
+             kmalloc_peak);
+    shell_puts(str);
+
+    snprintf(str, PRINT_SIZE_MAX, "page:    %7d %7d\n\r", page_used,
+             page_peak);
+    shell_puts(str);
+
+    snprintf(str, PRINT_SIZE_MAX, "heap:    %7d %7d\n\r", heap_used,
+             heap_peak);
+    shell_puts(str);
+}
+
+#if (USE_ALLOC_TRACE != 0)
+static void memtrace_print_records(void)
+{
+    char str[PRINT_SIZE_MAX];
+    struct alloc_stat info;
+    void *next = NULL;
+
+    shell_puts("\n\rTYPE      TID  CALLER        SIZE\n\r");
+
+    while ((next = alloc_trace_info(&info, next)) != NULL) {
+        snprintf(str, PRINT_SIZE_MAX, "%-8s %4d  %p %7u\n\r",
+                 alloc_type_names[info.type], info.tid, info.caller,
+                 info.size);
+        shell_puts(str);
+    }
+}
+
+static void memtrace_print_groups(void)
+{
+    char str[PRINT_SIZE_MAX];
+    struct alloc_group groups[MEMTRACE_GROUP_MAX];
+    struct alloc_group others = {0};
+    struct alloc_stat info;
+    void *next = NULL;
+    int group_cnt = 0;
+
+    /* Group the live allocations by the type and the call site */
+    while ((next = alloc_trace_info(&info, next)) != NULL) {
+        int i;
+        for (i = 0; i < group_cnt; i++) {
+            if (groups[i].type == info.type && groups[i].caller == info.caller)
+                break;
+        }
+
+        /* Create a new group */
+        if (i == group_cnt && group_cnt < MEMTRACE_GROUP_MAX) {
+            groups[i].type = info.type;
+            groups[i].caller = info.caller;
+            groups[i].size = 0;
+            groups[i].cnt = 0;
+            group_cnt++;
+        }
+
+        /* Accumulate to the group, or to the others if no space left */
+        struct alloc_group *group = (i < group_cnt) ? &groups[i] : &others;
+        group->size += info.size;
+        group->cnt++;
+    }
+
+    shell_puts("\n\rTYPE     CALLER        COUNT    SIZE\n\r");
+
+    for (int i = 0; i < group_cnt; i++) {
+        snprintf(str, PRINT_SIZE_MAX, "%-8s %p %5d %7u\n\r",
+                 alloc_type_names[groups[i].type], groups[i].caller,
+                 groups[i].cnt, groups[i].size);
+        shell_puts(str);
+    }
+
+    if (others.cnt) {
+        snprintf(str, PRINT_SIZE_MAX, "%-8s %-10s %5d %7u\n\r", "-", "others",
+                 others.cnt, others.size);
+        shell_puts(str);
+    }
+}
+
+#endif
+
+int memtrace(int argc, char *argv[])
+{
+    /* Print the usage and the peak of each allocator */
+    memtrace_print_usage();
+
+#if (USE_ALLOC_TRACE != 0)
+    /* Print the live allocations */
+    if (argc > 1 && strcmp(argv[1], "-a") == 0) {
+        memtrace_print_records();
+    } else {
+        memtrace_print_groups();
+    }
+
+    int dropped = minfo(ALLOC_TRACE_DROPPED);
+    if (dropped) {
+        char str[PRINT_SIZE_MAX];
+        snprintf(str, PRINT_SIZE_MAX,
+                 "%d allocations are not traced (ALLOC_TRACE_MAX=%d)\n\r",
+                 dropped, ALLOC_TRACE_MAX);
+        shell_puts(str);
+    }
+#else
+    shell_puts("\n\rallocation tracing is disabled (USE_ALLOC_TRACE=0)\n\r");
+#endif
+
+    return 0;
+}
+
+HOOK_SHELL_CMD("memtrace", memtrace);
@@ -22,7 +22,7 @@ static void ps_print(void)
     struct thread_stat info;
     void *next = NULL;
 
-    shell_puts("PID\tPR\tSTAT\tSTACK\%\t  COMMAND\n\r");
+    shell_puts("PID\tPR\tSTAT\tSTACK\%\tPEAK\%\t  COMMAND\n\r");
 
     do {
         next = thread_info(&info, next);
@@ -30,12 +30,17 @@ static void ps_print(void)
         char s_stack_usage[10] = {0};
         stack_usage(s_stack_usage, 10, info.stack_usage, info.stack_size);
 
+        char s_stack_peak[10] = {0};
+        stack_usage(s_stack_peak, 10, info.stack_peak, info.stack_size);
+
         if (info.kernel_thread) {
-            snprintf(s, 100, "%d\t%d\t%s\t%s\t  [%s]\n\r", info.pid,
-                     info.priority, info.status, s_stack_usage, info.name);
+            snprintf(s, 100, "%d\t%d\t%s\t%s\t%s\t  [%s]\n\r", info.pid,
+                     info.priority, info.status, s_stack_usage, s_stack_peak,
+                     info.name);
         } else {
-            snprintf(s, 100, "%d\t%d\t%s\t%s\t  %s\n\r", info.pid,
-                     info.priority, info.status, s_stack_usage, info.name);
+            snprintf(s, 100, "%d\t%d\t%s\t%s\t%s\t  %s\n\r", info.pid,
+                     info.priority, info.status, s_stack_usage, s_stack_peak,
+                     info.name);
         }
 
         shell_puts(s);
@@ -2,6 +2,7 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/sendfile.h>
 #include <unistd.h>
 
 #include <common/list.h>
@@ -33,6 +34,11 @@ void shell_puts(char *s)
     write(serial_fd, s, strlen(s));
 }
 
+ssize_t shell_sendfile(int fd, size_t count)
+{
+    return sendfile(serial_fd, fd, NULL, count);
+}
+
 static void shell_ctrl_c_handler(struct shell *shell)
 {
     shell_reset_autocomplete(shell);
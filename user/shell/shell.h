@@ -2,7 +2,9 @@
 #define __SHELL_H__
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <sys/limits.h>
+#include <sys/types.h>
 
 #include <common/list.h>
 
@@ -111,6 +113,7 @@ struct shell_cmd {
 void shell_serial_init(void);
 char shell_getc(void);
 void shell_puts(char *s);
+ssize_t shell_sendfile(int fd, size_t count);
 void shell_cls(void);
 
 /* Shell functions */
@@ -11,6 +11,8 @@ SRC += $(PROJ_ROOT)/user/shell/clear.c
 SRC += $(PROJ_ROOT)/user/shell/file.c
 SRC += $(PROJ_ROOT)/user/shell/history.c
 SRC += $(PROJ_ROOT)/user/shell/free.c
+SRC += $(PROJ_ROOT)/user/shell/dmesg.c
+SRC += $(PROJ_ROOT)/user/shell/memtrace.c
 SRC += $(PROJ_ROOT)/user/shell/pwd.c
 SRC += $(PROJ_ROOT)/user/shell/cd.c
 SRC += $(PROJ_ROOT)/user/shell/echo.c
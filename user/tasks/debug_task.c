@@ -47,4 +47,4 @@ void debug_link_task(void)
     }
 }
 
-HOOK_USER_TASK(debug_link_task, 3, 1024);
+HOOK_USER_TASK(debug_link_task, 3, STACK_SIZE_MIN);
@@ -39,16 +39,18 @@ void mavlink_out_task(void)
     if (fd < 0)
         exit(0);
 
-    mavlink_message_t recvd_msg;
+    mavlink_message_t *recvd_msg;
 
     while (1) {
         mavlink_send_heartbeat(fd);
         mavlink_send_hil_actuator_controls(fd);
 
-        /* Trigger command parser if received new message from the queue */
-        if (mq_receive(mqdes_recvd_msg, (char *) &recvd_msg, sizeof(recvd_msg),
-                       0) == sizeof(recvd_msg)) {
-            parse_mavlink_msg(&recvd_msg);
+        /* Trigger command parser if received new message from the queue.
+         * The message is parsed in place and then returned to the queue */
+        if (mq_borrow(mqdes_recvd_msg, (void **) &recvd_msg, 0) ==
+            sizeof(*recvd_msg)) {
+            parse_mavlink_msg(recvd_msg);
+            mq_release(mqdes_recvd_msg, recvd_msg);
         }
 
         sleep(200); /* 5Hz */
@@ -65,16 +67,26 @@ void mavlink_in_task(void)
 
     uint8_t c;
     mavlink_status_t status;
-    mavlink_message_t recvd_msg;
+    mavlink_message_t dropped_msg;
+    mavlink_message_t *recvd_msg = NULL;
 
     while (1) {
         /* Read byte */
         c = read(fd, &c, 1);
 
-        /* Attempt to parse the message */
-        if (mavlink_parse_char(MAVLINK_COMM_1, c, &recvd_msg, &status) == 1) {
+        /* Reserve a message slot from the queue so the parser can write
+         * the message into it directly */
+        if (!recvd_msg && mq_reserve(mqdes_recvd_msg, (void **) &recvd_msg))
+            recvd_msg = NULL;
+
+        /* Attempt to parse the message. The message is dropped if the queue
+         * is full */
+        mavlink_message_t *msg = recvd_msg ? recvd_msg : &dropped_msg;
+        if (mavlink_parse_char(MAVLINK_COMM_1, c, msg, &status) == 1 &&
+            recvd_msg) {
             /* Put the received message into the queue */
-            mq_send(mqdes_recvd_msg, (char *) &recvd_msg, sizeof(recvd_msg), 0);
+            mq_commit(mqdes_recvd_msg, recvd_msg, sizeof(*recvd_msg), 0);
+            recvd_msg = NULL;
         }
     }
 }